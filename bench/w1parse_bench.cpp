@@ -0,0 +1,146 @@
+// ============================================================================
+// w1_slave read path microbenchmark
+// ============================================================================
+// Compares the original ifstream/getline/stof sensor read against the
+// persistent-descriptor pread/from_chars path used by TemperatureSampler,
+// on w1_slave payloads recorded from DS18B20 probes.
+//
+// Usage: w1parse_bench [iterations]
+
+#include "w1reader.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+// Payloads recorded from /sys/bus/w1/devices/28-*/w1_slave.
+const char *const payloads[] = {
+    "72 01 4b 46 7f ff 0e 10 57 : crc=57 YES\n72 01 4b 46 7f ff 0e 10 57 t=23125\n",
+    "5e 01 4b 46 7f ff 02 10 d9 : crc=d9 YES\n5e 01 4b 46 7f ff 02 10 d9 t=21875\n",
+    "f8 ff 4b 46 7f ff 08 10 3c : crc=3c YES\nf8 ff 4b 46 7f ff 08 10 3c t=-500\n",
+    "50 05 4b 46 7f ff 0c 10 1c : crc=1c YES\n50 05 4b 46 7f ff 0c 10 1c t=85000\n",
+    "ff ff ff ff ff ff ff ff ff : crc=c9 NO\nff ff ff ff ff ff ff ff ff t=-62\n",
+};
+
+/**
+ * @brief The read path as originally written in updateTemperatureReadings().
+ */
+SensorReadStatus legacyRead(const std::string &path, double &value)
+{
+    std::ifstream sensorFile(path);
+    if (!sensorFile.is_open())
+    {
+        return SensorReadStatus::OPEN_FAILED;
+    }
+
+    std::string line;
+    std::getline(sensorFile, line);
+    if (line.find("YES") == std::string::npos)
+    {
+        return SensorReadStatus::CRC_FAILED;
+    }
+
+    std::getline(sensorFile, line);
+    size_t pos = line.find("t=");
+    if (pos == std::string::npos)
+    {
+        return SensorReadStatus::PARSE_FAILED;
+    }
+
+    value = std::stof(line.substr(pos + 2)) / 1000;
+    return SensorReadStatus::OK;
+}
+
+/**
+ * @brief The read path used by TemperatureSampler.
+ */
+SensorReadStatus persistentRead(W1Attribute &attribute, double &value)
+{
+    char buffer[128];
+    long count = attribute.read(buffer, sizeof(buffer));
+    if (count < 0)
+    {
+        return SensorReadStatus::OPEN_FAILED;
+    }
+    return parseW1Slave(buffer, static_cast<size_t>(count), value);
+}
+
+template <typename Fn>
+double nanosecondsPerRead(size_t iterations, size_t files, Fn read)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        read(i % files);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    const size_t files = sizeof(payloads) / sizeof(payloads[0]);
+
+    // Write each payload to a scratch file standing in for w1_slave.
+    char directory[] = "/tmp/w1parse_bench.XXXXXX";
+    if (mkdtemp(directory) == nullptr)
+    {
+        std::perror("mkdtemp");
+        return 1;
+    }
+
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < files; ++i)
+    {
+        paths.push_back(std::string(directory) + "/w1_slave." + std::to_string(i));
+        std::ofstream(paths.back()) << payloads[i];
+    }
+
+    std::vector<W1Attribute> attributes(files);
+    for (size_t i = 0; i < files; ++i)
+    {
+        attributes[i].open(paths[i]);
+    }
+
+    // Check that both paths agree before timing them.
+    for (size_t i = 0; i < files; ++i)
+    {
+        double legacyValue = 0, persistentValue = 0;
+        SensorReadStatus legacyStatus = legacyRead(paths[i], legacyValue);
+        SensorReadStatus persistentStatus = persistentRead(attributes[i], persistentValue);
+        if (legacyStatus != persistentStatus ||
+            (legacyStatus == SensorReadStatus::OK && legacyValue != persistentValue))
+        {
+            std::fprintf(stderr, "Mismatch on payload %zu\n", i);
+            return 1;
+        }
+    }
+
+    volatile double sink = 0;
+    double legacy = nanosecondsPerRead(iterations, files, [&](size_t i)
+                                       { double v = 0; legacyRead(paths[i], v); sink = v; });
+    double persistent = nanosecondsPerRead(iterations, files, [&](size_t i)
+                                           { double v = 0; persistentRead(attributes[i], v); sink = v; });
+    double parseOnly = nanosecondsPerRead(iterations, files, [&](size_t i)
+                                          { double v = 0; parseW1Slave(payloads[i], std::char_traits<char>::length(payloads[i]), v); sink = v; });
+
+    std::printf("iterations:            %zu\n", iterations);
+    std::printf("ifstream + stof:       %8.1f ns/read\n", legacy);
+    std::printf("pread + from_chars:    %8.1f ns/read\n", persistent);
+    std::printf("from_chars parse only: %8.1f ns/read\n", parseOnly);
+
+    attributes.clear();
+    for (const std::string &path : paths)
+    {
+        unlink(path.c_str());
+    }
+    rmdir(directory);
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include "channeltable.h"
+#include <algorithm>
+#include <set>
+#include <sstream>
+
+namespace
+{
+/**
+ * @brief Removes leading and trailing whitespace.
+ */
+std::string trim(const std::string &text)
+{
+    size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos)
+    {
+        return std::string();
+    }
+    size_t last = text.find_last_not_of(" \t\r\n");
+    return text.substr(first, last - first + 1);
+}
+
+/**
+ * @brief Splits text at a separator, trimming every field.
+ */
+std::vector<std::string> split(const std::string &text, char separator)
+{
+    std::vector<std::string> fields;
+    std::istringstream stream(text);
+    std::string field;
+    while (std::getline(stream, field, separator))
+    {
+        fields.push_back(trim(field));
+    }
+    return fields;
+}
+
+/**
+ * @brief Parses a number between min and max.
+ */
+bool parseNumber(const std::string &value, double min, double max, double &target)
+{
+    std::istringstream stream(value);
+    double number;
+    if (!(stream >> number) || !stream.eof() || number < min || number > max)
+    {
+        return false;
+    }
+    target = number;
+    return true;
+}
+
+/**
+ * @brief Checks that a name is usable as an INDI property name.
+ */
+bool validName(const std::string &name)
+{
+    return !name.empty() && std::all_of(name.begin(), name.end(), [](char c)
+                                        { return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_'; });
+}
+
+/**
+ * @brief Parses one channel.
+ */
+bool parseChannel(const std::vector<std::string> &fields, ChannelConfig &channel, std::string &error)
+{
+    enum
+    {
+        FIELD_NAME,
+        FIELD_KIND,
+        FIELD_PIN,
+        FIELD_DEFAULT,
+        FIELD_LABEL,
+        FIELD_FREQUENCY,
+        FIELD_N
+    };
+
+    if (fields.size() < FIELD_LABEL + 1 || fields.size() > FIELD_N)
+    {
+        error = "expected name, kind, pin, default, label[, frequency]";
+        return false;
+    }
+
+    channel.name = fields[FIELD_NAME];
+    if (!validName(channel.name))
+    {
+        error = "invalid name '" + channel.name + "'";
+        return false;
+    }
+
+    if (fields[FIELD_KIND] == "switch")
+    {
+        channel.kind = ChannelKind::SWITCH;
+    }
+    else if (fields[FIELD_KIND] == "pwm")
+    {
+        channel.kind = ChannelKind::PWM;
+    }
+    else
+    {
+        error = "invalid kind '" + fields[FIELD_KIND] + "'";
+        return false;
+    }
+
+    // Switched outputs are driven through bank 1, GPIO 0 to 31.
+    double pin;
+    if (!parseNumber(fields[FIELD_PIN], 0, 31, pin) || pin != static_cast<int>(pin))
+    {
+        error = "invalid pin '" + fields[FIELD_PIN] + "'";
+        return false;
+    }
+    channel.pin = static_cast<int>(pin);
+
+    const std::string &value = fields[FIELD_DEFAULT];
+    bool valid = true;
+    if (channel.kind == ChannelKind::SWITCH)
+    {
+        valid = value == "on" || value == "off";
+        channel.defaultLevel = value == "on";
+    }
+    else
+    {
+        valid = parseNumber(value, 0, 100, channel.defaultDutyCycle);
+    }
+    if (!valid)
+    {
+        error = "invalid default '" + value + "'";
+        return false;
+    }
+
+    channel.label = fields[FIELD_LABEL].empty() ? channel.name : fields[FIELD_LABEL];
+
+    if (fields.size() > FIELD_FREQUENCY)
+    {
+        double frequency;
+        if (channel.kind != ChannelKind::PWM || !parseNumber(fields[FIELD_FREQUENCY], 10, 30000, frequency))
+        {
+            error = "invalid frequency '" + fields[FIELD_FREQUENCY] + "'";
+            return false;
+        }
+        channel.frequency = static_cast<unsigned>(frequency);
+    }
+    return true;
+}
+}
+
+bool parseChannelTable(const std::string &text, std::vector<ChannelConfig> &channels, std::string &error)
+{
+    channels.clear();
+
+    std::set<std::string> names;
+    std::set<int> pins;
+    for (const std::string &entry : split(text, ';'))
+    {
+        if (entry.empty())
+        {
+            continue;
+        }
+
+        ChannelConfig channel;
+        if (!parseChannel(split(entry, ','), channel, error))
+        {
+            error = "channel '" + entry + "': " + error;
+            return false;
+        }
+        if (!names.insert(channel.name).second)
+        {
+            error = "duplicate channel name " + channel.name;
+            return false;
+        }
+        if (!pins.insert(channel.pin).second)
+        {
+            error = "GPIO " + std::to_string(channel.pin) + " used by more than one channel";
+            return false;
+        }
+        channels.push_back(channel);
+    }
+    return true;
+}
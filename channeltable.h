@@ -0,0 +1,57 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include <string>
+#include <vector>
+
+// ============================================================================
+// ChannelConfig Structure
+// ============================================================================
+
+/**
+ * @brief What an output channel drives.
+ */
+enum class ChannelKind
+{
+    SWITCH, ///< A switched rail, on or off.
+    PWM,    ///< A PWM output such as a dew heater.
+};
+
+/**
+ * @brief One output of the board, as described by the channel table.
+ */
+struct ChannelConfig
+{
+    std::string name;                       ///< Property name, also used in power profiles, e.g. HEATER_0.
+    std::string label;                      ///< Property label shown by clients.
+    ChannelKind kind = ChannelKind::SWITCH; ///< Switched or PWM output.
+    int pin = -1;                           ///< BCM GPIO number, 0 to 31.
+    bool defaultLevel = false;              ///< Level a switch starts at.
+    double defaultDutyCycle = 0;            ///< Duty cycle in percent a PWM output starts at.
+    unsigned frequency = 0;                 ///< PWM carrier frequency in Hz; 0 uses the shared heater frequency.
+};
+
+/**
+ * @brief Parses a channel table.
+ *
+ * Channels are separated by semicolons. Each channel is a comma-separated
+ * list of name, kind, pin, default and label, optionally followed by a PWM
+ * frequency in Hz:
+ * - name: upper-case letters, digits and underscores, e.g. HEATER_0;
+ * - kind: switch or pwm;
+ * - pin: the BCM GPIO number, 0 to 31;
+ * - default: on|off for a switch, a duty cycle in percent for pwm;
+ * - label: shown by clients, may contain spaces;
+ * - frequency: pwm only, 10 to 30000; omitted, the shared heater frequency applies.
+ *
+ * e.g. "MAIN_POWER,switch,8,on,Main Power; HEATER_0,pwm,12,0,Heater 0".
+ * Names and pins must be unique.
+ *
+ * @param text The table.
+ * @param channels Receives the channels in table order.
+ * @param error Receives a description of the first invalid channel.
+ * @return true if the whole table is valid.
+ */
+bool parseChannelTable(const std::string &text, std::vector<ChannelConfig> &channels, std::string &error);
@@ -4,6 +4,9 @@
 /* Define INDI Data Dir */
 #cmakedefine INDI_DATA_DIR "@INDI_DATA_DIR@"
 
+/* Define if the libgpiod backend is built */
+#cmakedefine HAVE_LIBGPIOD 1
+
 /* Define Driver version */
 #define CDRIVER_VERSION_MAJOR @CDRIVER_VERSION_MAJOR@
 #define CDRIVER_VERSION_MINOR @CDRIVER_VERSION_MINOR@
@@ -0,0 +1,199 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include <cstdint>
+#include <string>
+
+// ============================================================================
+// PWM MODES
+// ============================================================================
+
+/**
+ * @brief How a PWM output is generated.
+ */
+enum class PWMMode
+{
+    HARDWARE,  ///< The SoC's PWM peripheral.
+    SOFTWARE,  ///< Timed in software, e.g. by pigpiod's DMA sampling.
+    STAGGERED, ///< One waveform for all staggered pins, their on-times interleaved (see PWMStagger).
+};
+
+// ============================================================================
+// GPIOBackend Interface
+// ============================================================================
+
+/**
+ * @brief Hardware access used by RPiPowerBox for its switched and PWM outputs.
+ *
+ * Pins are BCM GPIO numbers and duty cycles are percentages. Every call
+ * returns false on failure; lastError() then describes the cause.
+ *
+ * A backend has one user thread at a time; only cutPWM() may be called
+ * from another thread.
+ */
+class GPIOBackend
+{
+public:
+    virtual ~GPIOBackend() = default;
+
+    /**
+     * @brief Returns a short name for logging.
+     */
+    virtual const char *name() const = 0;
+
+    /**
+     * @brief Acquires the hardware.
+     * @return true if successful, false otherwise.
+     */
+    virtual bool open() = 0;
+
+    /**
+     * @brief Releases the hardware. Outputs keep their last state.
+     */
+    virtual void close() = 0;
+
+    /**
+     * @brief Returns a one-line description of the hardware for logging.
+     */
+    virtual std::string describe() = 0;
+
+    /**
+     * @brief Returns a description of the last failure.
+     */
+    virtual std::string lastError() const = 0;
+
+    /**
+     * @brief Checks with one cheap round-trip that the hardware still answers.
+     *
+     * The default has nothing to check.
+     *
+     * @return true if successful, false otherwise.
+     */
+    virtual bool ping()
+    {
+        return true;
+    }
+
+    /**
+     * @brief Returns whether the last failure lost the connection to the hardware.
+     *
+     * Such a failure only clears by closing and reopening the backend, after
+     * which the outputs have to be set up again; see SupervisedBackend.
+     */
+    virtual bool connectionLost() const
+    {
+        return false;
+    }
+
+    /**
+     * @brief Configures a pin as a switched output.
+     *
+     * The level is latched before the pin turns into an output, so a pin
+     * that already drives this level does not glitch.
+     *
+     * @param pin The GPIO pin.
+     * @param level The level to drive.
+     * @return true if successful, false otherwise.
+     */
+    virtual bool setupOutput(int pin, bool level) = 0;
+
+    /**
+     * @brief Drives a switched output.
+     *
+     * @param pin The GPIO pin, set up with setupOutput().
+     * @param level The level to drive.
+     * @return true if successful, false otherwise.
+     */
+    virtual bool write(int pin, bool level) = 0;
+
+    /**
+     * @brief Drives several switched outputs among GPIO 0 to 31 at once.
+     *
+     * Break before make: pins driven low change before pins driven high,
+     * so rails going off never overlap the inrush of rails coming on. The
+     * pigpiod backend makes two ordered register writes, each latching its
+     * whole mask; the default writes the pins one by one.
+     *
+     * @param setMask Pins to drive high, one bit per GPIO.
+     * @param clearMask Pins to drive low, one bit per GPIO.
+     * @return true if successful, false otherwise.
+     */
+    virtual bool writeBank(uint32_t setMask, uint32_t clearMask)
+    {
+        for (int pin = 0; pin < 32; ++pin)
+        {
+            if ((clearMask & (uint32_t(1) << pin)) != 0 && !write(pin, false))
+            {
+                return false;
+            }
+        }
+        for (int pin = 0; pin < 32; ++pin)
+        {
+            if ((setMask & (uint32_t(1) << pin)) != 0 && !write(pin, true))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Reads back whether a pin currently drives its output on.
+     *
+     * A switched output is on while it drives high, a PWM output while its
+     * duty cycle is above zero; a pin that is not an output is off. This
+     * tells outputs that survived a driver restart from those still off.
+     * The default cannot tell.
+     *
+     * @param pin The GPIO pin; it need not be set up.
+     * @param on Receives whether the output is on.
+     * @return true if the state was read, false if it is unknown.
+     */
+    virtual bool readOutput(int, bool &)
+    {
+        return false;
+    }
+
+    /**
+     * @brief Returns whether a PWM mode is available on a pin.
+     */
+    virtual bool supportsPWM(int pin, PWMMode mode) const = 0;
+
+    /**
+     * @brief Configures a pin as a PWM output.
+     *
+     * A pin that already runs PWM at this frequency moves to the new duty
+     * cycle without restarting.
+     *
+     * @param pin The GPIO pin.
+     * @param frequency The carrier frequency in Hz.
+     * @param mode How the PWM signal is generated.
+     * @param dutyCycle The duty cycle in percent to start at, 0 to 100.
+     * @return true if successful, false otherwise.
+     */
+    virtual bool setupPWM(int pin, unsigned frequency, PWMMode mode, double dutyCycle) = 0;
+
+    /**
+     * @brief Sets the duty cycle of a PWM output.
+     *
+     * @param pin The GPIO pin, set up with setupPWM().
+     * @param dutyCycle The duty cycle in percent, 0 to 100.
+     * @return true if successful, false otherwise.
+     */
+    virtual bool writePWM(int pin, double dutyCycle) = 0;
+
+    /**
+     * @brief Turns a PWM output off at once, from any thread.
+     *
+     * Runs concurrently with the thread using the backend, so a safety
+     * watchdog need not wait for queued commands. It does not set
+     * lastError(), and a later writePWM() may turn the pin on again; see
+     * InterlockBackend for a latch.
+     *
+     * @param pin The GPIO pin, set up with setupPWM().
+     * @return true if successful, false otherwise.
+     */
+    virtual bool cutPWM(int pin) = 0;
+};
@@ -0,0 +1,102 @@
+#include "gpiocommandqueue.h"
+
+constexpr const char *GPIOCommandQueue::superseded;
+
+GPIOCommandQueue::GPIOCommandQueue(MainLoopDispatcher &dispatcher)
+    : dispatcher(dispatcher)
+{
+}
+
+GPIOCommandQueue::~GPIOCommandQueue()
+{
+    stop();
+}
+
+void GPIOCommandQueue::start(GPIOBackend *newBackend)
+{
+    stop();
+
+    // Drop commands submitted while no backend was attached.
+    backend = newBackend;
+    queue.clear();
+    stopRequested = false;
+    thread = std::thread(&GPIOCommandQueue::run, this);
+}
+
+void GPIOCommandQueue::stop()
+{
+    if (!thread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    wakeup.notify_all();
+    thread.join();
+    backend = nullptr;
+}
+
+void GPIOCommandQueue::submit(int key, Operation operation, Completion completion)
+{
+    Completion replaced;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Coalesce with a pending command for the same output.
+        for (auto it = queue.begin(); it != queue.end(); ++it)
+        {
+            if (it->key == key)
+            {
+                replaced = std::move(it->completion);
+                queue.erase(it);
+                break;
+            }
+        }
+        queue.push_back({key, std::move(operation), std::move(completion), std::chrono::steady_clock::now()});
+    }
+    wakeup.notify_one();
+
+    // Its submitter may be waiting for it, e.g. with outputs left Busy.
+    if (replaced)
+    {
+        dispatcher.post([completion = std::move(replaced)]
+                        { completion(false, superseded); });
+    }
+}
+
+void GPIOCommandQueue::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        wakeup.wait(lock, [this]
+                    { return stopRequested || !queue.empty(); });
+
+        // Drain what is left before exiting.
+        if (queue.empty())
+        {
+            return;
+        }
+
+        Command command = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+
+        bool ok = command.operation(*backend);
+        std::string error = ok ? std::string() : backend->lastError();
+        if (LatencyHistogram *histogram = latency)
+        {
+            histogram->record(std::chrono::steady_clock::now() - command.submitted);
+        }
+        if (command.completion)
+        {
+            dispatcher.post([completion = std::move(command.completion), ok, error]
+                            { completion(ok, error); });
+        }
+
+        lock.lock();
+    }
+}
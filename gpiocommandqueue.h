@@ -0,0 +1,111 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include "gpiobackend.h"
+#include "latencyhistogram.h"
+#include "mainloopdispatcher.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// ============================================================================
+// GPIOCommandQueue Class
+// ============================================================================
+
+/**
+ * @brief Executes GPIO commands on a worker thread, off the INDI event loop.
+ *
+ * Every command carries a key naming the output it targets. A command
+ * submitted while another one with the same key is still pending replaces
+ * it and moves to the back of the queue, so a burst of updates to one
+ * output collapses into its latest value while commands to different
+ * outputs keep their submission order.
+ *
+ * Completions run on the event loop through a MainLoopDispatcher. A
+ * replaced command is never executed; its completion receives false and
+ * the error superseded.
+ */
+class GPIOCommandQueue
+{
+public:
+    /// Performs a command against the backend; returns true on success.
+    using Operation = std::function<bool(GPIOBackend &)>;
+    /// Receives the outcome of a command on the event loop.
+    using Completion = std::function<void(bool ok, const std::string &error)>;
+
+    /// Error reported to the completion of a command replaced before it ran.
+    static constexpr const char *superseded = "superseded";
+
+    /**
+     * @param dispatcher Runs completions on the event loop.
+     */
+    explicit GPIOCommandQueue(MainLoopDispatcher &dispatcher);
+    ~GPIOCommandQueue();
+
+    GPIOCommandQueue(const GPIOCommandQueue &) = delete;
+    GPIOCommandQueue &operator=(const GPIOCommandQueue &) = delete;
+
+    /**
+     * @brief Starts the worker thread.
+     *
+     * @param backend The backend; the worker is its only user until stop().
+     */
+    void start(GPIOBackend *backend);
+
+    /**
+     * @brief Executes the remaining commands and stops the worker thread.
+     */
+    void stop();
+
+    /**
+     * @brief Queues a command.
+     *
+     * @param key Identifies the output; pending commands with the same key are replaced and completed as superseded.
+     * @param operation The command.
+     * @param completion Called on the event loop with the outcome; may be empty.
+     */
+    void submit(int key, Operation operation, Completion completion = Completion());
+
+    /**
+     * @brief Records the time from submit() to the end of each command into a histogram.
+     *
+     * @param histogram The histogram, or null to stop recording. Must outlive the queue.
+     */
+    void setLatencyHistogram(LatencyHistogram *histogram)
+    {
+        latency = histogram;
+    }
+
+private:
+    /**
+     * @brief A queued command.
+     */
+    struct Command
+    {
+        int key;
+        Operation operation;
+        Completion completion;
+        std::chrono::steady_clock::time_point submitted;
+    };
+
+    /**
+     * @brief Worker thread main loop.
+     */
+    void run();
+
+    MainLoopDispatcher &dispatcher;  ///< Runs completions on the event loop.
+    GPIOBackend *backend = nullptr;  ///< Backend used by the worker.
+    std::thread thread;              ///< Worker thread.
+    std::mutex mutex;                ///< Guards queue and stopRequested.
+    std::condition_variable wakeup;  ///< Signals new commands.
+    std::list<Command> queue;        ///< Pending commands, oldest first.
+    bool stopRequested = false;      ///< Set to ask the worker to exit.
+    std::atomic<LatencyHistogram *> latency{nullptr}; ///< Receives the command latencies, may be null.
+};
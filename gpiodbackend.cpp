@@ -0,0 +1,272 @@
+#include "gpiodbackend.h"
+#include <gpiod.h>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace
+{
+// Consumer label shown by gpioinfo for the lines we hold.
+const char *const CONSUMER = "indi_rpi_pb";
+
+/**
+ * @brief Writes a value to a sysfs attribute.
+ */
+bool writeAttribute(const std::string &path, const std::string &value)
+{
+    std::ofstream attribute(path);
+    attribute << value;
+    attribute.flush();
+    return attribute.good();
+}
+
+/**
+ * @brief Reads a numeric sysfs attribute.
+ */
+bool readAttribute(const std::string &path, unsigned long &value)
+{
+    std::ifstream attribute(path);
+    return static_cast<bool>(attribute >> value);
+}
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+GpiodBackend::GpiodBackend(const std::string &chipName, const std::string &pwmChipPath)
+    : chipName(chipName), pwmChipPath(pwmChipPath)
+{
+}
+
+GpiodBackend::~GpiodBackend()
+{
+    close();
+}
+
+bool GpiodBackend::open()
+{
+    chip = gpiod_chip_open_lookup(chipName.c_str());
+    if (chip == nullptr)
+    {
+        return fail("open " + chipName);
+    }
+    return true;
+}
+
+void GpiodBackend::close()
+{
+    // Released lines and exported PWM channels keep their last state.
+    channels.clear();
+    for (auto &entry : lines)
+    {
+        gpiod_line_release(entry.second);
+    }
+    lines.clear();
+
+    if (chip != nullptr)
+    {
+        gpiod_chip_close(chip);
+        chip = nullptr;
+    }
+}
+
+std::string GpiodBackend::describe()
+{
+    return std::string(gpiod_chip_name(chip)) + " [" + gpiod_chip_label(chip) + "], " +
+           std::to_string(gpiod_chip_num_lines(chip)) + " lines, PWM on " + pwmChipPath;
+}
+
+std::string GpiodBackend::lastError() const
+{
+    return error;
+}
+
+bool GpiodBackend::fail(const std::string &what)
+{
+    error = what + ": " + std::strerror(errno);
+    return false;
+}
+
+// ============================================================================
+// Switched Outputs
+// ============================================================================
+
+bool GpiodBackend::setupOutput(int pin, bool level)
+{
+    gpiod_line *line = gpiod_chip_get_line(chip, pin);
+    if (line == nullptr)
+    {
+        return fail("get line " + std::to_string(pin));
+    }
+
+    // The kernel sets the value before it switches the line to output.
+    if (gpiod_line_request_output(line, CONSUMER, level ? 1 : 0) < 0)
+    {
+        return fail("request line " + std::to_string(pin));
+    }
+    lines[pin] = line;
+    return true;
+}
+
+bool GpiodBackend::write(int pin, bool level)
+{
+    auto it = lines.find(pin);
+    if (it == lines.end())
+    {
+        errno = EINVAL;
+        return fail("write line " + std::to_string(pin));
+    }
+    if (gpiod_line_set_value(it->second, level ? 1 : 0) < 0)
+    {
+        return fail("write line " + std::to_string(pin));
+    }
+    return true;
+}
+
+bool GpiodBackend::readOutput(int pin, bool &on)
+{
+    auto it = lines.find(pin);
+    if (it != lines.end())
+    {
+        int value = gpiod_line_get_value(it->second);
+        on = value > 0;
+        return value >= 0 || fail("read line " + std::to_string(pin));
+    }
+
+    // Lines in their PWM function read as inputs, so a hardware PWM heater
+    // reads as off.
+    gpiod_line *line = gpiod_chip_get_line(chip, pin);
+    if (line == nullptr)
+    {
+        return fail("get line " + std::to_string(pin));
+    }
+    if (gpiod_line_direction(line) != GPIOD_LINE_DIRECTION_OUTPUT)
+    {
+        on = false;
+        return true;
+    }
+
+    // Taking the line as is leaves its level alone, and so does releasing it.
+    gpiod_line_request_config config = {CONSUMER, GPIOD_LINE_REQUEST_DIRECTION_AS_IS, 0};
+    if (gpiod_line_request(line, &config, 0) < 0)
+    {
+        return fail("request line " + std::to_string(pin));
+    }
+    int value = gpiod_line_get_value(line);
+    gpiod_line_release(line);
+    on = value > 0;
+    return value >= 0 || fail("read line " + std::to_string(pin));
+}
+
+// ============================================================================
+// PWM Outputs
+// ============================================================================
+
+namespace
+{
+/**
+ * @brief Maps a GPIO pin to its PWM channel, -1 if none.
+ */
+int pwmChannel(int pin)
+{
+    switch (pin)
+    {
+    case 12:
+    case 18:
+        return 0;
+    case 13:
+    case 19:
+        return 1;
+    default:
+        return -1;
+    }
+}
+}
+
+bool GpiodBackend::supportsPWM(int pin, PWMMode mode) const
+{
+    return mode == PWMMode::HARDWARE && pwmChannel(pin) >= 0;
+}
+
+bool GpiodBackend::setupPWM(int pin, unsigned frequency, PWMMode mode, double dutyCycle)
+{
+    if (!supportsPWM(pin, mode) || frequency == 0)
+    {
+        errno = EINVAL;
+        return fail("PWM on GPIO " + std::to_string(pin));
+    }
+
+    std::string channelPath = pwmChipPath + "/pwm" + std::to_string(pwmChannel(pin));
+
+    // Export the channel; udev may need a moment to fix up its permissions.
+    if (!std::ifstream(channelPath + "/enable").is_open())
+    {
+        if (!writeAttribute(pwmChipPath + "/export", std::to_string(pwmChannel(pin))))
+        {
+            return fail("export " + channelPath);
+        }
+        for (int attempt = 0; attempt < 20 && !std::ifstream(channelPath + "/enable").is_open(); ++attempt)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    PWMChannel &channel = channels[pin];
+    channel.periodNs = static_cast<unsigned long>(std::lround(1e9 / frequency));
+
+    unsigned long enabled = 0, periodNs = 0;
+    bool running = readAttribute(channelPath + "/enable", enabled) && enabled == 1 &&
+                   readAttribute(channelPath + "/period", periodNs) && periodNs == channel.periodNs;
+
+    // The duty cycle must never exceed the period, so clear it before
+    // changing the period; on a fresh channel both are still 0. A channel
+    // already running at this period only gets its new duty cycle.
+    if (!running)
+    {
+        writeAttribute(channelPath + "/duty_cycle", "0");
+        if (!writeAttribute(channelPath + "/period", std::to_string(channel.periodNs)) ||
+            !writeAttribute(channelPath + "/enable", "1"))
+        {
+            return fail("configure " + channelPath);
+        }
+    }
+
+    if (!channel.dutyCycle.open(channelPath + "/duty_cycle", true))
+    {
+        return fail("open " + channelPath + "/duty_cycle");
+    }
+    return writePWM(pin, dutyCycle);
+}
+
+bool GpiodBackend::writePWM(int pin, double dutyCycle)
+{
+    auto it = channels.find(pin);
+    if (it == channels.end())
+    {
+        errno = EINVAL;
+        return fail("PWM on GPIO " + std::to_string(pin));
+    }
+
+    // duty_cycle is the on-time in nanoseconds.
+    char text[24];
+    unsigned long onTime = static_cast<unsigned long>(std::lround(it->second.periodNs * dutyCycle / 100));
+    int length = std::snprintf(text, sizeof(text), "%lu\n", onTime);
+    if (!it->second.dutyCycle.write(text, length))
+    {
+        return fail("write PWM duty cycle on GPIO " + std::to_string(pin));
+    }
+    return true;
+}
+
+bool GpiodBackend::cutPWM(int pin)
+{
+    // Opens its own descriptor, as the channel map belongs to the user thread.
+    int channel = pwmChannel(pin);
+    return channel >= 0 &&
+           writeAttribute(pwmChipPath + "/pwm" + std::to_string(channel) + "/duty_cycle", "0");
+}
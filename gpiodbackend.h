@@ -0,0 +1,79 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include "gpiobackend.h"
+#include "w1reader.h"
+#include <map>
+
+struct gpiod_chip;
+struct gpiod_line;
+
+// ============================================================================
+// GpiodBackend Class
+// ============================================================================
+
+/**
+ * @brief In-process GPIO backend using the kernel's GPIO character device
+ * (libgpiod) for switched outputs and /sys/class/pwm for PWM outputs.
+ *
+ * No daemon is involved, so every write is a single ioctl or sysfs write.
+ * Only hardware PWM is available; GPIO 12/18 map to PWM channel 0 and
+ * GPIO 13/19 to channel 1, which requires the pwm-2chan device tree overlay.
+ * Lines are requested one by one, so bank writes set them one ioctl at a time.
+ */
+class GpiodBackend : public GPIOBackend
+{
+public:
+    /**
+     * @param chipName The GPIO chip, e.g. gpiochip0.
+     * @param pwmChipPath The sysfs PWM chip, e.g. /sys/class/pwm/pwmchip0.
+     */
+    GpiodBackend(const std::string &chipName, const std::string &pwmChipPath);
+    ~GpiodBackend() override;
+
+    const char *name() const override
+    {
+        return "gpiod";
+    }
+
+    bool open() override;
+    void close() override;
+    std::string describe() override;
+    std::string lastError() const override;
+
+    bool setupOutput(int pin, bool level) override;
+    bool write(int pin, bool level) override;
+    bool readOutput(int pin, bool &on) override;
+
+    bool supportsPWM(int pin, PWMMode mode) const override;
+    bool setupPWM(int pin, unsigned frequency, PWMMode mode, double dutyCycle) override;
+    bool writePWM(int pin, double dutyCycle) override;
+    bool cutPWM(int pin) override;
+
+private:
+    /**
+     * @brief Records a failure.
+     *
+     * @param what The operation that failed; errno supplies the cause.
+     * @return false, for use in return statements.
+     */
+    bool fail(const std::string &what);
+
+    /**
+     * @brief A PWM channel exported through sysfs.
+     */
+    struct PWMChannel
+    {
+        unsigned long periodNs = 0; ///< Carrier period in nanoseconds.
+        W1Attribute dutyCycle;      ///< duty_cycle attribute, kept open for writes.
+    };
+
+    std::string chipName;                ///< GPIO chip name.
+    std::string pwmChipPath;             ///< sysfs PWM chip directory.
+    gpiod_chip *chip = nullptr;          ///< Open GPIO chip.
+    std::map<int, gpiod_line *> lines;   ///< Requested output lines by pin.
+    std::map<int, PWMChannel> channels;  ///< Exported PWM channels by pin.
+    std::string error;                   ///< Description of the last failure.
+};
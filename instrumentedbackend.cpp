@@ -0,0 +1,86 @@
+#include "instrumentedbackend.h"
+
+InstrumentedBackend::InstrumentedBackend(std::unique_ptr<GPIOBackend> backend, LatencyHistogram &histogram)
+    : backend(std::move(backend)), histogram(histogram)
+{
+}
+
+bool InstrumentedBackend::open()
+{
+    LatencyProbe probe(&histogram);
+    return backend->open();
+}
+
+void InstrumentedBackend::close()
+{
+    LatencyProbe probe(&histogram);
+    backend->close();
+}
+
+std::string InstrumentedBackend::describe()
+{
+    return backend->describe();
+}
+
+std::string InstrumentedBackend::lastError() const
+{
+    return backend->lastError();
+}
+
+bool InstrumentedBackend::ping()
+{
+    LatencyProbe probe(&histogram);
+    return backend->ping();
+}
+
+bool InstrumentedBackend::connectionLost() const
+{
+    return backend->connectionLost();
+}
+
+bool InstrumentedBackend::setupOutput(int pin, bool level)
+{
+    LatencyProbe probe(&histogram);
+    return backend->setupOutput(pin, level);
+}
+
+bool InstrumentedBackend::write(int pin, bool level)
+{
+    LatencyProbe probe(&histogram);
+    return backend->write(pin, level);
+}
+
+bool InstrumentedBackend::writeBank(uint32_t setMask, uint32_t clearMask)
+{
+    LatencyProbe probe(&histogram);
+    return backend->writeBank(setMask, clearMask);
+}
+
+bool InstrumentedBackend::readOutput(int pin, bool &on)
+{
+    LatencyProbe probe(&histogram);
+    return backend->readOutput(pin, on);
+}
+
+bool InstrumentedBackend::supportsPWM(int pin, PWMMode mode) const
+{
+    return backend->supportsPWM(pin, mode);
+}
+
+bool InstrumentedBackend::setupPWM(int pin, unsigned frequency, PWMMode mode, double dutyCycle)
+{
+    LatencyProbe probe(&histogram);
+    return backend->setupPWM(pin, frequency, mode, dutyCycle);
+}
+
+bool InstrumentedBackend::writePWM(int pin, double dutyCycle)
+{
+    LatencyProbe probe(&histogram);
+    return backend->writePWM(pin, dutyCycle);
+}
+
+bool InstrumentedBackend::cutPWM(int pin)
+{
+    LatencyProbe probe(&histogram);
+    return backend->cutPWM(pin);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include "gpiobackend.h"
+#include "latencyhistogram.h"
+#include <memory>
+
+// ============================================================================
+// InstrumentedBackend Class
+// ============================================================================
+
+/**
+ * @brief Forwards to another GPIO backend and times every hardware call.
+ *
+ * Calls that reach the hardware (open, ping, setup, write, PWM) are recorded
+ * into a latency histogram; name(), lastError(), connectionLost() and
+ * supportsPWM() are not.
+ */
+class InstrumentedBackend : public GPIOBackend
+{
+public:
+    /**
+     * @param backend The backend doing the work.
+     * @param histogram Receives the duration of every hardware call; must outlive this backend.
+     */
+    InstrumentedBackend(std::unique_ptr<GPIOBackend> backend, LatencyHistogram &histogram);
+
+    const char *name() const override
+    {
+        return backend->name();
+    }
+
+    bool open() override;
+    void close() override;
+    std::string describe() override;
+    std::string lastError() const override;
+    bool ping() override;
+    bool connectionLost() const override;
+
+    bool setupOutput(int pin, bool level) override;
+    bool write(int pin, bool level) override;
+    bool writeBank(uint32_t setMask, uint32_t clearMask) override;
+    bool readOutput(int pin, bool &on) override;
+
+    bool supportsPWM(int pin, PWMMode mode) const override;
+    bool setupPWM(int pin, unsigned frequency, PWMMode mode, double dutyCycle) override;
+    bool writePWM(int pin, double dutyCycle) override;
+    bool cutPWM(int pin) override;
+
+private:
+    std::unique_ptr<GPIOBackend> backend; ///< The backend doing the work.
+    LatencyHistogram &histogram;          ///< Receives the call durations.
+};
@@ -0,0 +1,102 @@
+#include "interlockbackend.h"
+
+InterlockBackend::InterlockBackend(std::unique_ptr<GPIOBackend> backend)
+    : backend(std::move(backend))
+{
+}
+
+bool InterlockBackend::open()
+{
+    return backend->open();
+}
+
+void InterlockBackend::close()
+{
+    backend->close();
+}
+
+std::string InterlockBackend::describe()
+{
+    return backend->describe();
+}
+
+std::string InterlockBackend::lastError() const
+{
+    return backend->lastError();
+}
+
+bool InterlockBackend::ping()
+{
+    return backend->ping();
+}
+
+bool InterlockBackend::connectionLost() const
+{
+    return backend->connectionLost();
+}
+
+bool InterlockBackend::setupOutput(int pin, bool level)
+{
+    return backend->setupOutput(pin, level);
+}
+
+bool InterlockBackend::write(int pin, bool level)
+{
+    return backend->write(pin, level);
+}
+
+bool InterlockBackend::writeBank(uint32_t setMask, uint32_t clearMask)
+{
+    return backend->writeBank(setMask, clearMask);
+}
+
+bool InterlockBackend::readOutput(int pin, bool &on)
+{
+    return backend->readOutput(pin, on);
+}
+
+bool InterlockBackend::supportsPWM(int pin, PWMMode mode) const
+{
+    return backend->supportsPWM(pin, mode);
+}
+
+bool InterlockBackend::setupPWM(int pin, unsigned frequency, PWMMode mode, double dutyCycle)
+{
+    bool wasTripped = tripped(pin);
+    bool rv = backend->setupPWM(pin, frequency, mode, wasTripped ? 0 : dutyCycle);
+
+    // The pin tripped while this write was under way; cut it again after it.
+    if (!wasTripped && tripped(pin))
+    {
+        backend->cutPWM(pin);
+    }
+    return rv;
+}
+
+bool InterlockBackend::writePWM(int pin, double dutyCycle)
+{
+    bool wasTripped = tripped(pin);
+    bool rv = backend->writePWM(pin, wasTripped ? 0 : dutyCycle);
+    if (!wasTripped && tripped(pin))
+    {
+        backend->cutPWM(pin);
+    }
+    return rv;
+}
+
+bool InterlockBackend::cutPWM(int pin)
+{
+    return backend->cutPWM(pin);
+}
+
+bool InterlockBackend::trip(int pin)
+{
+    // Latch first, so that a write starting now sees it.
+    latched |= bit(pin);
+    return backend->cutPWM(pin);
+}
+
+void InterlockBackend::release(int pin)
+{
+    latched &= ~bit(pin);
+}
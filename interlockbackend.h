@@ -0,0 +1,86 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include "gpiobackend.h"
+#include <atomic>
+#include <memory>
+
+// ============================================================================
+// InterlockBackend Class
+// ============================================================================
+
+/**
+ * @brief Forwards to another GPIO backend and keeps tripped PWM outputs off.
+ *
+ * trip() may be called from any thread: it latches the pin and cuts it
+ * through GPIOBackend::cutPWM(). Until release(), every PWM write to a
+ * latched pin is turned into 0%. A write that was already under way when
+ * the pin tripped is followed by another cut, so the pin ends up off
+ * whichever thread reaches the hardware last.
+ */
+class InterlockBackend : public GPIOBackend
+{
+public:
+    /**
+     * @param backend The backend doing the work.
+     */
+    explicit InterlockBackend(std::unique_ptr<GPIOBackend> backend);
+
+    const char *name() const override
+    {
+        return backend->name();
+    }
+
+    bool open() override;
+    void close() override;
+    std::string describe() override;
+    std::string lastError() const override;
+    bool ping() override;
+    bool connectionLost() const override;
+
+    bool setupOutput(int pin, bool level) override;
+    bool write(int pin, bool level) override;
+    bool writeBank(uint32_t setMask, uint32_t clearMask) override;
+    bool readOutput(int pin, bool &on) override;
+
+    bool supportsPWM(int pin, PWMMode mode) const override;
+    bool setupPWM(int pin, unsigned frequency, PWMMode mode, double dutyCycle) override;
+    bool writePWM(int pin, double dutyCycle) override;
+    bool cutPWM(int pin) override;
+
+    /**
+     * @brief Latches a PWM pin off and cuts it. Thread-safe.
+     *
+     * @return true if the cut reached the hardware.
+     */
+    bool trip(int pin);
+
+    /**
+     * @brief Lets writes reach a tripped pin again. Thread-safe.
+     *
+     * The pin stays at 0% until the next write.
+     */
+    void release(int pin);
+
+    /**
+     * @brief Returns whether a pin is latched off. Thread-safe.
+     */
+    bool tripped(int pin) const
+    {
+        return (latched & bit(pin)) != 0;
+    }
+
+private:
+    /**
+     * @brief Returns the mask bit of a pin, 0 outside GPIO 0 to 31.
+     */
+    static uint32_t bit(int pin)
+    {
+        return pin >= 0 && pin < 32 ? uint32_t(1) << pin : 0;
+    }
+
+    std::unique_ptr<GPIOBackend> backend; ///< The backend doing the work.
+    std::atomic<uint32_t> latched{0};     ///< Tripped pins, one bit per GPIO.
+};
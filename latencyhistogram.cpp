@@ -0,0 +1,98 @@
+#include "latencyhistogram.h"
+#include <algorithm>
+
+void LatencyHistogram::record(std::chrono::steady_clock::duration duration)
+{
+    auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    uint64_t value = microseconds > 0 ? static_cast<uint64_t>(microseconds) : 0;
+
+    buckets[bucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t previous = longest.load(std::memory_order_relaxed);
+    while (value > previous && !longest.compare_exchange_weak(previous, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+size_t LatencyHistogram::bucketFor(uint64_t microseconds)
+{
+    // The first buckets hold one value each; above, every power of two is
+    // split by the bits following its most significant one.
+    const uint64_t subBuckets = uint64_t(1) << subBucketBits;
+    if (microseconds < subBuckets)
+    {
+        return static_cast<size_t>(microseconds);
+    }
+
+    int msb = 63 - __builtin_clzll(microseconds);
+    size_t index = (static_cast<size_t>(msb - subBucketBits + 1) << subBucketBits) +
+                   static_cast<size_t>((microseconds >> (msb - subBucketBits)) & (subBuckets - 1));
+    return std::min(index, bucketCount - 1);
+}
+
+uint64_t LatencyHistogram::bucketLowerBound(size_t index)
+{
+    const uint64_t subBuckets = uint64_t(1) << subBucketBits;
+    if (index < subBuckets)
+    {
+        return index;
+    }
+
+    int octave = static_cast<int>(index >> subBucketBits) - 1;
+    return (subBuckets + (index & (subBuckets - 1))) << octave;
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const
+{
+    // Copy the buckets first, so the percentiles agree with the count used.
+    std::array<uint64_t, bucketCount> counts;
+    uint64_t recorded = 0;
+    for (size_t i = 0; i < bucketCount; ++i)
+    {
+        counts[i] = buckets[i].load(std::memory_order_relaxed);
+        recorded += counts[i];
+    }
+
+    Summary result;
+    result.count = recorded;
+    if (recorded == 0)
+    {
+        return result;
+    }
+    result.max = static_cast<double>(longest.load(std::memory_order_relaxed));
+    result.mean = static_cast<double>(total.load(std::memory_order_relaxed)) /
+                  std::max<uint64_t>(count.load(std::memory_order_relaxed), 1);
+
+    auto percentile = [&](double fraction)
+    {
+        uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(recorded - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucketCount; ++i)
+        {
+            seen += counts[i];
+            if (seen >= rank)
+            {
+                double upper = i + 1 < bucketCount ? static_cast<double>(bucketLowerBound(i + 1) - 1) : result.max;
+                return std::min(upper, result.max);
+            }
+        }
+        return result.max;
+    };
+    result.p50 = percentile(0.50);
+    result.p90 = percentile(0.90);
+    result.p99 = percentile(0.99);
+    return result;
+}
+
+void LatencyHistogram::reset()
+{
+    for (std::atomic<uint64_t> &bucket : buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    longest.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================================
+// LatencyHistogram Class
+// ============================================================================
+
+/**
+ * @brief Lock-free histogram of durations with fixed logarithmic buckets.
+ *
+ * Durations are counted in microseconds. Each power of two is split into
+ * four buckets, so a bucket is at most 25% wide and 128 buckets cover up
+ * to about two hours. Recording is a handful of relaxed atomic
+ * operations and never allocates, so any thread may record while another
+ * reads; a reader may see a sample in the count before it appears in its
+ * bucket.
+ */
+class LatencyHistogram
+{
+public:
+    /// Buckets per power of two, as a number of bits.
+    static constexpr int subBucketBits = 2;
+    /// Number of buckets; the last one also holds every longer duration.
+    static constexpr size_t bucketCount = 128;
+
+    /**
+     * @brief Summary of the recorded durations, in microseconds.
+     */
+    struct Summary
+    {
+        uint64_t count = 0; ///< Recorded durations.
+        double mean = 0;    ///< Mean duration.
+        double p50 = 0;     ///< Median, as the upper bound of its bucket.
+        double p90 = 0;     ///< 90th percentile, as the upper bound of its bucket.
+        double p99 = 0;     ///< 99th percentile, as the upper bound of its bucket.
+        double max = 0;     ///< Longest duration.
+    };
+
+    LatencyHistogram() = default;
+
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    /**
+     * @brief Records one duration. Thread-safe.
+     */
+    void record(std::chrono::steady_clock::duration duration);
+
+    /**
+     * @brief Computes the count, mean, percentiles and maximum.
+     */
+    Summary summary() const;
+
+    /**
+     * @brief Returns the number of durations in a bucket.
+     */
+    uint64_t bucket(size_t index) const
+    {
+        return buckets[index].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the shortest duration, in microseconds, that falls into a bucket.
+     */
+    static uint64_t bucketLowerBound(size_t index);
+
+    /**
+     * @brief Returns the bucket a duration in microseconds falls into.
+     */
+    static size_t bucketFor(uint64_t microseconds);
+
+    /**
+     * @brief Clears every bucket and counter.
+     */
+    void reset();
+
+private:
+    std::array<std::atomic<uint64_t>, bucketCount> buckets{}; ///< Durations per bucket.
+    std::atomic<uint64_t> count{0};                           ///< Recorded durations.
+    std::atomic<uint64_t> total{0};                           ///< Sum of the durations in microseconds.
+    std::atomic<uint64_t> longest{0};                         ///< Longest duration in microseconds.
+};
+
+// ============================================================================
+// LatencyProbe Class
+// ============================================================================
+
+/**
+ * @brief Records the lifetime of a scope into a histogram.
+ *
+ * A null histogram disables the probe.
+ */
+class LatencyProbe
+{
+public:
+    explicit LatencyProbe(LatencyHistogram *histogram)
+        : histogram(histogram), start(histogram ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point())
+    {
+    }
+
+    ~LatencyProbe()
+    {
+        if (histogram)
+        {
+            histogram->record(std::chrono::steady_clock::now() - start);
+        }
+    }
+
+    LatencyProbe(const LatencyProbe &) = delete;
+    LatencyProbe &operator=(const LatencyProbe &) = delete;
+
+private:
+    LatencyHistogram *histogram;            ///< Receives the duration, may be null.
+    std::chrono::steady_clock::time_point start; ///< Time the probe was created.
+};
@@ -0,0 +1,74 @@
+#include "mainloopdispatcher.h"
+#include "libindi/eventloop.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+MainLoopDispatcher::~MainLoopDispatcher()
+{
+    if (callbackId >= 0)
+    {
+        IERmCallback(callbackId);
+    }
+    if (readFd >= 0)
+    {
+        ::close(readFd);
+        ::close(writeFd);
+    }
+}
+
+bool MainLoopDispatcher::open()
+{
+    if (readFd >= 0)
+    {
+        return true;
+    }
+
+    // Non-blocking on both ends: a full pipe already guarantees a wakeup.
+    int fds[2];
+    if (::pipe2(fds, O_CLOEXEC | O_NONBLOCK) != 0)
+    {
+        return false;
+    }
+    readFd = fds[0];
+    writeFd = fds[1];
+    callbackId = IEAddCallback(readFd, &MainLoopDispatcher::onReadable, this);
+    return true;
+}
+
+void MainLoopDispatcher::post(std::function<void()> callback)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back({std::chrono::steady_clock::now(), std::move(callback)});
+    }
+
+    char wake = 0;
+    ssize_t rv = ::write(writeFd, &wake, 1);
+    (void)rv;
+}
+
+void MainLoopDispatcher::onReadable(int fd, void *userpointer)
+{
+    auto *self = static_cast<MainLoopDispatcher *>(userpointer);
+
+    char drain[64];
+    while (::read(fd, drain, sizeof(drain)) > 0)
+    {
+    }
+
+    // Run callbacks outside the lock so they may post again.
+    std::deque<Pending> ready;
+    {
+        std::lock_guard<std::mutex> lock(self->mutex);
+        ready.swap(self->pending);
+    }
+    LatencyHistogram *latency = self->latency;
+    for (Pending &entry : ready)
+    {
+        if (latency)
+        {
+            latency->record(std::chrono::steady_clock::now() - entry.posted);
+        }
+        entry.callback();
+    }
+}
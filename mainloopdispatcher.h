@@ -0,0 +1,78 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include "latencyhistogram.h"
+
+// ============================================================================
+// MainLoopDispatcher Class
+// ============================================================================
+
+/**
+ * @brief Runs callbacks posted from worker threads on the INDI event loop.
+ *
+ * INDI properties may only be touched from the event loop thread. Worker
+ * threads post closures here; a self-pipe registered with IEAddCallback()
+ * wakes the event loop, which then runs them in posting order.
+ */
+class MainLoopDispatcher
+{
+public:
+    MainLoopDispatcher() = default;
+    ~MainLoopDispatcher();
+
+    MainLoopDispatcher(const MainLoopDispatcher &) = delete;
+    MainLoopDispatcher &operator=(const MainLoopDispatcher &) = delete;
+
+    /**
+     * @brief Creates the pipe and registers it with the event loop.
+     *
+     * Must be called from the event loop thread.
+     *
+     * @return true if successful, false otherwise.
+     */
+    bool open();
+
+    /**
+     * @brief Queues a callback for the event loop. Thread-safe.
+     */
+    void post(std::function<void()> callback);
+
+    /**
+     * @brief Records the delay between post() and each callback into a histogram.
+     *
+     * @param histogram The histogram, or null to stop recording. Must outlive the dispatcher.
+     */
+    void setLatencyHistogram(LatencyHistogram *histogram)
+    {
+        latency = histogram;
+    }
+
+private:
+    /**
+     * @brief A posted callback.
+     */
+    struct Pending
+    {
+        std::chrono::steady_clock::time_point posted; ///< Time of post().
+        std::function<void()> callback;               ///< The callback.
+    };
+
+    /**
+     * @brief Event loop callback; drains the pipe and runs pending callbacks.
+     */
+    static void onReadable(int fd, void *userpointer);
+
+    int readFd = -1;                            ///< Read end, watched by the event loop.
+    int writeFd = -1;                           ///< Write end, signalled by post().
+    int callbackId = -1;                        ///< Event loop registration.
+    std::mutex mutex;                           ///< Guards pending.
+    std::deque<Pending> pending;                ///< Callbacks not yet run.
+    std::atomic<LatencyHistogram *> latency{nullptr}; ///< Receives the dispatch delays, may be null.
+};
@@ -0,0 +1,91 @@
+#include "pidcontroller.h"
+#include <algorithm>
+
+void PIDController::setGains(double newKp, double newKi, double newKd)
+{
+    kp = newKp;
+    ki = newKi;
+    kd = newKd;
+}
+
+void PIDController::setOutputLimits(double newMinimum, double newMaximum)
+{
+    minimum = newMinimum;
+    maximum = newMaximum;
+    integral = std::clamp(integral, minimum, maximum);
+}
+
+void PIDController::setSlewRate(double perSecond)
+{
+    slewRate = perSecond;
+}
+
+void PIDController::reset(double output)
+{
+    // Preload the integral so the first update continues from the current output.
+    integral = std::clamp(output, minimum, maximum);
+    hasMeasurement = false;
+    last = Terms();
+    last.output = integral;
+}
+
+double PIDController::update(double setpoint, double measurement, double dt, double feedForward)
+{
+    if (dt <= 0)
+    {
+        return last.output;
+    }
+
+    double error = setpoint - measurement;
+    double proportional = kp * error;
+    double derivative = hasMeasurement ? -kd * (measurement - lastMeasurement) / dt : 0;
+    lastMeasurement = measurement;
+    hasMeasurement = true;
+
+    // Tentatively integrate; the integral alone never exceeds the output range.
+    double candidate = std::clamp(integral + ki * error * dt, minimum, maximum);
+    double unclamped = proportional + candidate + derivative + feedForward;
+    double output = std::clamp(unclamped, minimum, maximum);
+
+    if (slewRate > 0)
+    {
+        double step = slewRate * dt;
+        output = std::clamp(output, last.output - step, last.output + step);
+    }
+
+    // Keep the integration step unless the output is held back, by its range
+    // or the slew rate, in the direction the error pushes it.
+    bool limitedUp = output < unclamped && error > 0;
+    bool limitedDown = output > unclamped && error < 0;
+    if (!limitedUp && !limitedDown)
+    {
+        integral = candidate;
+    }
+
+    last.error = error;
+    last.proportional = proportional;
+    last.integral = integral;
+    last.derivative = derivative;
+    last.feedForward = feedForward;
+    last.output = output;
+    return output;
+}
+
+double PIDController::track(double output, double dt)
+{
+    output = std::clamp(output, minimum, maximum);
+    if (slewRate > 0 && dt > 0)
+    {
+        double step = slewRate * dt;
+        output = std::clamp(output, last.output - step, last.output + step);
+    }
+
+    // The output came from feed-forward alone, so a later update() fed the
+    // same feed-forward term continues from here with an empty integral.
+    integral = 0;
+    hasMeasurement = false;
+    last = Terms();
+    last.feedForward = output;
+    last.output = output;
+    return output;
+}
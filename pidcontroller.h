@@ -0,0 +1,104 @@
+#pragma once
+
+// ============================================================================
+// PIDController Class
+// ============================================================================
+
+/**
+ * @brief Discrete PID controller for a heater duty cycle.
+ *
+ * The derivative acts on the measurement rather than the error, so setpoint
+ * changes do not kick the output. The integral is clamped so that it alone
+ * never exceeds the output range, and it stops integrating while the output
+ * is saturated or slew limited in the direction of the error (anti-windup).
+ * The output moves by at most the slew rate per second.
+ *
+ * An optional feed-forward term is added to the output, so the integral only
+ * has to make up for what the feed-forward model gets wrong.
+ */
+class PIDController
+{
+public:
+    /**
+     * @brief Contributions to the last output, for display.
+     */
+    struct Terms
+    {
+        double error = 0;        ///< Setpoint minus measurement.
+        double proportional = 0; ///< Proportional term.
+        double integral = 0;     ///< Integral term.
+        double derivative = 0;   ///< Derivative term.
+        double feedForward = 0;  ///< Feed-forward term.
+        double output = 0;       ///< Output after clamping and slew limiting.
+    };
+
+    /**
+     * @brief Sets the gains.
+     *
+     * @param kp Proportional gain, output units per unit of error.
+     * @param ki Integral gain, output units per unit of error and second.
+     * @param kd Derivative gain, output units per unit of error per second.
+     */
+    void setGains(double kp, double ki, double kd);
+
+    /**
+     * @brief Sets the range the output is clamped to.
+     */
+    void setOutputLimits(double minimum, double maximum);
+
+    /**
+     * @brief Sets the largest output change per second; 0 disables the limit.
+     */
+    void setSlewRate(double perSecond);
+
+    /**
+     * @brief Restarts the controller from a known output (bumpless transfer).
+     *
+     * @param output The output currently applied.
+     */
+    void reset(double output);
+
+    /**
+     * @brief Computes the next output.
+     *
+     * @param setpoint The target value.
+     * @param measurement The measured value.
+     * @param dt Seconds since the previous update.
+     * @param feedForward Term added to the output ahead of the feedback.
+     * @return The new output.
+     */
+    double update(double setpoint, double measurement, double dt, double feedForward = 0);
+
+    /**
+     * @brief Moves the output toward a value without feedback, slew limited.
+     *
+     * Used to run on feed-forward alone when there is nothing to measure.
+     * The integral is cleared, so a later update() fed the same feed-forward
+     * term continues from the output reached.
+     *
+     * @param output The output to move toward.
+     * @param dt Seconds since the previous update.
+     * @return The new output.
+     */
+    double track(double output, double dt);
+
+    /**
+     * @brief Returns the terms of the last update.
+     */
+    const Terms &terms() const
+    {
+        return last;
+    }
+
+private:
+    double kp = 0;                ///< Proportional gain.
+    double ki = 0;                ///< Integral gain.
+    double kd = 0;                ///< Derivative gain.
+    double minimum = 0;           ///< Lowest output.
+    double maximum = 100;         ///< Highest output.
+    double slewRate = 0;          ///< Largest output change per second, 0 if unlimited.
+    double integral = 0;          ///< Integral accumulator, in output units.
+    double lastMeasurement = 0;   ///< Measurement of the previous update.
+    bool hasMeasurement = false;  ///< Whether lastMeasurement is valid.
+    Terms last;                   ///< Terms of the last update.
+};
@@ -0,0 +1,277 @@
+#include "pigpiodbackend.h"
+#include <pigpiod_if2.h>
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <vector>
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+PigpiodBackend::~PigpiodBackend()
+{
+    close();
+}
+
+bool PigpiodBackend::open()
+{
+    // pigpiod_if2 writes to its socket without MSG_NOSIGNAL; a daemon that
+    // went away must show up as a failed call, not kill the driver.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Connect to the pigpio daemon.
+    piId = pigpio_start(NULL, NULL);
+    return check(piId);
+}
+
+void PigpiodBackend::close()
+{
+    // Stop the pigpio daemon connection.
+    if (piId >= 0)
+    {
+        pigpio_stop(piId);
+        piId = -1;
+    }
+    // The daemon keeps sending the last waveform.
+    pwmPins.clear();
+    stagger = PWMStagger();
+    waveId = -1;
+    staggeredPins = 0;
+}
+
+std::string PigpiodBackend::describe()
+{
+    return "pigpio version: " + std::to_string(get_pigpio_version(piId)) +
+           ", hardware revision: " + std::to_string(get_hardware_revision(piId));
+}
+
+std::string PigpiodBackend::lastError() const
+{
+    return pigpio_error(lastResult);
+}
+
+bool PigpiodBackend::ping()
+{
+    // A register read without side effects.
+    return check(get_mode(piId, 0));
+}
+
+bool PigpiodBackend::connectionLost() const
+{
+    return lastResult == pigif_bad_send || lastResult == pigif_bad_recv || lastResult == pigif_unconnected_pi;
+}
+
+bool PigpiodBackend::check(int rv)
+{
+    if (rv < 0)
+    {
+        lastResult = rv;
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Switched Outputs
+// ============================================================================
+
+bool PigpiodBackend::setupOutput(int pin, bool level)
+{
+    // The waveform would keep driving a pin that left staggered PWM.
+    if (stagger.remove(pin) && !sendStaggeredWave())
+    {
+        return false;
+    }
+
+    // gpio_write() latches the level, then switches the pin to output, all
+    // in one round-trip.
+    return check(gpio_write(piId, pin, level ? PI_HIGH : PI_LOW));
+}
+
+bool PigpiodBackend::write(int pin, bool level)
+{
+    return check(gpio_write(piId, pin, level ? PI_HIGH : PI_LOW));
+}
+
+bool PigpiodBackend::writeBank(uint32_t setMask, uint32_t clearMask)
+{
+    // Each call latches its whole mask in a single register write. Break
+    // before make: rails going off drop before rails coming on draw inrush.
+    return (clearMask == 0 || check(clear_bank_1(piId, clearMask))) &&
+           (setMask == 0 || check(set_bank_1(piId, setMask)));
+}
+
+bool PigpiodBackend::readOutput(int pin, bool &on)
+{
+    // A pin running software or hardware PWM reports its duty cycle, which
+    // fails on any other pin. A staggered heater reads its level of the moment.
+    int duty = get_PWM_dutycycle(piId, pin);
+    if (duty >= 0)
+    {
+        on = duty > 0;
+        return true;
+    }
+
+    int mode = get_mode(piId, pin);
+    if (!check(mode))
+    {
+        return false;
+    }
+    if (mode != PI_OUTPUT)
+    {
+        on = false;
+        return true;
+    }
+
+    int level = gpio_read(piId, pin);
+    if (!check(level))
+    {
+        return false;
+    }
+    on = level == PI_HIGH;
+    return true;
+}
+
+// ============================================================================
+// PWM Outputs
+// ============================================================================
+
+bool PigpiodBackend::supportsPWM(int pin, PWMMode mode) const
+{
+    // PWM0 is routed to GPIO 12 and 18, PWM1 to GPIO 13 and 19.
+    if (mode == PWMMode::HARDWARE)
+    {
+        return pin == 12 || pin == 13 || pin == 18 || pin == 19;
+    }
+    return pin >= 0 && pin <= 31;
+}
+
+bool PigpiodBackend::setupPWM(int pin, unsigned frequency, PWMMode mode, double dutyCycle)
+{
+    pwmPins[pin] = {frequency, mode};
+
+    if (mode == PWMMode::STAGGERED)
+    {
+        // Staggered pins share one period, the last one configured. gpio_write()
+        // stops any other PWM on the pin and makes it an output for the waveform.
+        if (!stagger.contains(pin) && !check(gpio_write(piId, pin, PI_LOW)))
+        {
+            return false;
+        }
+        stagger.setPeriod(static_cast<uint32_t>(std::lround(1e6 / std::max(frequency, 1u))));
+        stagger.setDutyCycle(pin, dutyCycle);
+        return sendStaggeredWave();
+    }
+
+    // A pin leaving staggered mode no longer takes part in the waveform.
+    if (stagger.remove(pin) && !sendStaggeredWave())
+    {
+        return false;
+    }
+
+    if (mode == PWMMode::HARDWARE)
+    {
+        // hardware_PWM() switches the pin to its PWM alternate function and
+        // sets frequency and duty in one round-trip; a running channel
+        // continues without a restart.
+        return writePWM(pin, dutyCycle);
+    }
+
+    // Software PWM timed by pigpiod's DMA sampling; the frequency is rounded
+    // to the nearest one supported at the daemon's sample rate.
+    return check(set_mode(piId, pin, PI_OUTPUT)) &&
+           check(set_PWM_frequency(piId, pin, frequency)) &&
+           writePWM(pin, dutyCycle);
+}
+
+bool PigpiodBackend::writePWM(int pin, double dutyCycle)
+{
+    const PWMPin &pwm = pwmPins[pin];
+    if (pwm.mode == PWMMode::STAGGERED)
+    {
+        // Duty changes below the waveform's microsecond resolution are not resent.
+        return !stagger.setDutyCycle(pin, dutyCycle) || sendStaggeredWave();
+    }
+    if (pwm.mode == PWMMode::HARDWARE)
+    {
+        // Hardware PWM takes the duty in millionths.
+        uint32_t duty = static_cast<uint32_t>(std::lround(dutyCycle * PI_HW_PWM_RANGE / 100));
+        return check(hardware_PWM(piId, pin, pwm.frequency, duty));
+    }
+
+    // Software PWM uses the default 0-255 range.
+    return check(set_PWM_dutycycle(piId, pin, static_cast<unsigned>(std::lround(dutyCycle * 2.55))));
+}
+
+bool PigpiodBackend::cutPWM(int pin)
+{
+    // pigpiod_if2 serialises the commands on a connection, so this only has
+    // to stay clear of the state owned by the user thread.
+    uint32_t staggered = staggeredPins;
+    if ((staggered & (uint32_t(1) << pin)) != 0)
+    {
+        // A stopped waveform leaves its pins at their last level, so clear them
+        // all; the other staggered pins resume with the next waveform.
+        wave_tx_stop(piId);
+        return clear_bank_1(piId, staggered) >= 0;
+    }
+
+    // gpio_write() also stops hardware and software PWM on the pin.
+    return gpio_write(piId, pin, PI_LOW) >= 0;
+}
+
+bool PigpiodBackend::sendStaggeredWave()
+{
+    staggeredPins = stagger.mask();
+
+    // After a restart, the waveform left running by the previous session is
+    // the one to replace.
+    if (waveId < 0)
+    {
+        int running = wave_tx_at(piId);
+        waveId = running >= 0 && running < PI_WAVE_NOT_FOUND ? running : -1;
+    }
+
+    if (stagger.empty())
+    {
+        if (waveId >= 0)
+        {
+            wave_tx_stop(piId);
+            wave_delete(piId, waveId);
+            waveId = -1;
+        }
+        return true;
+    }
+
+    std::vector<gpioPulse_t> pulses;
+    for (const PWMStagger::Pulse &pulse : stagger.pulses())
+    {
+        pulses.push_back({pulse.on, pulse.off, pulse.delay});
+    }
+
+    // wave_create() consumes the pulses added since the last one; start from
+    // an empty list, as a failed create leaves its pulses pending.
+    if (!check(wave_add_new(piId)) || !check(wave_add_generic(piId, pulses.size(), pulses.data())))
+    {
+        return false;
+    }
+    int id = wave_create(piId);
+    if (!check(id))
+    {
+        return false;
+    }
+    if (!check(wave_send_using_mode(piId, id, PI_WAVE_MODE_REPEAT_SYNC)))
+    {
+        wave_delete(piId, id);
+        return false;
+    }
+
+    // The old waveform is only flagged; its resources are freed once it has stopped.
+    if (waveId >= 0)
+    {
+        wave_delete(piId, waveId);
+    }
+    waveId = id;
+    return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include "gpiobackend.h"
+#include "pwmstagger.h"
+#include <atomic>
+#include <map>
+
+// ============================================================================
+// PigpiodBackend Class
+// ============================================================================
+
+/**
+ * @brief GPIO backend talking to the pigpio daemon through pigpiod_if2.
+ *
+ * Every call is a round-trip on pigpiod's socket. Supports hardware PWM on
+ * the PWM-capable pins, DMA-timed software PWM on any pin, and staggered
+ * PWM on any pin from a repeating waveform.
+ *
+ * A daemon that exits or restarts breaks the socket; the calls then fail
+ * with connectionLost() set until the backend is reopened.
+ */
+class PigpiodBackend : public GPIOBackend
+{
+public:
+    PigpiodBackend() = default;
+    ~PigpiodBackend() override;
+
+    const char *name() const override
+    {
+        return "pigpiod";
+    }
+
+    bool open() override;
+    void close() override;
+    std::string describe() override;
+    std::string lastError() const override;
+    bool ping() override;
+    bool connectionLost() const override;
+
+    bool setupOutput(int pin, bool level) override;
+    bool write(int pin, bool level) override;
+    bool writeBank(uint32_t setMask, uint32_t clearMask) override;
+    bool readOutput(int pin, bool &on) override;
+
+    bool supportsPWM(int pin, PWMMode mode) const override;
+    bool setupPWM(int pin, unsigned frequency, PWMMode mode, double dutyCycle) override;
+    bool writePWM(int pin, double dutyCycle) override;
+    bool cutPWM(int pin) override;
+
+private:
+    /**
+     * @brief Records the result of a pigpiod call.
+     *
+     * @param rv The value returned by pigpiod_if2.
+     * @return true if rv indicates success.
+     */
+    bool check(int rv);
+
+    /**
+     * @brief Replaces the running staggered waveform with the current plan.
+     *
+     * The new waveform takes over at the end of the running one's cycle, so
+     * no pulse is cut short. With no staggered pin left, the waveform stops.
+     */
+    bool sendStaggeredWave();
+
+    /**
+     * @brief PWM configuration of a pin.
+     */
+    struct PWMPin
+    {
+        unsigned frequency = 0;
+        PWMMode mode = PWMMode::SOFTWARE;
+    };
+
+    std::atomic<int> piId{-1};              ///< Raspberry Pi connection ID (invalid until opened); read by cutPWM().
+    int lastResult = 0;                     ///< Last failing pigpiod return code.
+    std::map<int, PWMPin> pwmPins;          ///< PWM configuration by pin.
+    PWMStagger stagger;                     ///< Plan of the staggered pins.
+    int waveId = -1;                        ///< Staggered waveform being sent, -1 if unknown.
+    std::atomic<uint32_t> staggeredPins{0}; ///< Pins driven by the waveform, for cutPWM().
+};
@@ -0,0 +1,97 @@
+#include "powerprofile.h"
+#include <algorithm>
+#include <sstream>
+
+namespace
+{
+/**
+ * @brief Parses an on/off switch value.
+ */
+bool parseSwitch(const std::string &value, bool &target)
+{
+    if (value == "on")
+    {
+        target = true;
+        return true;
+    }
+    if (value == "off")
+    {
+        target = false;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Parses a duty cycle between 0 and 100 percent.
+ */
+bool parseDutyCycle(const std::string &value, double &target)
+{
+    std::istringstream stream(value);
+    double dutyCycle;
+    if (!(stream >> dutyCycle) || !stream.eof() || dutyCycle < 0 || dutyCycle > 100)
+    {
+        return false;
+    }
+    target = dutyCycle;
+    return true;
+}
+
+/**
+ * @brief Maps a key of the profiles saved before the channel table to its default channel name.
+ *
+ * power, aux and heaterN become MAIN_POWER, AUX_POWER and HEATER_N; other keys are returned as they are.
+ */
+std::string channelName(const std::string &key)
+{
+    if (key == "power")
+    {
+        return "MAIN_POWER";
+    }
+    if (key == "aux")
+    {
+        return "AUX_POWER";
+    }
+    if (key.size() > 6 && key.compare(0, 6, "heater") == 0 &&
+        key.find_first_not_of("0123456789", 6) == std::string::npos)
+    {
+        return "HEATER_" + key.substr(6);
+    }
+    return key;
+}
+}
+
+bool parsePowerProfile(const std::string &text, const std::vector<ChannelConfig> &channels, PowerProfile &profile,
+                       std::string &error)
+{
+    profile = PowerProfile();
+
+    std::istringstream stream(text);
+    std::string entry;
+    while (stream >> entry)
+    {
+        size_t separator = entry.find('=');
+        std::string key = channelName(entry.substr(0, separator));
+        std::string value = separator == std::string::npos ? std::string() : entry.substr(separator + 1);
+
+        auto channel = std::find_if(channels.begin(), channels.end(), [&key](const ChannelConfig &candidate)
+                                    { return candidate.name == key; });
+
+        bool valid = false;
+        if (channel != channels.end() && channel->kind == ChannelKind::SWITCH)
+        {
+            valid = parseSwitch(value, profile.levels[key]);
+        }
+        else if (channel != channels.end() && channel->kind == ChannelKind::PWM)
+        {
+            valid = parseDutyCycle(value, profile.dutyCycles[key]);
+        }
+
+        if (!valid)
+        {
+            error = "invalid entry '" + entry + "'";
+            return false;
+        }
+    }
+    return true;
+}
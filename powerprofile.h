@@ -0,0 +1,43 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include "channeltable.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// PowerProfile Structure
+// ============================================================================
+
+/**
+ * @brief Target state of the outputs for a named power profile.
+ *
+ * Outputs a profile does not mention are left as they are.
+ */
+struct PowerProfile
+{
+    std::map<std::string, bool> levels;       ///< Level per switched channel name.
+    std::map<std::string, double> dutyCycles; ///< Duty cycle in percent per PWM channel name.
+};
+
+/**
+ * @brief Parses a profile definition.
+ *
+ * A definition is a whitespace-separated list of channel=value pairs, where
+ * channel is a name from the channel table and value is on|off for a switch
+ * or a duty cycle in percent for a PWM output,
+ * e.g. "MAIN_POWER=on AUX_POWER=on HEATER_0=40 HEATER_1=40". The keys of
+ * profiles saved before the channel table, power, aux and heaterN, stand
+ * for MAIN_POWER, AUX_POWER and HEATER_N.
+ *
+ * @param text The definition.
+ * @param channels The channel table.
+ * @param profile Receives the parsed profile.
+ * @param error Receives a description of the first invalid entry.
+ * @return true if the whole definition is valid.
+ */
+bool parsePowerProfile(const std::string &text, const std::vector<ChannelConfig> &channels, PowerProfile &profile,
+                       std::string &error);
@@ -0,0 +1,202 @@
+#include "powersequencer.h"
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <sstream>
+
+namespace
+{
+/**
+ * @brief Parses a time in seconds between 0 and 3600.
+ */
+bool parseSeconds(const std::string &value, std::chrono::milliseconds &target)
+{
+    std::istringstream stream(value);
+    double seconds;
+    if (!(stream >> seconds) || !stream.eof() || seconds < 0 || seconds > 3600)
+    {
+        return false;
+    }
+    target = std::chrono::milliseconds(std::lround(seconds * 1000));
+    return true;
+}
+
+/**
+ * @brief Parses one entry of an order.
+ */
+bool parseEntry(const std::string &entry, const std::vector<ChannelConfig> &channels, SequenceEntry &target)
+{
+    size_t at = entry.find('@');
+    size_t slash = entry.find('/');
+    target.name = entry.substr(0, std::min(at, slash));
+
+    auto channel = std::find_if(channels.begin(), channels.end(), [&target](const ChannelConfig &candidate)
+                                { return candidate.name == target.name; });
+    if (channel == channels.end())
+    {
+        return false;
+    }
+
+    // The delay comes first: NAME@delay/ramp.
+    if (at != std::string::npos &&
+        (at > slash || !parseSeconds(entry.substr(at + 1, slash == std::string::npos ? slash : slash - at - 1),
+                                     target.delay)))
+    {
+        return false;
+    }
+    if (slash != std::string::npos &&
+        (channel->kind != ChannelKind::PWM || !parseSeconds(entry.substr(slash + 1), target.ramp)))
+    {
+        return false;
+    }
+    return true;
+}
+}
+
+bool parsePowerSequence(const std::string &text, const std::vector<ChannelConfig> &channels,
+                        std::vector<SequenceEntry> &entries, std::string &error)
+{
+    entries.clear();
+
+    std::set<std::string> names;
+    std::istringstream stream(text);
+    std::string entry;
+    while (stream >> entry)
+    {
+        SequenceEntry parsed;
+        if (!parseEntry(entry, channels, parsed))
+        {
+            error = "invalid entry '" + entry + "'";
+            return false;
+        }
+        if (!names.insert(parsed.name).second)
+        {
+            error = "channel " + parsed.name + " listed more than once";
+            return false;
+        }
+        entries.push_back(parsed);
+    }
+    return true;
+}
+
+// ============================================================================
+// PowerSequencer
+// ============================================================================
+
+constexpr std::chrono::milliseconds PowerSequencer::rampInterval;
+
+PowerSequencer::PowerSequencer(MainLoopDispatcher &dispatcher)
+    : dispatcher(dispatcher)
+{
+}
+
+PowerSequencer::~PowerSequencer()
+{
+    abort();
+}
+
+void PowerSequencer::start(std::vector<Step> steps, Write write, Progress progress, Finished finished)
+{
+    abort();
+
+    // Lay out every write on one timeline, so a late write does not delay the next.
+    auto begin = std::chrono::steady_clock::now();
+    auto stepStart = begin;
+    std::vector<Event> events;
+    for (size_t i = 0; i < steps.size(); ++i)
+    {
+        const Step &step = steps[i];
+        stepStart += step.delay;
+        if (step.kind != ChannelKind::PWM || step.ramp.count() <= 0 || step.from == step.to)
+        {
+            events.push_back({stepStart, i, step.to});
+            continue;
+        }
+
+        for (std::chrono::milliseconds t = rampInterval;; t += rampInterval)
+        {
+            t = std::min(t, step.ramp);
+            double share = static_cast<double>(t.count()) / step.ramp.count();
+            events.push_back({stepStart + t, i, step.from + (step.to - step.from) * share});
+            if (t == step.ramp)
+            {
+                break;
+            }
+        }
+    }
+    std::stable_sort(events.begin(), events.end(), [](const Event &a, const Event &b)
+                     { return a.at < b.at; });
+
+    abortRequested = false;
+    active = true;
+    thread = std::thread(&PowerSequencer::run, this, generation.load(), begin, std::move(events), std::move(write),
+                         std::move(progress), std::move(finished));
+}
+
+void PowerSequencer::abort()
+{
+    // Drop the callbacks already posted by the sequence being stopped.
+    ++generation;
+    if (!thread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        abortRequested = true;
+    }
+    wakeup.notify_all();
+    thread.join();
+    active = false;
+}
+
+void PowerSequencer::run(uint64_t sequence, std::chrono::steady_clock::time_point begin, std::vector<Event> events,
+                         Write write, Progress progress, Finished finished)
+{
+    auto end = events.empty() ? begin : events.back().at;
+    std::chrono::microseconds lateness(0);
+    size_t started = 0;
+
+    for (const Event &event : events)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (wakeup.wait_until(lock, event.at, [this]
+                                  { return abortRequested; }))
+            {
+                return;
+            }
+        }
+
+        lateness = std::max(lateness, std::chrono::duration_cast<std::chrono::microseconds>(
+                                          std::chrono::steady_clock::now() - event.at));
+        write(event.step, event.value);
+
+        started = std::max(started, event.step + 1);
+        double percent = end > begin ? 100.0 * (event.at - begin) / (end - begin) : 100;
+        if (progress)
+        {
+            post(sequence, [progress, started, percent]
+                 { progress(started, percent); });
+        }
+    }
+
+    active = false;
+    if (finished)
+    {
+        post(sequence, [finished, lateness]
+             { finished(lateness); });
+    }
+}
+
+void PowerSequencer::post(uint64_t sequence, std::function<void()> callback)
+{
+    dispatcher.post([this, sequence, callback = std::move(callback)]
+                    {
+                        if (sequence == generation)
+                        {
+                            callback();
+                        }
+                    });
+}
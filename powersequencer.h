@@ -0,0 +1,157 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include "channeltable.h"
+#include "mainloopdispatcher.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// Sequence Order
+// ============================================================================
+
+/**
+ * @brief One channel in a power-up or power-down order.
+ */
+struct SequenceEntry
+{
+    std::string name;                   ///< Channel name from the channel table.
+    std::chrono::milliseconds delay{0}; ///< Wait after the previous step started.
+    std::chrono::milliseconds ramp{0};  ///< Time to ramp a PWM output to its target; 0 jumps.
+};
+
+/**
+ * @brief Parses a power-up or power-down order.
+ *
+ * An order is a whitespace-separated list of channels in the order they
+ * are switched. Each channel may be followed by @delay, the seconds to wait
+ * after the previous step started, and a PWM channel by /ramp, the seconds
+ * over which its duty cycle moves to the target, both 0 to 3600,
+ * e.g. "MAIN_POWER AUX_POWER@2 HEATER_0@1/10 HEATER_1/10".
+ * Each channel may appear once.
+ *
+ * @param text The order.
+ * @param channels The channel table.
+ * @param entries Receives the entries in order.
+ * @param error Receives a description of the first invalid entry.
+ * @return true if the whole order is valid.
+ */
+bool parsePowerSequence(const std::string &text, const std::vector<ChannelConfig> &channels,
+                        std::vector<SequenceEntry> &entries, std::string &error);
+
+// ============================================================================
+// PowerSequencer Class
+// ============================================================================
+
+/**
+ * @brief Runs a timed sequence of output changes on its own thread.
+ *
+ * Each step waits for its delay, counted from the start of the previous
+ * step, then moves one output to its target: a switch at once, a PWM output
+ * in a linear ramp with one write per rampInterval. Ramps run on while the
+ * following steps start. Every write is timed against the monotonic clock
+ * from the start of the sequence, so delays do not accumulate drift.
+ *
+ * The sequencer does not touch the hardware itself: it hands each value to
+ * a write callback on its thread, which is expected to queue the actual
+ * GPIO command. Progress and completion are delivered on the event loop;
+ * those of a sequence that was aborted or replaced are dropped.
+ */
+class PowerSequencer
+{
+public:
+    /// Interval between the writes of a ramp.
+    static constexpr std::chrono::milliseconds rampInterval{100};
+
+    /**
+     * @brief One output change.
+     */
+    struct Step
+    {
+        ChannelKind kind = ChannelKind::SWITCH; ///< Switches jump, PWM outputs may ramp.
+        double from = 0;                        ///< Starting value; 0 or 1 for a switch, percent for PWM.
+        double to = 0;                          ///< Target value, same unit.
+        std::chrono::milliseconds delay{0};     ///< Wait after the previous step started.
+        std::chrono::milliseconds ramp{0};      ///< Ramp time of a PWM output.
+    };
+
+    /// Applies a value to a step's output; runs on the sequencer thread.
+    using Write = std::function<void(size_t step, double value)>;
+    /// Reports the steps started so far and the elapsed share in percent; runs on the event loop.
+    using Progress = std::function<void(size_t steps, double percent)>;
+    /// Reports the end of the sequence and the latest any write ran; runs on the event loop.
+    using Finished = std::function<void(std::chrono::microseconds lateness)>;
+
+    /**
+     * @param dispatcher Runs progress and completion callbacks on the event loop.
+     */
+    explicit PowerSequencer(MainLoopDispatcher &dispatcher);
+    ~PowerSequencer();
+
+    PowerSequencer(const PowerSequencer &) = delete;
+    PowerSequencer &operator=(const PowerSequencer &) = delete;
+
+    /**
+     * @brief Starts a sequence, aborting the running one.
+     *
+     * @param steps The steps in order.
+     * @param write Applies each value.
+     * @param progress Called after every write; may be empty.
+     * @param finished Called once every step is done; may be empty.
+     */
+    void start(std::vector<Step> steps, Write write, Progress progress, Finished finished);
+
+    /**
+     * @brief Stops the running sequence where it is; outputs keep their last value.
+     *
+     * Returns once the thread has exited, so no write follows.
+     */
+    void abort();
+
+    /**
+     * @brief Returns whether a sequence is running.
+     */
+    bool running() const
+    {
+        return active;
+    }
+
+private:
+    /**
+     * @brief A write scheduled at a point in time.
+     */
+    struct Event
+    {
+        std::chrono::steady_clock::time_point at; ///< When to write.
+        size_t step;                              ///< Step the write belongs to.
+        double value;                             ///< Value to write.
+    };
+
+    /**
+     * @brief Sequencer thread main loop.
+     */
+    void run(uint64_t sequence, std::chrono::steady_clock::time_point begin, std::vector<Event> events, Write write,
+             Progress progress, Finished finished);
+
+    /**
+     * @brief Posts a callback that is dropped if the sequence is no longer current.
+     */
+    void post(uint64_t sequence, std::function<void()> callback);
+
+    MainLoopDispatcher &dispatcher;      ///< Runs callbacks on the event loop.
+    std::thread thread;                  ///< Sequencer thread.
+    std::mutex mutex;                    ///< Guards abortRequested.
+    std::condition_variable wakeup;      ///< Signals an abort.
+    bool abortRequested = false;         ///< Set to ask the thread to exit.
+    std::atomic<bool> active{false};     ///< Whether a sequence is running.
+    std::atomic<uint64_t> generation{0}; ///< Current sequence; callbacks of older ones are dropped.
+};
@@ -0,0 +1,43 @@
+#include "publishpolicy.h"
+#include <algorithm>
+#include <cmath>
+
+void PublishPolicy::setSettings(const Settings &settings)
+{
+    config = settings;
+}
+
+void PublishPolicy::reset()
+{
+    hasPublished = false;
+}
+
+bool PublishPolicy::check(const double *values, size_t count, int state, std::chrono::steady_clock::time_point now)
+{
+    bool publish = !hasPublished || count != lastValues.size() || state != lastState;
+    if (!publish)
+    {
+        auto silence = now - lastPublish;
+        bool changed = false;
+        for (size_t i = 0; i < count && !changed; ++i)
+        {
+            double deadband = std::max(config.absolute, config.relative / 100 * std::fabs(lastValues[i]));
+            changed = std::fabs(values[i] - lastValues[i]) > deadband;
+        }
+        publish = (changed && silence >= config.minInterval) ||
+                  (config.maxSilence.count() > 0 && silence >= config.maxSilence);
+    }
+
+    if (!publish)
+    {
+        suppressedCount++;
+        return false;
+    }
+
+    lastValues.assign(values, values + count);
+    lastState = state;
+    lastPublish = now;
+    hasPublished = true;
+    publishedCount++;
+    return true;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// PublishPolicy Class
+// ============================================================================
+
+/**
+ * @brief Decides when a numeric property is worth sending to clients.
+ *
+ * A property is published when its state changes, or when a value moved
+ * by more than the deadband since it was last published, but no more often
+ * than the minimum interval. A property that stays within its deadband is
+ * still re-sent once the maximum silent interval has passed, so clients can
+ * tell a quiet device from a dead one.
+ *
+ * Changes held back by the minimum interval are not lost: the values still
+ * differ from the published ones on the next check.
+ */
+class PublishPolicy
+{
+public:
+    /**
+     * @brief Thresholds of the policy.
+     */
+    struct Settings
+    {
+        double absolute = 0;                         ///< Absolute deadband in value units.
+        double relative = 0;                         ///< Relative deadband in percent of the published value.
+        std::chrono::milliseconds maxSilence{60000}; ///< Longest interval without publishing, 0 to disable.
+        std::chrono::milliseconds minInterval{0};    ///< Shortest interval between value updates.
+    };
+
+    /**
+     * @brief Replaces the thresholds.
+     */
+    void setSettings(const Settings &settings);
+
+    /**
+     * @brief Returns the thresholds.
+     */
+    const Settings &settings() const
+    {
+        return config;
+    }
+
+    /**
+     * @brief Decides whether to publish and counts the outcome.
+     *
+     * When the answer is yes, the values and state become the new reference.
+     *
+     * @param values The property's current values.
+     * @param count The number of values to compare.
+     * @param state The property's current state.
+     * @param now The current time.
+     * @return true if the property should be published.
+     */
+    bool check(const double *values, size_t count, int state, std::chrono::steady_clock::time_point now);
+
+    /**
+     * @brief Forgets the last published values, so the next check publishes.
+     */
+    void reset();
+
+    /**
+     * @brief Returns the number of checks that published.
+     */
+    uint64_t published() const
+    {
+        return publishedCount;
+    }
+
+    /**
+     * @brief Returns the number of checks that were suppressed.
+     */
+    uint64_t suppressed() const
+    {
+        return suppressedCount;
+    }
+
+private:
+    Settings config;                                   ///< Thresholds.
+    std::vector<double> lastValues;                    ///< Values last published.
+    int lastState = -1;                                ///< State last published.
+    bool hasPublished = false;                         ///< Whether lastValues is valid.
+    std::chrono::steady_clock::time_point lastPublish; ///< Time of the last publish.
+    uint64_t publishedCount = 0;                       ///< Checks that published.
+    uint64_t suppressedCount = 0;                      ///< Checks that were suppressed.
+};
@@ -0,0 +1,162 @@
+#include "pwmstagger.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+bool PWMStagger::setPeriod(uint32_t microseconds)
+{
+    microseconds = std::max<uint32_t>(microseconds, 1);
+    if (microseconds == periodUs)
+    {
+        return false;
+    }
+    periodUs = microseconds;
+    place(0, true);
+    dirty = true;
+    return true;
+}
+
+bool PWMStagger::setDutyCycle(int pin, double dutyCycle)
+{
+    dutyCycle = std::min(std::max(dutyCycle, 0.0), 100.0);
+
+    auto it = std::find_if(channels.begin(), channels.end(), [pin](const Channel &channel)
+                           { return channel.pin == pin; });
+    if (it == channels.end())
+    {
+        channels.push_back({pin, dutyCycle, 0, 0});
+        place(channels.size() - 1, false);
+        dirty = true;
+        return true;
+    }
+
+    // Only this pin and the ones placed after it can move.
+    it->duty = dutyCycle;
+    bool changed = place(static_cast<size_t>(it - channels.begin()), false);
+    dirty = dirty || changed;
+    return changed;
+}
+
+bool PWMStagger::remove(int pin)
+{
+    auto it = std::find_if(channels.begin(), channels.end(), [pin](const Channel &channel)
+                           { return channel.pin == pin; });
+    if (it == channels.end())
+    {
+        return false;
+    }
+
+    size_t index = static_cast<size_t>(it - channels.begin());
+    channels.erase(it);
+    place(index, false);
+    dirty = true;
+    return true;
+}
+
+bool PWMStagger::contains(int pin) const
+{
+    return std::any_of(channels.begin(), channels.end(), [pin](const Channel &channel)
+                       { return channel.pin == pin; });
+}
+
+uint32_t PWMStagger::mask() const
+{
+    uint32_t bits = 0;
+    for (const Channel &channel : channels)
+    {
+        bits |= uint32_t(1) << channel.pin;
+    }
+    return bits;
+}
+
+uint32_t PWMStagger::offset(int pin) const
+{
+    for (const Channel &channel : channels)
+    {
+        if (channel.pin == pin)
+        {
+            return channel.offset;
+        }
+    }
+    return 0;
+}
+
+bool PWMStagger::place(size_t from, bool all)
+{
+    bool changed = false;
+    for (size_t i = from; i < channels.size(); ++i)
+    {
+        Channel &channel = channels[i];
+        if (all || i == from)
+        {
+            uint32_t onTime = static_cast<uint32_t>(std::lround(channel.duty * periodUs / 100));
+            changed = changed || onTime != channel.onTime;
+            channel.onTime = onTime;
+        }
+
+        // Start where the previous pulse ends, wrapping around the period.
+        const Channel *previous = i > 0 ? &channels[i - 1] : nullptr;
+        uint32_t offset = previous ? (previous->offset + previous->onTime) % periodUs : 0;
+        changed = changed || offset != channel.offset;
+        channel.offset = offset;
+    }
+    return changed;
+}
+
+size_t PWMStagger::peakOverlap() const
+{
+    // The count only changes at a pulse start, so checking those suffices.
+    size_t peak = 0;
+    for (const Channel &start : channels)
+    {
+        size_t on = 0;
+        for (const Channel &channel : channels)
+        {
+            uint32_t since = (start.offset + periodUs - channel.offset) % periodUs;
+            on += since < channel.onTime ? 1 : 0;
+        }
+        peak = std::max(peak, on);
+    }
+    return peak;
+}
+
+const std::vector<PWMStagger::Pulse> &PWMStagger::pulses()
+{
+    if (!dirty)
+    {
+        return wave;
+    }
+
+    // Collect the edges by time; the first step always starts at 0.
+    std::map<uint32_t, Pulse> edges;
+    edges[0] = Pulse{0, 0, 0};
+    for (const Channel &channel : channels)
+    {
+        uint32_t bit = uint32_t(1) << channel.pin;
+        if (channel.onTime == 0)
+        {
+            edges[0].off |= bit;
+        }
+        else if (channel.onTime >= periodUs)
+        {
+            edges[0].on |= bit;
+        }
+        else
+        {
+            edges[channel.offset].on |= bit;
+            edges[(channel.offset + channel.onTime) % periodUs].off |= bit;
+        }
+    }
+
+    // Each step lasts until the next edge, the last one until the period ends.
+    wave.clear();
+    for (auto it = edges.begin(); it != edges.end(); ++it)
+    {
+        auto next = std::next(it);
+        Pulse pulse = it->second;
+        pulse.delay = (next == edges.end() ? periodUs : next->first) - it->first;
+        wave.push_back(pulse);
+    }
+    dirty = false;
+    return wave;
+}
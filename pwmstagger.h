@@ -0,0 +1,134 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// PWMStagger Class
+// ============================================================================
+
+/**
+ * @brief Plans one PWM period for several pins with interleaved on-times.
+ *
+ * All pins share one period. Each pin's pulse starts where the previous
+ * pin's pulse ends, so while the duty cycles add up to 100% or less no two
+ * pins are on at the same time, and above that the overlap is as small as
+ * it can be. Times are whole microseconds, the resolution of a pigpio
+ * waveform.
+ *
+ * Changing a duty cycle only moves the pins placed after it. The pulse list
+ * is rebuilt on demand and only when the quantized plan changed.
+ */
+class PWMStagger
+{
+public:
+    /**
+     * @brief One step of the waveform, laid out like pigpio's gpioPulse_t.
+     */
+    struct Pulse
+    {
+        uint32_t on;    ///< Pins switched on at the start of the step, one bit per GPIO.
+        uint32_t off;   ///< Pins switched off at the start of the step, one bit per GPIO.
+        uint32_t delay; ///< Duration of the step in microseconds.
+    };
+
+    /**
+     * @brief Sets the shared period and re-plans every pin.
+     *
+     * @param microseconds The period, at least 1.
+     * @return true if the plan changed.
+     */
+    bool setPeriod(uint32_t microseconds);
+
+    /**
+     * @brief Returns the shared period in microseconds.
+     */
+    uint32_t period() const
+    {
+        return periodUs;
+    }
+
+    /**
+     * @brief Adds a pin or changes its duty cycle.
+     *
+     * New pins are placed after the existing ones.
+     *
+     * @param pin The GPIO pin, 0 to 31.
+     * @param dutyCycle The duty cycle in percent, clamped to 0 to 100.
+     * @return true if the plan changed.
+     */
+    bool setDutyCycle(int pin, double dutyCycle);
+
+    /**
+     * @brief Removes a pin; the pins placed after it move up.
+     *
+     * @return true if the pin was part of the plan.
+     */
+    bool remove(int pin);
+
+    /**
+     * @brief Returns whether a pin is part of the plan.
+     */
+    bool contains(int pin) const;
+
+    /**
+     * @brief Returns whether no pin is part of the plan.
+     */
+    bool empty() const
+    {
+        return channels.empty();
+    }
+
+    /**
+     * @brief Returns the pins of the plan, one bit per GPIO.
+     */
+    uint32_t mask() const;
+
+    /**
+     * @brief Returns the phase offset of a pin in microseconds, 0 if unknown.
+     */
+    uint32_t offset(int pin) const;
+
+    /**
+     * @brief Returns the most pins on at the same time.
+     */
+    size_t peakOverlap() const;
+
+    /**
+     * @brief Returns the steps of one period, starting at time 0.
+     *
+     * Pins at 0% are switched off and pins at 100% on in the first step.
+     * Their delays add up to the period.
+     */
+    const std::vector<Pulse> &pulses();
+
+private:
+    /**
+     * @brief A pin in the plan.
+     */
+    struct Channel
+    {
+        int pin;         ///< GPIO pin.
+        double duty;     ///< Requested duty cycle in percent.
+        uint32_t onTime; ///< On-time in microseconds.
+        uint32_t offset; ///< Start of the on-time in microseconds.
+    };
+
+    /**
+     * @brief Recomputes the on-times and offsets from a channel onwards.
+     *
+     * @param from The first channel to place.
+     * @param all Recompute the on-times too, after a period change.
+     * @return true if any on-time or offset changed.
+     */
+    bool place(size_t from, bool all);
+
+    std::vector<Channel> channels; ///< Pins in placement order.
+    std::vector<Pulse> wave;       ///< Steps of the last plan built.
+    uint32_t periodUs = 1000;      ///< Shared period in microseconds.
+    bool dirty = true;             ///< Whether wave is out of date.
+};
@@ -1,7 +1,23 @@
 #include "config.h"
 #include "rpi_powerbox.h"
+#include "pigpiodbackend.h"
+#include "simulatedbackend.h"
+#include "instrumentedbackend.h"
+#include "telemetrybackend.h"
+#ifdef HAVE_LIBGPIOD
+#include "gpiodbackend.h"
+#endif
+#include <algorithm>
+#include <map>
 #include <vector>
 #include <filesystem>
+#include <set>
+#include <cmath>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
 
 namespace fs = std::filesystem;
 
@@ -20,6 +36,15 @@ static std::unique_ptr<RPiPowerBox> mydriver(new RPiPowerBox());
 RPiPowerBox::RPiPowerBox()
 {
     setVersion(CDRIVER_VERSION_MAJOR, CDRIVER_VERSION_MINOR);
+    registerTasks();
+    attachLatencyHistograms();
+
+    // The watchdog and telemetry see each reading as it is taken, not when the sample task copies it.
+    sampler.setReadingObserver([this](const std::string &id, double value, std::chrono::steady_clock::time_point time)
+                               {
+                                   watchdog.feed(id, value, time);
+                                   telemetry.record(TelemetryKind::TEMPERATURE, id, value);
+                               });
 }
 
 RPiPowerBox::~RPiPowerBox()
@@ -41,15 +66,138 @@ bool RPiPowerBox::Connect()
 {
     LOG_INFO("Connecting PowerBox...");
 
+    // Worker completions are delivered through the event loop.
+    if (!dispatcher.open())
+    {
+        LOG_ERROR("Failed to register the GPIO completion pipe.");
+        return false;
+    }
+
+    // Apply a channel table changed while connected.
+    if (ChannelsTP[0].getText() != channelTable && !buildOutputs())
+    {
+        return false;
+    }
+
+    // A new telemetry file per session, opened first so it sees the outputs restored.
+    if (TelemetrySP.findOnSwitchIndex() == TELEMETRY_ON && !startTelemetry())
+    {
+        TelemetrySP.setState(IPS_ALERT);
+        TelemetrySP.apply();
+    }
+
     // Initialize GPIO pins and check for errors.
     bool rv = initGPIO();
     if (!rv)
     {
+        telemetry.stop();
         return false;
     }
 
-    // Detect connected temperature sensors.
+    // DefaultDevice loads the configuration before the event loop runs again;
+    // from then on, every output update is a change to write.
+    dispatcher.post([this]
+                    {
+                        for (SwitchOutput &output : switchOutputs)
+                        {
+                            output.restoredLevel = -1;
+                        }
+                        for (HeaterOutput &output : heaterOutputs)
+                        {
+                            output.restoredDutyCycle = -1;
+                        }
+                    });
+
+    // Closed-loop heaters continue from their restored duty cycle. The mode
+    // handler that does this otherwise only fires when the configuration is
+    // loaded, on the first connection.
+    auto now = std::chrono::steady_clock::now();
+    for (HeaterLoop &loop : heaterLoops)
+    {
+        if (loop.ModeSP.findOnSwitchIndex() > CONTROL_MANUAL)
+        {
+            loop.pid.reset((*loop.heaterProp)[0].getValue());
+            loop.lastUpdate = now;
+        }
+    }
+
+    // In simulation, sensors are discovered in a generated sysfs tree.
+    w1DevicesPath = W1_DEVICES_PATH;
+    sampler.setConversionDelay(std::chrono::milliseconds(0));
+    if (isSimulation())
+    {
+        SimulatedW1Bus::Script script;
+        script.probes = static_cast<int>(SimulationNP[SIM_PROBES].getValue());
+        script.buses = static_cast<int>(SimulationNP[SIM_BUSES].getValue());
+        script.temperature = SimulationNP[SIM_TEMPERATURE].getValue();
+        script.swing = SimulationNP[SIM_SWING].getValue();
+        script.swingPeriod = SimulationNP[SIM_SWING_PERIOD].getValue();
+        script.crcFailureRate = SimulationNP[SIM_CRC_FAILURES].getValue() / 100;
+        if (!simulatedBus.start(script))
+        {
+            LOG_ERROR("Failed to create the simulated sensor tree.");
+            gpio->close();
+            gpio.reset();
+            interlock = nullptr;
+            supervisor = nullptr;
+            telemetry.stop();
+            return false;
+        }
+        w1DevicesPath = simulatedBus.devicesPath();
+        sampler.setConversionDelay(std::chrono::milliseconds(static_cast<int>(SimulationNP[SIM_CONVERSION_DELAY].getValue())));
+        LOGF_INFO("Simulating %d sensor(s) in %s", script.probes, w1DevicesPath.c_str());
+    }
+
+    // From here on, the command queue's worker is the only user of the backend;
+    // the watchdog only ever cuts heaters through the interlock.
+    commands.start(gpio.get());
+    configureWatchdog();
+    startWatchdog();
+
+    // Describing the hardware takes extra round-trips, so it is left to the worker.
+    auto description = std::make_shared<std::string>();
+    submitGPIO(RP_PB_KEY_DESCRIBE,
+               [description](GPIOBackend &backend)
+               {
+                   *description = backend.describe();
+                   return true;
+               },
+               [this, description](bool, const std::string &)
+               {
+                   LOGF_INFO("GPIO backend %s: %s", gpio->name(), description->c_str());
+               });
+
+    // Bring up the outputs initGPIO() held back, in the power-up order.
+    if (!startupTargets.levels.empty() || !startupTargets.dutyCycles.empty())
+    {
+        runSequence(currentOutputs(), startupTargets, [](bool) {});
+    }
+
+    // Detect connected temperature sensors and start reading them.
     detectSensors();
+    samples = TemperatureSnapshot();
+    appliedResolution = 0;
+    sensorGeneration = 0;
+    sampler.setBulkRead(TempAcquisitionSP.findOnSwitchIndex() == TEMP_ACQ_BULK);
+    sampler.setResolution(temperatureResolution());
+    updatePassDuration();
+    sampler.setHistoryWindow(std::chrono::minutes(static_cast<int>(TempHistoryNP[0].getValue())));
+    sampler.setRetryPolicy(static_cast<int>(TempRetryNP[RETRY_BUDGET].getValue()),
+                           static_cast<int>(TempRetryNP[RETRY_FAILED_PASSES].getValue()));
+    sampler.start(sensors, acquisitionPeriod());
+
+    // Monitoring reads its snapshots from the socket, refreshed by the sample task.
+    if (SnapshotSP.findOnSwitchIndex() == SNAPSHOT_ON && !startSnapshotServer())
+    {
+        SnapshotSP.setState(IPS_ALERT);
+        SnapshotSP.apply();
+    }
+
+    // Sampling, control, publishing and housekeeping each run at their own rate.
+    dewRisk = false;
+    reportedOverruns.fill(0);
+    applyTaskPeriods();
+    scheduler.start();
 
     // Proceed with the default connection process.
     return DefaultDevice::Connect();
@@ -60,11 +208,41 @@ bool RPiPowerBox::Disconnect()
     LOG_INFO("Disconnecting PowerBox...");
     LOG_INFO("Releasing GPIO...");
 
-    // Stop the pigpio daemon connection.
-    pigpio_stop(piId);
+    scheduler.stop();
+    snapshots.stop();
+
+    // Report pending trips; the watchdog forgets them with the interlock, which goes with the backend.
+    if (interlock)
+    {
+        updateWatchdog();
+    }
+    watchdog.reset();
+    watchdog.unlockMemory();
+    tripsHandled.fill(false);
+    interlock = nullptr;
+
+    // Stop a running power sequence where it is, so that it queues no more commands.
+    finishSequence(false);
+
+    // Flush pending commands, then release the GPIO backend; outputs keep their last state.
+    commands.stop();
+    if (gpio)
+    {
+        gpio->close();
+        gpio.reset();
+    }
+    supervisor = nullptr;
+
+    // Save the output state changed since the last health check.
+    saveOutputs();
 
     LOG_INFO("Releasing temperature sensors...");
+    sampler.stop();
     sensors.clear();
+    simulatedBus.stop();
+
+    // Last, so that the final writes and readings make it into the file.
+    telemetry.stop();
 
     return DefaultDevice::Disconnect();
 }
@@ -74,14 +252,36 @@ bool RPiPowerBox::initProperties()
     // Initialize base properties.
     INDI::DefaultDevice::initProperties();
 
+    // Backend selection and simulation script, available before connecting.
+    defineGPIOBackend();
+    defineSimulation();
+
+    // Define the outputs from the default channel table until the configuration is loaded.
+    defineChannelTable();
+    buildOutputs();
+
     // Define device-specific properties.
-    definePowerSwitch();
-    defineAuxSwitch();
-    defineHeater0DutyCycle();
-    defineHeater1DutyCycle();
+    definePowerProfiles();
+    defineSequencer();
+    defineHeaterPWM();
+    defineControlPeriod();
+    defineWatchdog();
+    defineScheduler();
+    defineDiagnostics();
+    defineTelemetry();
+    defineSnapshot();
+    defineWeather();
+    definePublishing();
     defineTemperatureProbes();
+    defineTemperatureHistory();
+    defineTemperatureRetries();
+    defineTemperatureAcquisition();
+    defineTemperatureResolution();
 
-    addAuxControls();
+    // The task scheduler sets its own periods, so there is no polling period.
+    addDebugControl();
+    addSimulationControl();
+    addConfigurationControl();
 
     // Create and register the custom GPIO connection using a smart pointer.
     connection = std::make_unique<GPIOConnection>(this);
@@ -90,6 +290,35 @@ bool RPiPowerBox::initProperties()
     return true;
 }
 
+void RPiPowerBox::ISGetProperties(const char *dev)
+{
+    INDI::DefaultDevice::ISGetProperties(dev);
+
+    // The backend must be known before Connect(), so load it up front.
+    defineProperty(GPIOBackendSP);
+    loadConfig(true, GPIOBackendSP.getName());
+    defineProperty(SimulationNP);
+    loadConfig(true, SimulationNP.getName());
+    defineProperty(ActiveDeviceTP);
+    loadConfig(true, ActiveDeviceTP.getName());
+    defineProperty(ChannelsTP);
+    loadConfig(true, ChannelsTP.getName());
+    defineProperty(SequenceOrderTP);
+    loadConfig(true, SequenceOrderTP.getName());
+    defineProperty(SequenceStartupSP);
+    loadConfig(true, SequenceStartupSP.getName());
+    defineProperty(TelemetryDirectoryTP);
+    loadConfig(true, TelemetryDirectoryTP.getName());
+    defineProperty(TelemetryNP);
+    loadConfig(true, TelemetryNP.getName());
+    defineProperty(TelemetrySP);
+    loadConfig(true, TelemetrySP.getName());
+    defineProperty(SnapshotSocketTP);
+    loadConfig(true, SnapshotSocketTP.getName());
+    defineProperty(SnapshotSP);
+    loadConfig(true, SnapshotSP.getName());
+}
+
 bool RPiPowerBox::updateProperties()
 {
     INDI::DefaultDevice::updateProperties();
@@ -97,343 +326,3837 @@ bool RPiPowerBox::updateProperties()
     if (isConnected())
     {
         // Define properties when connected.
-        defineProperty(PowerSP);
-        defineProperty(AuxSP);
-        defineProperty(Heater0NP);
-        defineProperty(Heater1NP);
+        for (SwitchOutput &output : switchOutputs)
+        {
+            defineProperty(output.SP);
+        }
+        defineProperty(PowerProfileSP);
+        defineProperty(PowerProfileTP);
+        defineProperty(SequenceProgressNP);
+        defineProperty(SequenceAbortSP);
+        for (HeaterOutput &output : heaterOutputs)
+        {
+            defineProperty(output.NP);
+        }
+        defineProperty(GPIOLinkNP);
+        defineProperty(HeaterPWMModeSP);
+        defineProperty(HeaterPWMFreqNP);
 
         defineTemperatureProbes();
-        defineProperty(TempNP);
+        publishTemperatureProperties();
+        defineProperty(TempHistoryNP);
+        defineProperty(TempRetryNP);
+        defineProperty(TempAcquisitionSP);
+        defineProperty(TempResolutionSP);
+
+        // Assign each heater its own probe until configured otherwise.
+        for (size_t i = 0; i < heaterLoops.size(); ++i)
+        {
+            HeaterLoop &loop = heaterLoops[i];
+            if (loop.ProbesTP[PROBE_HEATER].getText()[0] == '\0' && i < sensors.size())
+            {
+                loop.ProbesTP[PROBE_HEATER].setText(sensors[i].id);
+            }
+            defineProperty(loop.ModeSP);
+            defineProperty(loop.SettingsNP);
+            defineProperty(loop.ProbesTP);
+            defineProperty(loop.LoopNP);
+        }
+        configureWatchdog();
+        defineProperty(ControlPeriodNP);
+        defineProperty(WatchdogNP);
+        defineProperty(WatchdogModeSP);
+        defineProperty(WatchdogStatusNP);
+        defineProperty(WatchdogRearmSP);
+        defineProperty(DewRiskNP);
+        defineProperty(WeatherNP);
+        defineProperty(WeatherTimeoutNP);
+        defineProperty(TempPublishNP);
+        defineProperty(ControlPublishNP);
+        defineProperty(PublishStatsNP);
+        defineProperty(TaskPeriodsNP);
+        defineProperty(TaskOverrunsNP);
+        defineProperty(TaskRuntimeNP);
+        for (LatencyChannel &channel : latencies)
+        {
+            defineProperty(channel.NP);
+        }
+        defineProperty(DiagnosticsDumpSP);
+        defineProperty(DiagnosticsFileTP);
+        defineProperty(DiagnosticsResetSP);
+        defineProperty(TelemetryStatusNP);
+        defineProperty(TelemetryFileTP);
+        defineProperty(SnapshotStatusNP);
+
+        // Clients that just saw the definitions hold the current values.
+        weatherPublisher.reset();
+        for (HeaterLoop &loop : heaterLoops)
+        {
+            loop.publisher.reset();
+        }
     }
     else
     {
         // Delete properties when not connected.
-        deleteProperty(PowerSP);
-        deleteProperty(AuxSP);
-        deleteProperty(Heater0NP);
-        deleteProperty(Heater1NP);
-        deleteProperty(TempNP);
+        for (SwitchOutput &output : switchOutputs)
+        {
+            deleteProperty(output.SP);
+        }
+        deleteProperty(PowerProfileSP);
+        deleteProperty(PowerProfileTP);
+        deleteProperty(SequenceProgressNP);
+        deleteProperty(SequenceAbortSP);
+        for (HeaterOutput &output : heaterOutputs)
+        {
+            deleteProperty(output.NP);
+        }
+        deleteProperty(GPIOLinkNP);
+        deleteProperty(HeaterPWMModeSP);
+        deleteProperty(HeaterPWMFreqNP);
+        withdrawTemperatureProperties();
+        deleteProperty(TempHistoryNP);
+        deleteProperty(TempRetryNP);
+        deleteProperty(TempAcquisitionSP);
+        deleteProperty(TempResolutionSP);
+
+        for (HeaterLoop &loop : heaterLoops)
+        {
+            deleteProperty(loop.ModeSP);
+            deleteProperty(loop.SettingsNP);
+            deleteProperty(loop.ProbesTP);
+            deleteProperty(loop.LoopNP);
+        }
+        deleteProperty(ControlPeriodNP);
+        deleteProperty(WatchdogNP);
+        deleteProperty(WatchdogModeSP);
+        deleteProperty(WatchdogStatusNP);
+        deleteProperty(WatchdogRearmSP);
+        deleteProperty(DewRiskNP);
+        deleteProperty(WeatherNP);
+        deleteProperty(WeatherTimeoutNP);
+        deleteProperty(TempPublishNP);
+        deleteProperty(ControlPublishNP);
+        deleteProperty(PublishStatsNP);
+        deleteProperty(TaskPeriodsNP);
+        deleteProperty(TaskOverrunsNP);
+        deleteProperty(TaskRuntimeNP);
+        for (LatencyChannel &channel : latencies)
+        {
+            deleteProperty(channel.NP);
+        }
+        deleteProperty(DiagnosticsDumpSP);
+        deleteProperty(DiagnosticsFileTP);
+        deleteProperty(DiagnosticsResetSP);
+        deleteProperty(TelemetryStatusNP);
+        deleteProperty(TelemetryFileTP);
+        deleteProperty(SnapshotStatusNP);
     }
 
     return true;
 }
 
-void RPiPowerBox::TimerHit()
+bool RPiPowerBox::saveConfigItems(FILE *fp)
 {
-    LOG_DEBUG("Timer hit.");
+    INDI::DefaultDevice::saveConfigItems(fp);
 
-    if (!isConnected())
+    GPIOBackendSP.save(fp);
+    SimulationNP.save(fp);
+    ChannelsTP.save(fp);
+    for (const SwitchOutput &output : switchOutputs)
     {
-        return;
+        output.SP.save(fp);
     }
-
-    // Update sensor temperature readings.
-    updateTemperatureReadings();
-
-    // Reset the timer (POLLMS defined elsewhere).
-    SetTimer(POLLMS);
+    for (const HeaterOutput &output : heaterOutputs)
+    {
+        output.NP.save(fp);
+    }
+    PowerProfileTP.save(fp);
+    SequenceOrderTP.save(fp);
+    SequenceStartupSP.save(fp);
+    HeaterPWMModeSP.save(fp);
+    HeaterPWMFreqNP.save(fp);
+    TempAcquisitionSP.save(fp);
+    TempResolutionSP.save(fp);
+    TempHistoryNP.save(fp);
+    TempRetryNP.save(fp);
+    for (const HeaterLoop &loop : heaterLoops)
+    {
+        loop.ModeSP.save(fp);
+        loop.SettingsNP.save(fp);
+        loop.ProbesTP.save(fp);
+    }
+    ControlPeriodNP.save(fp);
+    WatchdogNP.save(fp);
+    WatchdogModeSP.save(fp);
+    DewRiskNP.save(fp);
+    TaskPeriodsNP.save(fp);
+    DiagnosticsDumpSP.save(fp);
+    DiagnosticsFileTP.save(fp);
+    TelemetryDirectoryTP.save(fp);
+    TelemetryNP.save(fp);
+    TelemetrySP.save(fp);
+    SnapshotSocketTP.save(fp);
+    SnapshotSP.save(fp);
+    ActiveDeviceTP.save(fp);
+    WeatherTimeoutNP.save(fp);
+    TempPublishNP.save(fp);
+    ControlPublishNP.save(fp);
+    return true;
 }
 
 // ============================================================================
 // Property Update Handlers and Definitions
 // ============================================================================
 
-void RPiPowerBox::handlePowerUpdate()
+void RPiPowerBox::defineGPIOBackend()
 {
-    // Update the main power switch based on the selected switch.
-    switch (PowerSP.findOnSwitchIndex())
-    {
-    case PWR_ON:
-        LOG_INFO("PWR_ON");
-        gpio_write(piId, RPI_PB_GPIO_POWER, PI_HIGH);
-        PowerSP.setState(IPS_OK);
-        break;
-    case PWR_OFF:
-        LOG_INFO("PWR_OFF");
-        gpio_write(piId, RPI_PB_GPIO_POWER, PI_LOW);
-        PowerSP.setState(IPS_IDLE);
-        break;
-    }
-    PowerSP.apply();
+    // Configure the backend options.
+    GPIOBackendSP[BACKEND_PIGPIOD].fill("BACKEND_PIGPIOD", "pigpiod", ISS_ON);
+    GPIOBackendSP[BACKEND_GPIOD].fill("BACKEND_GPIOD", "gpiod", ISS_OFF);
+
+    GPIOBackendSP.fill(getDeviceName(),
+                       "GPIO_BACKEND",
+                       "GPIO Backend",
+                       CONNECTION_TAB,
+                       IP_RW,
+                       ISR_1OFMANY,
+                       60,
+                       IPS_IDLE);
+
+    // Configure the read-only connection counters, kept by the supervisor.
+    GPIOLinkNP[LINK_REPLAYS].fill("LINK_REPLAYS", "Reconnects", "%0.f", 0, 1e9, 0, 0);
+    GPIOLinkNP[LINK_RECONNECT].fill("LINK_RECONNECT", "Last reconnect (ms)", "%0.1f", 0, 1e9, 0, 0);
+    GPIOLinkNP[LINK_FAILED_ATTEMPTS].fill("LINK_FAILED_ATTEMPTS", "Failed attempts", "%0.f", 0, 1e9, 0, 0);
+
+    GPIOLinkNP.fill(getDeviceName(),
+                    "GPIO_LINK",
+                    "GPIO Connection",
+                    CONNECTION_TAB,
+                    IP_RO,
+                    60,
+                    IPS_IDLE);
+
+    // Register the update callback.
+    GPIOBackendSP.onUpdate([this]
+                           { handleGPIOBackendUpdate(); });
 }
 
-void RPiPowerBox::definePowerSwitch()
+void RPiPowerBox::handleGPIOBackendUpdate()
 {
-    // Configure individual power switch options.
-    PowerSP[PWR_ON].fill("PWR_ON", "On", ISS_ON);
-    PowerSP[PWR_OFF].fill("PWR_OFF", "Off", ISS_OFF);
+    // The backend is created by initGPIO(), so a change applies on the next connection.
+    LOGF_INFO("GPIO backend set to %s%s.", GPIOBackendSP.findOnSwitch()->getLabel(),
+              isConnected() ? ", reconnect to apply" : "");
+    GPIOBackendSP.setState(IPS_OK);
+    GPIOBackendSP.apply();
+}
 
-    // Configure the overall power switch property.
-    PowerSP.fill(getDeviceName(),
-                 "MAIN_POWER",
-                 "Main Power",
-                 MAIN_CONTROL_TAB,
-                 IP_RW,
-                 ISR_1OFMANY,
-                 60,
-                 IPS_OK);
+void RPiPowerBox::checkGPIOLink()
+{
+    if (!supervisor)
+    {
+        return;
+    }
 
-    // Register the update callback.
-    PowerSP.onUpdate([this]
-                     { handlePowerUpdate(); });
+    // The heartbeat runs on the worker like any command, so it never races a write.
+    SupervisedBackend *link = supervisor;
+    auto status = std::make_shared<SupervisedBackend::Status>();
+    submitGPIO(RP_PB_KEY_LINK,
+               [link, status](GPIOBackend &backend)
+               {
+                   bool ok = backend.ping();
+                   *status = link->status();
+                   return ok;
+               },
+               [this, status](bool, const std::string &error)
+               { updateGPIOLink(*status, error); });
 }
 
-void RPiPowerBox::handleAuxUpdate()
+void RPiPowerBox::updateGPIOLink(const SupervisedBackend::Status &status, const std::string &error)
 {
-    // Update the auxiliary switch based on the selected switch.
-    switch (AuxSP.findOnSwitchIndex())
+    if (status.connected != linkUp)
     {
-    case AUX_ON:
-        LOG_INFO("AUX_ON");
-        gpio_write(piId, RPI_PB_GPIO_AUX, PI_HIGH);
-        AuxSP.setState(IPS_OK);
-        break;
-    case AUX_OFF:
-        LOG_INFO("AUX_OFF");
-        gpio_write(piId, RPI_PB_GPIO_AUX, PI_LOW);
-        AuxSP.setState(IPS_IDLE);
-        break;
+        linkUp = status.connected;
+        if (linkUp)
+        {
+            LOGF_INFO("GPIO backend reconnected after %.0f ms; %zu output(s) restored.",
+                      status.lastReconnect.count() / 1000.0, status.outputs);
+        }
+        else
+        {
+            LOGF_ERROR("Lost the GPIO backend: %s", error.c_str());
+        }
+    }
+
+    // A reconnect between two heartbeats still shows in the counters.
+    bool changed = GPIOLinkNP[LINK_REPLAYS].getValue() != status.replays ||
+                   GPIOLinkNP[LINK_FAILED_ATTEMPTS].getValue() != status.failedAttempts ||
+                   GPIOLinkNP.getState() != (linkUp ? IPS_OK : IPS_ALERT);
+    if (changed)
+    {
+        GPIOLinkNP[LINK_REPLAYS].setValue(status.replays);
+        GPIOLinkNP[LINK_RECONNECT].setValue(status.lastReconnect.count() / 1000.0);
+        GPIOLinkNP[LINK_FAILED_ATTEMPTS].setValue(status.failedAttempts);
+        GPIOLinkNP.setState(linkUp ? IPS_OK : IPS_ALERT);
+        GPIOLinkNP.apply();
     }
-    AuxSP.apply();
 }
 
-void RPiPowerBox::defineAuxSwitch()
+void RPiPowerBox::defineSimulation()
+{
+    // Configure the script followed by the simulated hardware.
+    SimulationNP[SIM_PROBES].fill("SIM_PROBES", "Probes", "%0.f", 0, 100, 1, 2);
+    SimulationNP[SIM_BUSES].fill("SIM_BUSES", "Bus masters", "%0.f", 1, 8, 1, 1);
+    SimulationNP[SIM_TEMPERATURE].fill("SIM_TEMPERATURE", "Temperature (C)", "%0.1f", -40, 60, 1, 10);
+    SimulationNP[SIM_SWING].fill("SIM_SWING", "Swing (C)", "%0.1f", 0, 20, 0.5, 2);
+    SimulationNP[SIM_SWING_PERIOD].fill("SIM_SWING_PERIOD", "Swing period (s)", "%0.f", 1, 86400, 60, 600);
+    SimulationNP[SIM_CRC_FAILURES].fill("SIM_CRC_FAILURES", "CRC failures (%)", "%0.1f", 0, 100, 1, 0);
+    SimulationNP[SIM_CONVERSION_DELAY].fill("SIM_CONVERSION_DELAY", "Conversion delay (ms)", "%0.f", 0, 2000, 10, 750);
+    SimulationNP[SIM_GPIO_LATENCY].fill("SIM_GPIO_LATENCY", "GPIO latency (us)", "%0.f", 0, 100000, 100, 0);
+
+    SimulationNP.fill(getDeviceName(),
+                      "SIMULATION_SCRIPT",
+                      "Script",
+                      SIMULATION_TAB,
+                      IP_RW,
+                      60,
+                      IPS_IDLE);
+
+    // Applied on the next connection with simulation enabled.
+    SimulationNP.onUpdate([this]
+                          {
+                              SimulationNP.setState(IPS_OK);
+                              SimulationNP.apply(); });
+}
+
+void RPiPowerBox::defineChannelTable()
 {
-    // Configure individual auxiliary switch options.
-    AuxSP[AUX_ON].fill("AUX_ON", "On", ISS_ON);
-    AuxSP[AUX_OFF].fill("AUX_OFF", "Off", ISS_OFF);
+    // Configure the channel table; see parseChannelTable() for the syntax.
+    ChannelsTP[0].fill("CHANNELS", "Channels", RP_PB_CHANNELS);
 
-    // Configure the overall auxiliary property.
-    AuxSP.fill(getDeviceName(),
-               "AUX_POWER",
-               "Auxiliary Power",
-               MAIN_CONTROL_TAB,
-               IP_RW,
-               ISR_1OFMANY,
-               60,
-               IPS_OK);
+    ChannelsTP.fill(getDeviceName(),
+                    "OUTPUT_CHANNELS",
+                    "Output Channels",
+                    OPTIONS_TAB,
+                    IP_RW,
+                    60,
+                    IPS_IDLE);
 
     // Register the update callback.
-    AuxSP.onUpdate([this]
-                   { handleAuxUpdate(); });
+    ChannelsTP.onUpdate([this]
+                        { handleChannelTableUpdate(); });
 }
 
-void RPiPowerBox::handleHeaterUpdate(INDI::PropertyNumber &heaterProp, int gpioPin, const std::string &heaterName)
+void RPiPowerBox::handleChannelTableUpdate()
 {
-    // Retrieve the heater value and update the corresponding PWM duty cycle.
-    int heaterValue = static_cast<int>(heaterProp[0].getValue());
-    set_PWM_dutycycle(piId, gpioPin, heaterValue * 2.55);
-    LOGF_INFO("Setting %s to %d%%", heaterName.c_str(), heaterValue);
+    // Output properties cannot be replaced while clients use them, so a
+    // change made while connected applies on the next connection.
+    std::vector<ChannelConfig> table;
+    std::string error;
+    bool valid = parseChannelTable(ChannelsTP[0].getText(), table, error);
+    if (!valid)
+    {
+        LOGF_ERROR("Channel table: %s", error.c_str());
+    }
+    else if (isConnected())
+    {
+        LOG_INFO("Channel table changed, reconnect to apply.");
+    }
+    else
+    {
+        valid = buildOutputs();
+    }
 
-    // Update the property state based on the heater value.
-    heaterProp.setState(heaterValue == 0 ? IPS_IDLE : IPS_OK);
-    heaterProp.apply();
+    ChannelsTP.setState(valid ? IPS_OK : IPS_ALERT);
+    ChannelsTP.apply();
 }
 
-void RPiPowerBox::defineHeater0DutyCycle()
+bool RPiPowerBox::buildOutputs()
 {
-    // Configure Heater 0's numeric property.
-    Heater0NP[0].fill("HEATER_0",
-                      "Heater 0",
-                      "%0.f",
-                      0,
-                      100,
-                      5,
-                      0);
+    std::vector<ChannelConfig> table;
+    std::string error;
+    if (!parseChannelTable(ChannelsTP[0].getText(), table, error))
+    {
+        LOGF_ERROR("Channel table: %s", error.c_str());
+        return false;
+    }
+
+    // Keep the old loops until their settings have been carried over.
+    std::deque<HeaterLoop> previousLoops;
+    previousLoops.swap(heaterLoops);
+    switchOutputs.clear();
+    heaterOutputs.clear();
+
+    for (const ChannelConfig &channel : table)
+    {
+        if (channel.kind == ChannelKind::SWITCH)
+        {
+            switchOutputs.emplace_back();
+            switchOutputs.back().channel = channel;
+            defineSwitchOutput(switchOutputs.back());
+            continue;
+        }
+
+        heaterOutputs.emplace_back();
+        heaterOutputs.back().channel = channel;
+        defineHeaterOutput(heaterOutputs.back());
+
+        heaterLoops.emplace_back();
+        HeaterLoop &loop = heaterLoops.back();
+        defineHeaterControl(loop, heaterOutputs.back());
 
-    Heater0NP.fill(getDeviceName(),
-                   "HEATER_0",
-                   "Heater 0",
+        // A heater that keeps its name keeps its control settings.
+        for (const HeaterLoop &previous : previousLoops)
+        {
+            if (previous.name != loop.name)
+            {
+                continue;
+            }
+            for (int i = 0; i < CONTROL_N; ++i)
+            {
+                loop.ModeSP[i].setState(previous.ModeSP[i].getState());
+            }
+            for (int i = 0; i < PID_N; ++i)
+            {
+                loop.SettingsNP[i].setValue(previous.SettingsNP[i].getValue());
+            }
+            for (int i = 0; i < PROBE_N; ++i)
+            {
+                loop.ProbesTP[i].setText(previous.ProbesTP[i].getText());
+            }
+            handleHeaterControlSettingsUpdate(loop);
+        }
+    }
+
+    channels = table;
+    channelTable = ChannelsTP[0].getText();
+    applyPublishPolicies();
+    LOGF_DEBUG("Channel table: %zu switched and %zu PWM outputs.", switchOutputs.size(), heaterOutputs.size());
+    return true;
+}
+
+void RPiPowerBox::defineSwitchOutput(SwitchOutput &output)
+{
+    const ChannelConfig &channel = output.channel;
+
+    // Configure the on/off options, starting at the default level.
+    output.SP[SWITCH_ON].fill((channel.name + "_ON").c_str(), "On", channel.defaultLevel ? ISS_ON : ISS_OFF);
+    output.SP[SWITCH_OFF].fill((channel.name + "_OFF").c_str(), "Off", channel.defaultLevel ? ISS_OFF : ISS_ON);
+
+    output.SP.fill(getDeviceName(),
+                   channel.name.c_str(),
+                   channel.label.c_str(),
                    MAIN_CONTROL_TAB,
                    IP_RW,
-                   0,
-                   IPS_IDLE);
+                   ISR_1OFMANY,
+                   60,
+                   channel.defaultLevel ? IPS_OK : IPS_IDLE);
 
-    // Register update callback with the common heater update handler.
-    Heater0NP.onUpdate([this]
-                       { handleHeaterUpdate(Heater0NP, RP_PB_GPIO_HEATER0, "HEATER_0"); });
+    // Register the update callback.
+    output.SP.onUpdate([this, &output]
+                       { handleSwitchOutputUpdate(output); });
+}
+
+void RPiPowerBox::handleSwitchOutputUpdate(SwitchOutput &output)
+{
+    bool level = output.SP.findOnSwitchIndex() == SWITCH_ON;
+    if (heldBySequence(output.channel.pin, level ? 1 : 0))
+    {
+        output.SP.setState(IPS_BUSY);
+        output.SP.apply();
+        return;
+    }
+
+    // The configuration loaded after the first connection repeats the state initGPIO() wrote.
+    bool restored = output.restoredLevel == (level ? 1 : 0);
+    output.restoredLevel = -1;
+    if (restored)
+    {
+        output.SP.setState(level ? IPS_OK : IPS_IDLE);
+        output.SP.apply();
+        return;
+    }
+    LOGF_INFO("%s %s", output.channel.name.c_str(), level ? "on" : "off");
+    submitSwitch(output.SP, output.channel.pin, level);
+    persistOutputs();
 }
 
-void RPiPowerBox::defineHeater1DutyCycle()
+void RPiPowerBox::defineHeaterOutput(HeaterOutput &output)
 {
-    // Configure Heater 1's numeric property.
-    Heater1NP[0].fill("HEATER_1",
-                      "Heater 1",
-                      "%0.f",
+    const ChannelConfig &channel = output.channel;
+
+    // Configure the duty cycle, starting at the default.
+    output.NP[0].fill(channel.name.c_str(),
+                      channel.label.c_str(),
+                      "%0.2f",
                       0,
                       100,
-                      5,
-                      0);
+                      0.1,
+                      channel.defaultDutyCycle);
 
-    Heater1NP.fill(getDeviceName(),
-                   "HEATER_1",
-                   "Heater 1",
+    output.NP.fill(getDeviceName(),
+                   channel.name.c_str(),
+                   channel.label.c_str(),
                    MAIN_CONTROL_TAB,
                    IP_RW,
                    0,
                    IPS_IDLE);
 
     // Register update callback with the common heater update handler.
-    Heater1NP.onUpdate([this]
-                       { handleHeaterUpdate(Heater1NP, RP_PB_GPIO_HEATER1, "HEATER_1"); });
+    output.NP.onUpdate([this, &output]
+                       { handleHeaterUpdate(output); });
 }
 
-void RPiPowerBox::defineTemperatureProbes()
+void RPiPowerBox::restoreOutputs()
 {
-    // Resize the temperature property array to match the number of sensors.
-    TempNP.resize(sensors.size());
+    // One pass over the configuration file, rather than one per output.
+    std::map<std::string, std::string> saved;
+    char errmsg[MAXRBUF];
+    if (FILE *fp = IUGetConfigFP(nullptr, getDeviceName(), "r", errmsg))
+    {
+        LilXML *parser = newLilXML();
+        XMLEle *root = readXMLFile(fp, parser, errmsg);
+        fclose(fp);
+        delLilXML(parser);
+        for (XMLEle *vector = root ? nextXMLEle(root, 1) : nullptr; vector != nullptr; vector = nextXMLEle(root, 0))
+        {
+            std::string property = findXMLAttValu(vector, "name");
+            for (XMLEle *element = nextXMLEle(vector, 1); element != nullptr; element = nextXMLEle(vector, 0))
+            {
+                std::string value = pcdataXMLEle(element);
+                size_t first = value.find_first_not_of(" \t\r\n");
+                size_t last = value.find_last_not_of(" \t\r\n");
+                saved[property + "." + findXMLAttValu(element, "name")] =
+                    first == std::string::npos ? std::string() : value.substr(first, last - first + 1);
+            }
+        }
+        if (root)
+        {
+            delXMLEle(root);
+        }
+    }
 
-    // Define each temperature probe property.
-    for (size_t i = 0; i < sensors.size(); ++i)
+    for (SwitchOutput &output : switchOutputs)
     {
-        std::string label = "TEMP_" + std::to_string(i);
-        TempNP[i].fill(label.c_str(),
-                       sensors[i].id.c_str(),
-                       "%0.1f",
-                       -50,
-                       50,
-                       0.5,
-                       0);
+        bool level = output.channel.defaultLevel;
+        auto state = saved.find(std::string(output.SP.getName()) + "." + output.SP[SWITCH_ON].getName());
+        if (state != saved.end())
+        {
+            level = state->second == "On";
+        }
+        output.SP.reset();
+        output.SP[level ? SWITCH_ON : SWITCH_OFF].setState(ISS_ON);
+        output.SP.setState(level ? IPS_OK : IPS_IDLE);
     }
 
-    // Configure the overall temperature property.
-    TempNP.fill(getDeviceName(),
-                "TEMP",
-                "Temp Sensors",
-                MAIN_CONTROL_TAB,
-                IP_RO,
-                sensors.size(),
-                IPS_IDLE);
+    for (HeaterOutput &output : heaterOutputs)
+    {
+        double dutyCycle = output.channel.defaultDutyCycle;
+        auto value = saved.find(std::string(output.NP.getName()) + "." + output.NP[0].getName());
+        if (value != saved.end())
+        {
+            char *end = nullptr;
+            double number = std::strtod(value->second.c_str(), &end);
+            if (end != value->second.c_str())
+            {
+                dutyCycle = number;
+            }
+        }
+        dutyCycle = std::min(std::max(dutyCycle, 0.0), 100.0);
+        output.NP[0].setValue(dutyCycle);
+        output.NP.setState(dutyCycle == 0 ? IPS_IDLE : IPS_OK);
+    }
 }
 
-// ============================================================================
-// Hardware Initialization and Sensor Handling
-// ============================================================================
+void RPiPowerBox::persistOutputs()
+{
+    outputsChanged = true;
+}
 
-bool RPiPowerBox::initGPIO()
+void RPiPowerBox::saveOutputs()
 {
-    // Connect to the pigpio daemon.
-    piId = pigpio_start(NULL, NULL);
-    if (piId < 0)
+    if (outputsChanged)
     {
-        LOG_ERROR("Failed to connect to pigpio daemon.");
-        return false;
+        outputsChanged = false;
+        saveConfig(true);
     }
-    LOGF_INFO("pigpio version: %d", get_pigpio_version(piId));
-    LOGF_INFO("hardware revision:  %d", get_hardware_revision(piId));
+}
 
-    // Configure the main power GPIO pin.
-    if (get_mode(piId, RPI_PB_GPIO_POWER) != PI_OUTPUT)
+unsigned RPiPowerBox::heaterFrequency(const ChannelConfig &channel) const
+{
+    if (channel.frequency != 0 && selectedHeaterPWMMode() != PWMMode::STAGGERED)
     {
-        set_mode(piId, RPI_PB_GPIO_POWER, PI_OUTPUT);
-        gpio_write(piId, RPI_PB_GPIO_POWER, PI_HIGH);
+        return channel.frequency;
     }
+    return static_cast<unsigned>(HeaterPWMFreqNP[0].getValue());
+}
 
-    // Configure the auxiliary GPIO pin.
-    if (get_mode(piId, RPI_PB_GPIO_AUX) != PI_OUTPUT)
-    {
-        set_mode(piId, RPI_PB_GPIO_AUX, PI_OUTPUT);
-        gpio_write(piId, RPI_PB_GPIO_AUX, PI_HIGH);
-    }
+void RPiPowerBox::submitSwitch(INDI::PropertySwitch &switchProp, int gpioPin, bool level)
+{
+    // Acknowledge now; the completion reports what the hardware did.
+    switchProp.setState(IPS_BUSY);
+    switchProp.apply();
+
+    submitGPIO(gpioPin,
+               [gpioPin, level](GPIOBackend &backend)
+               { return backend.write(gpioPin, level); },
+               [this, &switchProp, gpioPin, level](bool ok, const std::string &error)
+               {
+                   if (!ok)
+                   {
+                       LOGF_ERROR("Failed to switch GPIO %d: %s", gpioPin, error.c_str());
+                   }
+                   switchProp.setState(!ok ? IPS_ALERT : level ? IPS_OK : IPS_IDLE);
+                   switchProp.apply();
+               });
+}
+
+void RPiPowerBox::submitGPIO(int key, GPIOCommandQueue::Operation operation, GPIOCommandQueue::Completion completion)
+{
+    // Completions flushed by Disconnect() arrive after the properties are gone.
+    // A command replaced on an output key is reported by the one replacing it;
+    // a replaced power profile may have covered other outputs, so it reports itself.
+    commands.submit(key, std::move(operation),
+                    [this, key, completion = std::move(completion)](bool ok, const std::string &error)
+                    {
+                        if (!isConnected() ||
+                            (!ok && key != RP_PB_KEY_POWER_PROFILE && error == GPIOCommandQueue::superseded))
+                        {
+                            return;
+                        }
+                        completion(ok, error);
+                    });
+}
+
+void RPiPowerBox::definePowerProfiles()
+{
+    // Configure the profile buttons; the selection shows the profile last applied.
+    PowerProfileSP[PROFILE_IMAGING].fill("PROFILE_IMAGING", "Imaging", ISS_OFF);
+    PowerProfileSP[PROFILE_PARK].fill("PROFILE_PARK", "Park", ISS_OFF);
+    PowerProfileSP[PROFILE_ALL_OFF].fill("PROFILE_ALL_OFF", "All off", ISS_OFF);
+
+    PowerProfileSP.fill(getDeviceName(),
+                        "POWER_PROFILE",
+                        "Power Profile",
+                        MAIN_CONTROL_TAB,
+                        IP_RW,
+                        ISR_ATMOST1,
+                        60,
+                        IPS_IDLE);
+
+    // Configure the profile definitions; see parsePowerProfile() for the syntax.
+    PowerProfileTP[PROFILE_IMAGING].fill("PROFILE_IMAGING", "Imaging",
+                                         "MAIN_POWER=on AUX_POWER=on HEATER_0=40 HEATER_1=40");
+    PowerProfileTP[PROFILE_PARK].fill("PROFILE_PARK", "Park",
+                                      "MAIN_POWER=on AUX_POWER=off HEATER_0=0 HEATER_1=0");
+    PowerProfileTP[PROFILE_ALL_OFF].fill("PROFILE_ALL_OFF", "All off",
+                                         "MAIN_POWER=off AUX_POWER=off HEATER_0=0 HEATER_1=0");
+
+    PowerProfileTP.fill(getDeviceName(),
+                        "POWER_PROFILE_DEFINITIONS",
+                        "Power Profiles",
+                        OPTIONS_TAB,
+                        IP_RW,
+                        60,
+                        IPS_IDLE);
+
+    // Register the update callbacks.
+    PowerProfileSP.onUpdate([this]
+                            { handlePowerProfileUpdate(); });
+    PowerProfileTP.onUpdate([this]
+                            { handlePowerProfileDefinitionsUpdate(); });
+}
 
-    // Configure the GPIO pin for Heater 0.
-    if (get_mode(piId, RP_PB_GPIO_HEATER0) != PI_OUTPUT)
+void RPiPowerBox::handlePowerProfileUpdate()
+{
+    int index = PowerProfileSP.findOnSwitchIndex();
+    if (index < 0)
     {
-        set_mode(piId, RP_PB_GPIO_HEATER0, PI_OUTPUT);
-        set_PWM_frequency(piId, RP_PB_GPIO_HEATER0, RP_PB_PWM_FREQ);
-        set_PWM_dutycycle(piId, RP_PB_GPIO_HEATER0, 0);
+        PowerProfileSP.setState(IPS_IDLE);
+        PowerProfileSP.apply();
+        return;
     }
 
-    // Configure the GPIO pin for Heater 1.
-    if (get_mode(piId, RP_PB_GPIO_HEATER1) != PI_OUTPUT)
+    PowerProfile profile;
+    std::string error;
+    if (!parsePowerProfile(PowerProfileTP[index].getText(), channels, profile, error))
     {
-        set_mode(piId, RP_PB_GPIO_HEATER1, PI_OUTPUT);
-        set_PWM_frequency(piId, RP_PB_GPIO_HEATER1, RP_PB_PWM_FREQ);
-        set_PWM_dutycycle(piId, RP_PB_GPIO_HEATER1, 0);
+        LOGF_ERROR("Power profile %s: %s", PowerProfileSP[index].getLabel(), error.c_str());
+        PowerProfileSP.reset();
+        PowerProfileSP.setState(IPS_ALERT);
+        PowerProfileSP.apply();
+        return;
     }
+    LOGF_INFO("Applying power profile %s", PowerProfileSP[index].getLabel());
 
-    LOG_INFO("GPIO successfully initialized.");
-    return true;
-}
+    // With a power sequence configured, the outputs follow its orders.
+    if (sequenced())
+    {
+        for (HeaterOutput &output : heaterOutputs)
+        {
+            if (profile.dutyCycles.count(output.channel.name))
+            {
+                releaseHeaterControl(output.NP);
+            }
+        }
 
-void RPiPowerBox::detectSensors()
-{
-    std::error_code ec;
-    std::vector<std::filesystem::directory_entry> entries;
+        PowerProfileSP.setState(IPS_BUSY);
+        PowerProfileSP.apply();
+        runSequence(currentOutputs(), profile,
+                    [this](bool ok)
+                    {
+                        // Save the state reached, also after an abort.
+                        persistOutputs();
+                        PowerProfileSP.setState(ok ? IPS_OK : IPS_ALERT);
+                        PowerProfileSP.apply();
+                    });
+        return;
+    }
+    finishSequence(false);
 
-    // Collect all entries from the W1 devices directory.
-    for (const auto &entry : fs::directory_iterator(W1_DEVICES_PATH, ec))
+    // Collect the switched outputs into a single bank write.
+    uint32_t setMask = 0;
+    uint32_t clearMask = 0;
+    for (SwitchOutput &output : switchOutputs)
     {
-        if (ec)
+        auto level = profile.levels.find(output.channel.name);
+        if (level == profile.levels.end())
         {
-            LOGF_ERROR("Error reading directory: %s", ec.message().c_str());
-            return;
+            continue;
         }
-        if (entry.is_directory())
+        (level->second ? setMask : clearMask) |= uint32_t(1) << output.channel.pin;
+        output.SP.reset();
+        output.SP[level->second ? SWITCH_ON : SWITCH_OFF].setState(ISS_ON);
+        output.SP.setState(IPS_BUSY);
+        output.SP.apply();
+    }
+
+    // Then the heaters, by pin.
+    std::vector<std::pair<int, double>> dutyCycles;
+    for (HeaterOutput &output : heaterOutputs)
+    {
+        auto dutyCycle = profile.dutyCycles.find(output.channel.name);
+        if (dutyCycle == profile.dutyCycles.end())
         {
-            entries.push_back(entry);
+            continue;
         }
+        releaseHeaterControl(output.NP);
+        output.NP[0].setValue(dutyCycle->second);
+        output.NP.setState(IPS_BUSY);
+        output.NP.apply();
+        dutyCycles.emplace_back(output.channel.pin, dutyCycle->second);
     }
 
-    // Sort entries by filename to ensure a consistent order.
-    std::sort(entries.begin(), entries.end(),
-              [](const auto &a, const auto &b)
-              {
-                  return a.path().filename().string() < b.path().filename().string();
-              });
+    persistOutputs();
+    PowerProfileSP.setState(IPS_BUSY);
+    PowerProfileSP.apply();
 
-    // Clear any existing sensors.
-    sensors.clear();
-    int count = 0;
+    submitGPIO(RP_PB_KEY_POWER_PROFILE,
+               [setMask, clearMask, dutyCycles](GPIOBackend &backend)
+               {
+                   if (!backend.writeBank(setMask, clearMask))
+                   {
+                       return false;
+                   }
+                   for (const auto &dutyCycle : dutyCycles)
+                   {
+                       if (!writeHeaterDutyCycle(backend, dutyCycle.first, dutyCycle.second))
+                       {
+                           return false;
+                       }
+                   }
+                   return true;
+               },
+               [this, profile](bool ok, const std::string &error)
+               {
+                   if (!ok)
+                   {
+                       LOGF_ERROR("Failed to apply power profile: %s", error.c_str());
+                   }
+                   for (SwitchOutput &output : switchOutputs)
+                   {
+                       auto level = profile.levels.find(output.channel.name);
+                       if (level != profile.levels.end())
+                       {
+                           output.SP.setState(!ok ? IPS_ALERT : level->second ? IPS_OK : IPS_IDLE);
+                           output.SP.apply();
+                       }
+                   }
+                   for (HeaterOutput &output : heaterOutputs)
+                   {
+                       auto dutyCycle = profile.dutyCycles.find(output.channel.name);
+                       if (dutyCycle != profile.dutyCycles.end())
+                       {
+                           output.NP.setState(!ok ? IPS_ALERT : dutyCycle->second == 0 ? IPS_IDLE : IPS_OK);
+                           output.NP.apply();
+                       }
+                   }
+                   PowerProfileSP.setState(ok ? IPS_OK : IPS_ALERT);
+                   PowerProfileSP.apply();
+               });
+}
 
-    // Populate sensors that match the expected SENSOR_PREFIX.
-    for (const auto &entry : entries)
+void RPiPowerBox::handlePowerProfileDefinitionsUpdate()
+{
+    // Invalid definitions are kept so they can be corrected, but flagged.
+    bool valid = true;
+    for (int i = 0; i < PROFILE_N; ++i)
     {
-        std::string entryName = entry.path().filename().string();
-        if (entryName.rfind(SENSOR_PREFIX, 0) == 0)
+        PowerProfile profile;
+        std::string error;
+        if (!parsePowerProfile(PowerProfileTP[i].getText(), channels, profile, error))
         {
-            LOGF_INFO("Found sensor: %s", entryName.c_str());
-            Sensor sensor;
-            sensor.id = entryName;
-            sensor.path = (entry.path() / "w1_slave").string();
-            sensors.push_back(sensor);
-            count++;
+            LOGF_ERROR("Power profile %s: %s", PowerProfileTP[i].getLabel(), error.c_str());
+            valid = false;
         }
     }
+
+    PowerProfileTP.setState(valid ? IPS_OK : IPS_ALERT);
+    PowerProfileTP.apply();
 }
 
-void RPiPowerBox::updateTemperatureReadings()
+void RPiPowerBox::handleHeaterUpdate(HeaterOutput &output)
 {
-    // Read and update temperature for each detected sensor.
-    for (size_t i = 0; i < sensors.size(); ++i)
+    INDI::PropertyNumber &heaterProp = output.NP;
+    int gpioPin = output.channel.pin;
+    const std::string &heaterName = output.channel.name;
+
+    // Retrieve the heater value and update the corresponding PWM duty cycle.
+    double heaterValue = heaterProp[0].getValue();
+    if (heldBySequence(gpioPin, heaterValue))
     {
-        std::ifstream sensorFile(sensors[i].path);
-        if (!sensorFile.is_open())
-        {
-            LOGF_ERROR("Failed to open sensor file: %s", sensors[i].path.c_str());
-            return;
-        }
+        heaterProp.setState(IPS_BUSY);
+        heaterProp.apply();
+        return;
+    }
 
-        std::string line;
-        std::getline(sensorFile, line);
-        // Check for valid sensor data.
-        if (line.find("YES") == std::string::npos)
-        {
-            LOGF_ERROR("CRC check failed for sensor: %s", sensors[i].id.c_str());
-            return;
-        }
+    // The configuration loaded after the first connection repeats the state
+    // initGPIO() wrote, and must not release a restored closed loop.
+    bool restored = output.restoredDutyCycle == heaterValue;
+    output.restoredDutyCycle = -1;
+    if (restored)
+    {
+        heaterProp.setState(heaterValue == 0 ? IPS_IDLE : IPS_OK);
+        heaterProp.apply();
+        return;
+    }
+    LOGF_INFO("Setting %s to %.2f%%", heaterName.c_str(), heaterValue);
 
-        std::getline(sensorFile, line);
-        size_t pos = line.find("t=");
-        if (pos == std::string::npos)
-        {
-            LOGF_ERROR("Failed to read temperature for sensor: %s", sensors[i].id.c_str());
-            return;
-        }
+    // A duty cycle set by hand overrides closed-loop control.
+    releaseHeaterControl(heaterProp);
+    submitHeaterDutyCycle(heaterProp, gpioPin, heaterName, heaterValue);
+    persistOutputs();
+}
 
-        // Convert the sensor reading to a temperature in degrees Celsius.
-        float temp = std::stof(line.substr(pos + 2)) / 1000;
-        TempNP[i].setValue(temp);
+void RPiPowerBox::submitHeaterDutyCycle(INDI::PropertyNumber &heaterProp, int gpioPin, const std::string &heaterName,
+                                        double dutyCycle)
+{
+    // Acknowledge now; a slider drag collapses into its latest value in the queue.
+    heaterProp[0].setValue(dutyCycle);
+    heaterProp.setState(IPS_BUSY);
+    heaterProp.apply();
+
+    submitGPIO(gpioPin,
+               [gpioPin, dutyCycle](GPIOBackend &backend)
+               { return writeHeaterDutyCycle(backend, gpioPin, dutyCycle); },
+               [this, &heaterProp, heaterName, dutyCycle](bool ok, const std::string &error)
+               {
+                   // Update the property state based on the heater value.
+                   if (!ok)
+                   {
+                       LOGF_ERROR("Failed to set %s duty cycle: %s", heaterName.c_str(), error.c_str());
+                       heaterProp.setState(IPS_ALERT);
+                   }
+                   else
+                   {
+                       heaterProp.setState(dutyCycle == 0 ? IPS_IDLE : IPS_OK);
+                   }
+                   heaterProp.apply();
+               });
+}
+
+void RPiPowerBox::releaseHeaterControl(INDI::PropertyNumber &heaterProp)
+{
+    for (HeaterLoop &loop : heaterLoops)
+    {
+        if (loop.heaterProp == &heaterProp && loop.ModeSP.findOnSwitchIndex() != CONTROL_MANUAL)
+        {
+            LOGF_INFO("%s set by hand, switching to manual control.", loop.name.c_str());
+            loop.ModeSP.reset();
+            loop.ModeSP[CONTROL_MANUAL].setState(ISS_ON);
+            loop.ModeSP.setState(IPS_IDLE);
+            loop.ModeSP.apply();
+            loop.LoopNP.setState(IPS_IDLE);
+            loop.LoopNP.apply();
+        }
+    }
+}
+
+void RPiPowerBox::defineHeaterPWM()
+{
+    // Configure the PWM mode options; GPIO 12 and 13 are the PWM0/PWM1 channels.
+    // Staggered PWM interleaves the heaters' on-times to lower the peak current.
+    HeaterPWMModeSP[PWM_HARDWARE].fill("PWM_HARDWARE", "Hardware", ISS_ON);
+    HeaterPWMModeSP[PWM_SOFTWARE].fill("PWM_SOFTWARE", "Software", ISS_OFF);
+    HeaterPWMModeSP[PWM_STAGGERED].fill("PWM_STAGGERED", "Staggered", ISS_OFF);
+
+    HeaterPWMModeSP.fill(getDeviceName(),
+                         "HEATER_PWM_MODE",
+                         "Heater PWM",
+                         OPTIONS_TAB,
+                         IP_RW,
+                         ISR_1OFMANY,
+                         60,
+                         IPS_IDLE);
+
+    // Configure the PWM carrier frequency.
+    HeaterPWMFreqNP[0].fill("PWM_FREQ",
+                            "Frequency (Hz)",
+                            "%0.f",
+                            10,
+                            30000,
+                            100,
+                            RP_PB_PWM_FREQ);
+
+    HeaterPWMFreqNP.fill(getDeviceName(),
+                         "HEATER_PWM_FREQ",
+                         "Heater PWM",
+                         OPTIONS_TAB,
+                         IP_RW,
+                         60,
+                         IPS_IDLE);
+
+    // Register update callbacks.
+    HeaterPWMModeSP.onUpdate([this]
+                             { handleHeaterPWMUpdate(); });
+    HeaterPWMFreqNP.onUpdate([this]
+                             { handleHeaterPWMUpdate(); });
+}
+
+void RPiPowerBox::handleHeaterPWMUpdate()
+{
+    // Reconfigure every heater, starting at its current duty cycle.
+    if (!gpio)
+    {
+        // Applied by initGPIO() on the next connection.
+        HeaterPWMModeSP.setState(IPS_IDLE);
+        HeaterPWMModeSP.apply();
+        HeaterPWMFreqNP.setState(IPS_IDLE);
+        HeaterPWMFreqNP.apply();
+        return;
+    }
+
+    // Collect every heater's pin, frequency and current duty cycle.
+    struct Heater
+    {
+        int pin;
+        unsigned frequency;
+        double dutyCycle;
+    };
+    std::vector<Heater> heaters;
+    std::string frequencies;
+    for (const HeaterOutput &output : heaterOutputs)
+    {
+        unsigned frequency = heaterFrequency(output.channel);
+        heaters.push_back({output.channel.pin, frequency, output.NP[0].getValue()});
+        frequencies += (frequencies.empty() ? "" : ", ") + output.channel.name + " " + std::to_string(frequency) + " Hz";
+    }
+    PWMMode requested = selectedHeaterPWMMode();
+    auto used = std::make_shared<PWMMode>(requested);
+
+    HeaterPWMModeSP.setState(IPS_BUSY);
+    HeaterPWMModeSP.apply();
+    HeaterPWMFreqNP.setState(IPS_BUSY);
+    HeaterPWMFreqNP.apply();
+
+    submitGPIO(RP_PB_KEY_HEATER_PWM,
+               [heaters, used](GPIOBackend &backend)
+               {
+                   for (const Heater &heater : heaters)
+                   {
+                       if (!setupHeaterPWM(backend, heater.pin, heater.frequency, *used,
+                                           std::min(std::max(heater.dutyCycle, 0.0), 100.0)))
+                       {
+                           return false;
+                       }
+                   }
+                   return true;
+               },
+               [this, requested, used, frequencies](bool ok, const std::string &error)
+               {
+                   applyHeaterPWMMode(requested, *used);
+                   if (ok)
+                   {
+                       LOGF_INFO("Heater PWM: %s, %s",
+                                 HeaterPWMModeSP[heaterPWMModeIndex(*used)].getLabel(), frequencies.c_str());
+                   }
+                   else
+                   {
+                       LOGF_ERROR("Failed to configure heater PWM: %s", error.c_str());
+                   }
+
+                   HeaterPWMModeSP.setState(ok ? IPS_OK : IPS_ALERT);
+                   HeaterPWMModeSP.apply();
+                   HeaterPWMFreqNP.setState(ok ? IPS_OK : IPS_ALERT);
+                   HeaterPWMFreqNP.apply();
+               });
+}
+
+bool RPiPowerBox::configureHeaterPWM(const ChannelConfig &channel, double dutyCycle)
+{
+    PWMMode requested = selectedHeaterPWMMode();
+    PWMMode used = requested;
+
+    bool rv = setupHeaterPWM(*gpio, channel.pin, heaterFrequency(channel), used, dutyCycle);
+    applyHeaterPWMMode(requested, used);
+    if (!rv)
+    {
+        LOGF_ERROR("PWM unavailable on GPIO %d: %s", channel.pin, gpio->lastError().c_str());
+    }
+    return rv;
+}
+
+bool RPiPowerBox::setupHeaterPWM(GPIOBackend &backend, int gpioPin, unsigned frequency, PWMMode &mode,
+                                 double dutyCycle)
+{
+    // Try the requested mode, then fall back to hardware and software PWM,
+    // whichever the backend offers on this pin; mode returns the one used.
+    const PWMMode candidates[] = {mode, PWMMode::HARDWARE, PWMMode::SOFTWARE};
+    for (size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); ++i)
+    {
+        if (i > 0 && candidates[i] == candidates[0])
+        {
+            continue;
+        }
+        if (backend.supportsPWM(gpioPin, candidates[i]) &&
+            backend.setupPWM(gpioPin, frequency, candidates[i], dutyCycle))
+        {
+            mode = candidates[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+PWMMode RPiPowerBox::selectedHeaterPWMMode() const
+{
+    switch (HeaterPWMModeSP.findOnSwitchIndex())
+    {
+    case PWM_SOFTWARE:
+        return PWMMode::SOFTWARE;
+    case PWM_STAGGERED:
+        return PWMMode::STAGGERED;
+    default:
+        return PWMMode::HARDWARE;
+    }
+}
+
+int RPiPowerBox::heaterPWMModeIndex(PWMMode mode)
+{
+    switch (mode)
+    {
+    case PWMMode::SOFTWARE:
+        return PWM_SOFTWARE;
+    case PWMMode::STAGGERED:
+        return PWM_STAGGERED;
+    default:
+        return PWM_HARDWARE;
+    }
+}
+
+void RPiPowerBox::applyHeaterPWMMode(PWMMode requested, PWMMode used)
+{
+    if (used == requested)
+    {
+        return;
+    }
+
+    LOGF_WARN("%s PWM unavailable, falling back to %s PWM.",
+              HeaterPWMModeSP[heaterPWMModeIndex(requested)].getLabel(),
+              HeaterPWMModeSP[heaterPWMModeIndex(used)].getLabel());
+    HeaterPWMModeSP.reset();
+    HeaterPWMModeSP[heaterPWMModeIndex(used)].setState(ISS_ON);
+}
+
+bool RPiPowerBox::writeHeaterDutyCycle(GPIOBackend &backend, int gpioPin, double dutyCycle)
+{
+    return backend.writePWM(gpioPin, std::min(std::max(dutyCycle, 0.0), 100.0));
+}
+
+void RPiPowerBox::defineTemperatureProbes()
+{
+    // Show as many decimals as the sensor resolution provides (0.5 to 0.0625 degrees).
+    int decimals = temperatureResolution() - 8;
+    std::string format = "%0." + std::to_string(decimals) + "f";
+    double step = 1.0 / (1 << decimals);
+
+    // Give a property one element per sensor, named by sensor ID so elements
+    // stay stable when sensors come and go; remaining sensors keep their values.
+    auto fillSensors = [this](INDI::PropertyNumber &property, const char *numberFormat, double min, double max,
+                              double numberStep)
+    {
+        std::map<std::string, double> previous;
+        for (size_t i = 0; i < property.size(); ++i)
+        {
+            previous[property[i].getName()] = property[i].getValue();
+        }
+
+        property.resize(sensors.size());
+        for (size_t i = 0; i < sensors.size(); ++i)
+        {
+            std::string name = "TEMP_" + sensors[i].id;
+            property[i].fill(name.c_str(),
+                             sensors[i].id.c_str(),
+                             numberFormat,
+                             min,
+                             max,
+                             numberStep,
+                             0);
+            auto value = previous.find(name);
+            if (value != previous.end())
+            {
+                property[i].setValue(value->second);
+            }
+        }
+    };
+
+    // Configure the overall temperature property.
+    fillSensors(TempNP, format.c_str(), -50, 50, step);
+    TempNP.fill(getDeviceName(),
+                "TEMP",
+                "Temp Sensors",
+                MAIN_CONTROL_TAB,
+                IP_RO,
+                sensors.size(),
+                IPS_IDLE);
+
+    // Health lights start idle until the first pass over the sensor.
+    std::map<std::string, IPState> previousHealth;
+    for (size_t i = 0; i < TempHealthLP.size(); ++i)
+    {
+        previousHealth[TempHealthLP[i].getName()] = TempHealthLP[i].getState();
+    }
+    TempHealthLP.resize(sensors.size());
+    for (size_t i = 0; i < sensors.size(); ++i)
+    {
+        std::string name = "TEMP_" + sensors[i].id;
+        auto state = previousHealth.find(name);
+        TempHealthLP[i].fill(name.c_str(), sensors[i].id.c_str(),
+                             state != previousHealth.end() ? state->second : IPS_IDLE);
+    }
+    TempHealthLP.fill(getDeviceName(),
+                      "TEMP_HEALTH",
+                      "Sensor Health",
+                      MAIN_CONTROL_TAB,
+                      IPS_IDLE);
+
+    // Define the statistics with one element per sensor, named like the readings.
+    static const struct
+    {
+        const char *name;
+        const char *label;
+        bool temperature;
+    } statistics[STAT_N] = {
+        {"TEMP_SLOPE", "Temp Slope (C/min)", false},
+        {"TEMP_MIN", "Temp Min", true},
+        {"TEMP_MAX", "Temp Max", true},
+        {"TEMP_MEAN", "Temp Mean", true},
+        {"TEMP_COUNT", "Temp Samples", false},
+    };
+
+    for (int s = 0; s < STAT_N; ++s)
+    {
+        INDI::PropertyNumber &property = tempStatistics[s].NP;
+        const char *statisticFormat = statistics[s].temperature ? format.c_str() : s == STAT_SLOPE ? "%0.3f" : "%0.f";
+        fillSensors(property,
+                    statisticFormat,
+                    s == STAT_COUNT ? 0 : -100,
+                    s == STAT_COUNT ? TemperatureSampler::historyCapacity : 100,
+                    0);
+        property.fill(getDeviceName(),
+                      statistics[s].name,
+                      statistics[s].label,
+                      TRENDS_TAB,
+                      IP_RO,
+                      60,
+                      IPS_IDLE);
+    }
+
+    // Define the error counters the same way.
+    static const struct
+    {
+        const char *name;
+        const char *label;
+    } counters[COUNTER_N] = {
+        {"TEMP_CRC_ERRORS", "CRC Errors"},
+        {"TEMP_OPEN_ERRORS", "Open Errors"},
+        {"TEMP_PARSE_ERRORS", "Parse Errors"},
+        {"TEMP_RETRIES", "Retried Reads"},
+    };
+
+    for (int c = 0; c < COUNTER_N; ++c)
+    {
+        INDI::PropertyNumber &property = tempCounters[c].NP;
+        fillSensors(property, "%0.f", 0, 1e12, 0);
+        property.fill(getDeviceName(),
+                      counters[c].name,
+                      counters[c].label,
+                      SENSOR_HEALTH_TAB,
+                      IP_RO,
+                      60,
+                      IPS_IDLE);
+    }
+}
+
+void RPiPowerBox::publishTemperatureProperties()
+{
+    defineProperty(TempNP);
+    defineProperty(TempHealthLP);
+    tempPublisher.reset();
+    for (TemperatureStatistic &statistic : tempStatistics)
+    {
+        defineProperty(statistic.NP);
+        statistic.publisher.reset();
+    }
+    for (TemperatureStatistic &counter : tempCounters)
+    {
+        defineProperty(counter.NP);
+        counter.publisher.reset();
+    }
+}
+
+void RPiPowerBox::withdrawTemperatureProperties()
+{
+    deleteProperty(TempNP);
+    deleteProperty(TempHealthLP);
+    for (TemperatureStatistic &statistic : tempStatistics)
+    {
+        deleteProperty(statistic.NP);
+    }
+    for (TemperatureStatistic &counter : tempCounters)
+    {
+        deleteProperty(counter.NP);
+    }
+}
+
+void RPiPowerBox::defineTemperatureRetries()
+{
+    // Configure how failed reads are retried within a pass.
+    TempRetryNP[RETRY_BUDGET].fill("RETRY_BUDGET",
+                                   "Retries per pass",
+                                   "%0.f",
+                                   0,
+                                   5,
+                                   1,
+                                   RP_PB_READ_RETRIES);
+    TempRetryNP[RETRY_FAILED_PASSES].fill("RETRY_FAILED_PASSES",
+                                          "Failed passes",
+                                          "%0.f",
+                                          1,
+                                          60,
+                                          1,
+                                          RP_PB_FAILED_PASSES);
+
+    TempRetryNP.fill(getDeviceName(),
+                     "TEMP_RETRY",
+                     "Read Retries",
+                     SENSOR_HEALTH_TAB,
+                     IP_RW,
+                     60,
+                     IPS_IDLE);
+
+    // Register the update callback.
+    TempRetryNP.onUpdate([this]
+                         { handleTemperatureRetriesUpdate(); });
+}
+
+void RPiPowerBox::handleTemperatureRetriesUpdate()
+{
+    sampler.setRetryPolicy(static_cast<int>(TempRetryNP[RETRY_BUDGET].getValue()),
+                           static_cast<int>(TempRetryNP[RETRY_FAILED_PASSES].getValue()));
+
+    TempRetryNP.setState(IPS_OK);
+    TempRetryNP.apply();
+}
+
+void RPiPowerBox::defineTemperatureHistory()
+{
+    // Configure the statistics window; the sampler keeps at most historyCapacity samples.
+    TempHistoryNP[0].fill("HISTORY_WINDOW",
+                          "Window (min)",
+                          "%0.f",
+                          1,
+                          240,
+                          1,
+                          RP_PB_HISTORY_WINDOW);
+
+    TempHistoryNP.fill(getDeviceName(),
+                       "TEMP_HISTORY_WINDOW",
+                       "Statistics",
+                       TRENDS_TAB,
+                       IP_RW,
+                       60,
+                       IPS_IDLE);
+
+    // Register the update callback.
+    TempHistoryNP.onUpdate([this]
+                           { handleTemperatureHistoryUpdate(); });
+}
+
+void RPiPowerBox::handleTemperatureHistoryUpdate()
+{
+    // Samples outside a shorter window are dropped; a longer one fills up over time.
+    sampler.setHistoryWindow(std::chrono::minutes(static_cast<int>(TempHistoryNP[0].getValue())));
+    LOGF_INFO("Temperature statistics over the last %.0f minutes", TempHistoryNP[0].getValue());
+
+    TempHistoryNP.setState(IPS_OK);
+    TempHistoryNP.apply();
+}
+
+void RPiPowerBox::defineTemperatureAcquisition()
+{
+    // Configure the acquisition mode options.
+    TempAcquisitionSP[TEMP_ACQ_BULK].fill("TEMP_ACQ_BULK", "Bulk", ISS_ON);
+    TempAcquisitionSP[TEMP_ACQ_SEQUENTIAL].fill("TEMP_ACQ_SEQUENTIAL", "Per sensor", ISS_OFF);
+
+    TempAcquisitionSP.fill(getDeviceName(),
+                           "TEMP_ACQUISITION",
+                           "Temp Acquisition",
+                           OPTIONS_TAB,
+                           IP_RW,
+                           ISR_1OFMANY,
+                           60,
+                           IPS_IDLE);
+
+    // Register the update callback.
+    TempAcquisitionSP.onUpdate([this]
+                               { handleTemperatureAcquisitionUpdate(); });
+}
+
+void RPiPowerBox::handleTemperatureAcquisitionUpdate()
+{
+    // Buses without therm_bulk_read always fall back to per-sensor reads.
+    bool bulk = TempAcquisitionSP.findOnSwitchIndex() == TEMP_ACQ_BULK;
+    sampler.setBulkRead(bulk);
+    updatePassDuration();
+    sampler.setPeriod(acquisitionPeriod());
+    LOGF_INFO("Temperature acquisition: %s", bulk ? "bulk" : "per sensor");
+
+    TempAcquisitionSP.setState(IPS_OK);
+    TempAcquisitionSP.apply();
+}
+
+void RPiPowerBox::defineTemperatureResolution()
+{
+    // Configure the resolution options; 12 bits is the power-on default.
+    TempResolutionSP[TEMP_RES_9].fill("TEMP_RES_9", "9 bits (0.5 C, 94 ms)", ISS_OFF);
+    TempResolutionSP[TEMP_RES_10].fill("TEMP_RES_10", "10 bits (0.25 C, 188 ms)", ISS_OFF);
+    TempResolutionSP[TEMP_RES_11].fill("TEMP_RES_11", "11 bits (0.125 C, 375 ms)", ISS_OFF);
+    TempResolutionSP[TEMP_RES_12].fill("TEMP_RES_12", "12 bits (0.0625 C, 750 ms)", ISS_ON);
+
+    TempResolutionSP.fill(getDeviceName(),
+                          "TEMP_RESOLUTION",
+                          "Temp Resolution",
+                          OPTIONS_TAB,
+                          IP_RW,
+                          ISR_1OFMANY,
+                          60,
+                          IPS_IDLE);
+
+    // Register the update callback.
+    TempResolutionSP.onUpdate([this]
+                              { handleTemperatureResolutionUpdate(); });
+}
+
+void RPiPowerBox::handleTemperatureResolutionUpdate()
+{
+    // The sampler writes the sysfs attributes before its next pass and
+    // reports back through the snapshot; see updateTemperatureReadings().
+    int bits = temperatureResolution();
+    sampler.setResolution(bits);
+    updatePassDuration();
+    sampler.setPeriod(acquisitionPeriod());
+    LOGF_INFO("Setting temperature resolution to %d bits", bits);
+
+    TempResolutionSP.setState(IPS_BUSY);
+    TempResolutionSP.apply();
+}
+
+int RPiPowerBox::temperatureResolution() const
+{
+    int index = TempResolutionSP.findOnSwitchIndex();
+    return index < 0 ? 12 : 9 + index;
+}
+
+std::chrono::milliseconds RPiPowerBox::acquisitionPeriod() const
+{
+    return std::max(scheduler.period(TASK_SAMPLE), passDuration);
+}
+
+void RPiPowerBox::updatePassDuration()
+{
+    // A bulk pass costs one conversion per bus master, otherwise one per sensor.
+    size_t conversions = sensors.size();
+    if (TempAcquisitionSP.findOnSwitchIndex() == TEMP_ACQ_BULK)
+    {
+        std::set<std::string> masters;
+        size_t sequential = 0;
+        for (const Sensor &sensor : sensors)
+        {
+            if (TemperatureSampler::supportsBulkRead(sensor.master))
+            {
+                masters.insert(sensor.master);
+            }
+            else
+            {
+                sequential++;
+            }
+        }
+        conversions = masters.size() + sequential;
+    }
+
+    passDuration = TemperatureSampler::conversionTime(temperatureResolution()) * static_cast<int>(conversions);
+}
+
+// ============================================================================
+// Power Sequencing
+// ============================================================================
+
+void RPiPowerBox::defineSequencer()
+{
+    // Configure the orders; see parsePowerSequence() for the syntax.
+    SequenceOrderTP[SEQ_ORDER_UP].fill("SEQUENCE_UP", "Power up", RP_PB_SEQUENCE_UP);
+    SequenceOrderTP[SEQ_ORDER_DOWN].fill("SEQUENCE_DOWN", "Power down", RP_PB_SEQUENCE_DOWN);
+    SequenceOrderTP.fill(getDeviceName(),
+                         "POWER_SEQUENCE_ORDER",
+                         "Power Sequence",
+                         OPTIONS_TAB,
+                         IP_RW,
+                         60,
+                         IPS_IDLE);
+
+    // Configure whether the outputs come up in order when connecting.
+    SequenceStartupSP[SEQ_STARTUP_SEQUENCED].fill("SEQUENCE_STARTUP_SEQUENCED", "Sequenced", ISS_OFF);
+    SequenceStartupSP[SEQ_STARTUP_IMMEDIATE].fill("SEQUENCE_STARTUP_IMMEDIATE", "Immediate", ISS_ON);
+    SequenceStartupSP.fill(getDeviceName(),
+                           "POWER_SEQUENCE_STARTUP",
+                           "Startup",
+                           OPTIONS_TAB,
+                           IP_RW,
+                           ISR_1OFMANY,
+                           60,
+                           IPS_IDLE);
+
+    // Configure the progress of the running sequence and its abort button.
+    SequenceProgressNP[SEQ_STEP].fill("SEQUENCE_STEP", "Step", "%0.f", 0, 1000, 0, 0);
+    SequenceProgressNP[SEQ_STEPS].fill("SEQUENCE_STEPS", "Steps", "%0.f", 0, 1000, 0, 0);
+    SequenceProgressNP[SEQ_PROGRESS].fill("SEQUENCE_PROGRESS", "Progress (%)", "%0.f", 0, 100, 0, 0);
+    SequenceProgressNP.fill(getDeviceName(),
+                            "POWER_SEQUENCE_PROGRESS",
+                            "Power Sequence",
+                            MAIN_CONTROL_TAB,
+                            IP_RO,
+                            60,
+                            IPS_IDLE);
+
+    SequenceAbortSP[0].fill("SEQUENCE_ABORT", "Abort", ISS_OFF);
+    SequenceAbortSP.fill(getDeviceName(),
+                         "POWER_SEQUENCE_ABORT",
+                         "Power Sequence",
+                         MAIN_CONTROL_TAB,
+                         IP_RW,
+                         ISR_ATMOST1,
+                         60,
+                         IPS_IDLE);
+
+    // Register the update callbacks.
+    SequenceOrderTP.onUpdate([this]
+                             { handleSequenceOrderUpdate(); });
+    SequenceStartupSP.onUpdate([this]
+                               { handleSequenceStartupUpdate(); });
+    SequenceAbortSP.onUpdate([this]
+                             { handleSequenceAbortUpdate(); });
+}
+
+void RPiPowerBox::handleSequenceOrderUpdate()
+{
+    // Invalid orders are kept so they can be corrected, but flagged.
+    bool valid = true;
+    for (int i = 0; i < SEQ_ORDER_N; ++i)
+    {
+        std::vector<SequenceEntry> entries;
+        std::string error;
+        if (!parsePowerSequence(SequenceOrderTP[i].getText(), channels, entries, error))
+        {
+            LOGF_ERROR("%s order: %s", SequenceOrderTP[i].getLabel(), error.c_str());
+            valid = false;
+        }
+    }
+
+    SequenceOrderTP.setState(valid ? IPS_OK : IPS_ALERT);
+    SequenceOrderTP.apply();
+}
+
+void RPiPowerBox::handleSequenceStartupUpdate()
+{
+    // Applied by initGPIO() on the next connection.
+    SequenceStartupSP.setState(IPS_OK);
+    SequenceStartupSP.apply();
+}
+
+void RPiPowerBox::handleSequenceAbortUpdate()
+{
+    SequenceAbortSP.reset();
+    if (sequenceDone)
+    {
+        finishSequence(false);
+        SequenceAbortSP.setState(IPS_OK);
+    }
+    else
+    {
+        LOG_INFO("No power sequence is running.");
+        SequenceAbortSP.setState(IPS_IDLE);
+    }
+    SequenceAbortSP.apply();
+}
+
+bool RPiPowerBox::sequenced() const
+{
+    for (int i = 0; i < SEQ_ORDER_N; ++i)
+    {
+        if (std::string(SequenceOrderTP[i].getText()).find_first_not_of(" \t\r\n") != std::string::npos)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+PowerProfile RPiPowerBox::currentOutputs() const
+{
+    PowerProfile state;
+    for (const SwitchOutput &output : switchOutputs)
+    {
+        state.levels[output.channel.name] = output.SP.findOnSwitchIndex() == SWITCH_ON;
+    }
+    for (const HeaterOutput &output : heaterOutputs)
+    {
+        state.dutyCycles[output.channel.name] = output.NP[0].getValue();
+    }
+    return state;
+}
+
+PowerProfile RPiPowerBox::takeStartupOutputs()
+{
+    PowerProfile targets;
+    if (SequenceStartupSP.findOnSwitchIndex() != SEQ_STARTUP_SEQUENCED)
+    {
+        return targets;
+    }
+
+    std::vector<SequenceEntry> order;
+    std::string error;
+    if (!parsePowerSequence(SequenceOrderTP[SEQ_ORDER_UP].getText(), channels, order, error))
+    {
+        LOGF_ERROR("%s order: %s", SequenceOrderTP[SEQ_ORDER_UP].getLabel(), error.c_str());
+        return targets;
+    }
+
+    std::set<std::string> names;
+    for (const SequenceEntry &entry : order)
+    {
+        names.insert(entry.name);
+    }
+
+    // Outputs that are already on, e.g. after a driver restart, stay on; a
+    // pin whose state cannot be read back counts as off.
+    auto live = [this](int gpioPin)
+    {
+        bool on = false;
+        return gpio->readOutput(gpioPin, on) && on;
+    };
+
+    for (SwitchOutput &output : switchOutputs)
+    {
+        if (names.count(output.channel.name) && output.SP.findOnSwitchIndex() == SWITCH_ON &&
+            !live(output.channel.pin))
+        {
+            targets.levels[output.channel.name] = true;
+            output.SP.reset();
+            output.SP[SWITCH_OFF].setState(ISS_ON);
+            output.SP.setState(IPS_IDLE);
+        }
+    }
+    for (HeaterOutput &output : heaterOutputs)
+    {
+        if (names.count(output.channel.name) && output.NP[0].getValue() > 0 && !live(output.channel.pin))
+        {
+            targets.dutyCycles[output.channel.name] = output.NP[0].getValue();
+            output.NP[0].setValue(0);
+            output.NP.setState(IPS_IDLE);
+        }
+    }
+    return targets;
+}
+
+void RPiPowerBox::runSequence(const PowerProfile &from, const PowerProfile &to, std::function<void(bool ok)> done)
+{
+    if (sequenceDone)
+    {
+        LOG_WARN("Power sequence replaced by a new one.");
+        finishSequence(false);
+    }
+
+    // An invalid order leaves its direction unordered.
+    std::vector<SequenceEntry> orders[SEQ_ORDER_N];
+    for (int i = 0; i < SEQ_ORDER_N; ++i)
+    {
+        std::string error;
+        if (!parsePowerSequence(SequenceOrderTP[i].getText(), channels, orders[i], error))
+        {
+            LOGF_ERROR("%s order: %s", SequenceOrderTP[i].getLabel(), error.c_str());
+        }
+    }
+
+    // Collect the outputs that change, and the direction they change in.
+    struct Change
+    {
+        std::string name;
+        int pin;
+        bool up;
+        SequencedOutput output;
+        PowerSequencer::Step step;
+    };
+    std::vector<Change> changes;
+    for (SwitchOutput &output : switchOutputs)
+    {
+        auto target = to.levels.find(output.channel.name);
+        auto current = from.levels.find(output.channel.name);
+        bool level = current != from.levels.end() && current->second;
+        if (target == to.levels.end() || target->second == level)
+        {
+            continue;
+        }
+
+        Change change{output.channel.name, output.channel.pin, target->second, {}, {}};
+        change.output.switchOutput = &output;
+        change.step.kind = ChannelKind::SWITCH;
+        change.step.from = level ? 1 : 0;
+        change.step.to = target->second ? 1 : 0;
+        changes.push_back(change);
+    }
+    for (HeaterOutput &output : heaterOutputs)
+    {
+        auto target = to.dutyCycles.find(output.channel.name);
+        auto current = from.dutyCycles.find(output.channel.name);
+        double dutyCycle = current != from.dutyCycles.end() ? current->second : 0;
+        if (target == to.dutyCycles.end() || target->second == dutyCycle)
+        {
+            continue;
+        }
+
+        Change change{output.channel.name, output.channel.pin, target->second > dutyCycle, {}, {}};
+        change.output.heaterOutput = &output;
+        change.step.kind = ChannelKind::PWM;
+        change.step.from = dutyCycle;
+        change.step.to = target->second;
+        changes.push_back(change);
+    }
+
+    auto ordered = [&orders](const Change &change)
+    {
+        const std::vector<SequenceEntry> &order = orders[change.up ? SEQ_ORDER_UP : SEQ_ORDER_DOWN];
+        return std::any_of(order.begin(), order.end(), [&change](const SequenceEntry &entry)
+                           { return entry.name == change.name; });
+    };
+
+    // Unordered outputs change at once, then the power-down order runs, then the power-up order.
+    std::vector<PowerSequencer::Step> steps;
+    std::vector<SequencedOutput> outputs;
+    for (const Change &change : changes)
+    {
+        if (!ordered(change))
+        {
+            steps.push_back(change.step);
+            outputs.push_back(change.output);
+        }
+    }
+    for (int direction : {SEQ_ORDER_DOWN, SEQ_ORDER_UP})
+    {
+        for (const SequenceEntry &entry : orders[direction])
+        {
+            for (const Change &change : changes)
+            {
+                if (change.name == entry.name && change.up == (direction == SEQ_ORDER_UP))
+                {
+                    PowerSequencer::Step step = change.step;
+                    step.delay = entry.delay;
+                    step.ramp = entry.ramp;
+                    steps.push_back(step);
+                    outputs.push_back(change.output);
+                }
+            }
+        }
+    }
+
+    if (steps.empty())
+    {
+        done(true);
+        return;
+    }
+
+    for (const Change &change : changes)
+    {
+        sequenceTargets[change.pin] = change.step.to;
+    }
+    sequenceDone = std::move(done);
+
+    LOGF_INFO("Power sequence started: %zu step(s).", steps.size());
+    SequenceProgressNP[SEQ_STEP].setValue(0);
+    SequenceProgressNP[SEQ_STEPS].setValue(steps.size());
+    SequenceProgressNP[SEQ_PROGRESS].setValue(0);
+    SequenceProgressNP.setState(IPS_BUSY);
+    SequenceProgressNP.apply();
+
+    sequencer.start(std::move(steps),
+                    [this, outputs](size_t step, double value)
+                    { writeSequenced(outputs[step], value); },
+                    [this](size_t step, double percent)
+                    {
+                        SequenceProgressNP[SEQ_STEP].setValue(step);
+                        SequenceProgressNP[SEQ_PROGRESS].setValue(percent);
+                        SequenceProgressNP.apply();
+                    },
+                    [this](std::chrono::microseconds lateness)
+                    {
+                        LOGF_INFO("Power sequence complete; writes started at most %.1f ms late.",
+                                  lateness.count() / 1000.0);
+
+                        // Report once the last writes have been confirmed.
+                        submitGPIO(RP_PB_KEY_SEQUENCE,
+                                   [](GPIOBackend &)
+                                   { return true; },
+                                   [this](bool, const std::string &)
+                                   { finishSequence(true); });
+                    });
+}
+
+void RPiPowerBox::writeSequenced(const SequencedOutput &output, double value)
+{
+    if (SwitchOutput *switchOutput = output.switchOutput)
+    {
+        int gpioPin = switchOutput->channel.pin;
+        bool level = value != 0;
+        submitGPIO(gpioPin,
+                   [gpioPin, level](GPIOBackend &backend)
+                   { return backend.write(gpioPin, level); },
+                   [this, switchOutput, level](bool ok, const std::string &error)
+                   {
+                       INDI::PropertySwitch &switchProp = switchOutput->SP;
+                       if (ok)
+                       {
+                           switchProp.reset();
+                           switchProp[level ? SWITCH_ON : SWITCH_OFF].setState(ISS_ON);
+                       }
+                       else
+                       {
+                           LOGF_ERROR("Failed to switch %s: %s", switchOutput->channel.name.c_str(), error.c_str());
+                       }
+                       switchProp.setState(!ok ? IPS_ALERT : level ? IPS_OK : IPS_IDLE);
+                       switchProp.apply();
+                       if (!ok)
+                       {
+                           finishSequence(false);
+                       }
+                   });
+        return;
+    }
+
+    HeaterOutput *heaterOutput = output.heaterOutput;
+    int gpioPin = heaterOutput->channel.pin;
+    submitGPIO(gpioPin,
+               [gpioPin, value](GPIOBackend &backend)
+               { return writeHeaterDutyCycle(backend, gpioPin, value); },
+               [this, heaterOutput, value](bool ok, const std::string &error)
+               {
+                   INDI::PropertyNumber &heaterProp = heaterOutput->NP;
+                   if (ok)
+                   {
+                       heaterProp[0].setValue(value);
+                   }
+                   else
+                   {
+                       LOGF_ERROR("Failed to set %s duty cycle: %s", heaterOutput->channel.name.c_str(),
+                                  error.c_str());
+                   }
+                   heaterProp.setState(!ok ? IPS_ALERT : value == 0 ? IPS_IDLE : IPS_OK);
+                   heaterProp.apply();
+                   if (!ok)
+                   {
+                       finishSequence(false);
+                   }
+               });
+}
+
+void RPiPowerBox::finishSequence(bool ok)
+{
+    if (!sequenceDone)
+    {
+        return;
+    }
+
+    // Returns once no further write can be queued.
+    sequencer.abort();
+    sequenceTargets.clear();
+    if (!ok)
+    {
+        LOG_WARN("Power sequence aborted; the outputs keep the state reached.");
+    }
+
+    SequenceProgressNP.setState(ok ? IPS_OK : IPS_ALERT);
+    SequenceProgressNP.apply();
+
+    std::function<void(bool)> done = std::move(sequenceDone);
+    sequenceDone = nullptr;
+    done(ok);
+}
+
+bool RPiPowerBox::heldBySequence(int gpioPin, double value)
+{
+    auto target = sequenceTargets.find(gpioPin);
+    if (target == sequenceTargets.end())
+    {
+        return false;
+    }
+    if (std::fabs(target->second - value) < 0.005)
+    {
+        return true;
+    }
+
+    LOG_WARN("Output of the power sequence changed by hand.");
+    finishSequence(false);
+    return false;
+}
+
+// ============================================================================
+// Publishing
+// ============================================================================
+
+bool RPiPowerBox::publish(INDI::PropertyNumber &property, PublishPolicy &policy, size_t compared)
+{
+    publishValues.resize(compared);
+    for (size_t i = 0; i < compared; ++i)
+    {
+        publishValues[i] = property[i].getValue();
+    }
+
+    if (!policy.check(publishValues.data(), compared, property.getState(), std::chrono::steady_clock::now()))
+    {
+        return false;
+    }
+    property.apply();
+    return true;
+}
+
+bool RPiPowerBox::publish(INDI::PropertyNumber &property, PublishPolicy &policy)
+{
+    return publish(property, policy, property.size());
+}
+
+void RPiPowerBox::definePublishing()
+{
+    // Configure the policies: readings resend after a minute even when unchanged.
+    TempPublishNP[PUBLISH_ABSOLUTE].fill("PUBLISH_ABSOLUTE", "Deadband (C)", "%0.2f", 0, 10, 0.05, 0.1);
+    TempPublishNP[PUBLISH_RELATIVE].fill("PUBLISH_RELATIVE", "Deadband (%)", "%0.1f", 0, 100, 0.5, 0);
+    TempPublishNP[PUBLISH_MAX_SILENCE].fill("PUBLISH_MAX_SILENCE", "Max silence (s)", "%0.f", 0, 3600, 10, 60);
+    TempPublishNP[PUBLISH_MIN_INTERVAL].fill("PUBLISH_MIN_INTERVAL", "Min interval (s)", "%0.1f", 0, 600, 1, 0);
+
+    TempPublishNP.fill(getDeviceName(),
+                       "TEMP_PUBLISH",
+                       "Temp Publishing",
+                       OPTIONS_TAB,
+                       IP_RW,
+                       60,
+                       IPS_IDLE);
+
+    ControlPublishNP[PUBLISH_ABSOLUTE].fill("PUBLISH_ABSOLUTE", "Deadband", "%0.2f", 0, 10, 0.05, 0.1);
+    ControlPublishNP[PUBLISH_RELATIVE].fill("PUBLISH_RELATIVE", "Deadband (%)", "%0.1f", 0, 100, 0.5, 0);
+    ControlPublishNP[PUBLISH_MAX_SILENCE].fill("PUBLISH_MAX_SILENCE", "Max silence (s)", "%0.f", 0, 3600, 10, 60);
+    ControlPublishNP[PUBLISH_MIN_INTERVAL].fill("PUBLISH_MIN_INTERVAL", "Min interval (s)", "%0.1f", 0, 600, 1, 0);
+
+    ControlPublishNP.fill(getDeviceName(),
+                          "CONTROL_PUBLISH",
+                          "Dew Control Publishing",
+                          OPTIONS_TAB,
+                          IP_RW,
+                          60,
+                          IPS_IDLE);
+
+    // Configure the counters.
+    PublishStatsNP[STATS_TEMP_PUBLISHED].fill("STATS_TEMP_PUBLISHED", "Temp sent", "%0.f", 0, 1e12, 0, 0);
+    PublishStatsNP[STATS_TEMP_SUPPRESSED].fill("STATS_TEMP_SUPPRESSED", "Temp suppressed", "%0.f", 0, 1e12, 0, 0);
+    PublishStatsNP[STATS_CONTROL_PUBLISHED].fill("STATS_CONTROL_PUBLISHED", "Dew control sent", "%0.f", 0, 1e12, 0, 0);
+    PublishStatsNP[STATS_CONTROL_SUPPRESSED].fill("STATS_CONTROL_SUPPRESSED", "Dew control suppressed", "%0.f", 0, 1e12,
+                                                  0, 0);
+
+    PublishStatsNP.fill(getDeviceName(),
+                        "PUBLISH_STATS",
+                        "Publishing",
+                        OPTIONS_TAB,
+                        IP_RO,
+                        60,
+                        IPS_IDLE);
+
+    // The counters change on every tick, so they go out at most every 30 s.
+    PublishPolicy::Settings statsSettings;
+    statsSettings.minInterval = std::chrono::seconds(30);
+    statsSettings.maxSilence = std::chrono::milliseconds(0);
+    statsPublisher.setSettings(statsSettings);
+
+    applyPublishPolicies();
+
+    // Register the update callbacks.
+    TempPublishNP.onUpdate([this]
+                           {
+                               applyPublishPolicies();
+                               TempPublishNP.setState(IPS_OK);
+                               TempPublishNP.apply(); });
+    ControlPublishNP.onUpdate([this]
+                              {
+                                  applyPublishPolicies();
+                                  ControlPublishNP.setState(IPS_OK);
+                                  ControlPublishNP.apply(); });
+}
+
+void RPiPowerBox::applyPublishPolicies()
+{
+    auto settings = [](const INDI::PropertyNumber &property)
+    {
+        PublishPolicy::Settings settings;
+        settings.absolute = property[PUBLISH_ABSOLUTE].getValue();
+        settings.relative = property[PUBLISH_RELATIVE].getValue();
+        settings.maxSilence = std::chrono::milliseconds(std::lround(property[PUBLISH_MAX_SILENCE].getValue() * 1000));
+        settings.minInterval = std::chrono::milliseconds(std::lround(property[PUBLISH_MIN_INTERVAL].getValue() * 1000));
+        return settings;
+    };
+
+    tempPublisher.setSettings(settings(TempPublishNP));
+    for (TemperatureStatistic &statistic : tempStatistics)
+    {
+        statistic.publisher.setSettings(settings(TempPublishNP));
+    }
+    weatherPublisher.setSettings(settings(ControlPublishNP));
+    for (HeaterLoop &loop : heaterLoops)
+    {
+        loop.publisher.setSettings(settings(ControlPublishNP));
+    }
+}
+
+void RPiPowerBox::updatePublishStats()
+{
+    uint64_t controlPublished = weatherPublisher.published();
+    uint64_t controlSuppressed = weatherPublisher.suppressed();
+    for (const HeaterLoop &loop : heaterLoops)
+    {
+        controlPublished += loop.publisher.published();
+        controlSuppressed += loop.publisher.suppressed();
+    }
+
+    uint64_t tempPublished = tempPublisher.published();
+    uint64_t tempSuppressed = tempPublisher.suppressed();
+    for (const TemperatureStatistic &statistic : tempStatistics)
+    {
+        tempPublished += statistic.publisher.published();
+        tempSuppressed += statistic.publisher.suppressed();
+    }
+    for (const TemperatureStatistic &counter : tempCounters)
+    {
+        tempPublished += counter.publisher.published();
+        tempSuppressed += counter.publisher.suppressed();
+    }
+
+    PublishStatsNP[STATS_TEMP_PUBLISHED].setValue(tempPublished);
+    PublishStatsNP[STATS_TEMP_SUPPRESSED].setValue(tempSuppressed);
+    PublishStatsNP[STATS_CONTROL_PUBLISHED].setValue(controlPublished);
+    PublishStatsNP[STATS_CONTROL_SUPPRESSED].setValue(controlSuppressed);
+    PublishStatsNP.setState(IPS_OK);
+    publish(PublishStatsNP, statsPublisher);
+}
+
+// ============================================================================
+// Dew Heater Control
+// ============================================================================
+
+void RPiPowerBox::defineHeaterControl(HeaterLoop &loop, HeaterOutput &output)
+{
+    const std::string &prefix = output.channel.name;
+    const std::string &label = output.channel.label;
+    loop.gpioPin = output.channel.pin;
+    loop.name = prefix;
+    loop.heaterProp = &output.NP;
+    loop.pid.setOutputLimits(0, 100);
+
+    // Configure the control mode options.
+    loop.ModeSP[CONTROL_MANUAL].fill("CONTROL_MANUAL", "Manual", ISS_ON);
+    loop.ModeSP[CONTROL_TARGET].fill("CONTROL_TARGET", "Hold temperature", ISS_OFF);
+    loop.ModeSP[CONTROL_OFFSET].fill("CONTROL_OFFSET", "Above ambient", ISS_OFF);
+    loop.ModeSP[CONTROL_DEW_POINT].fill("CONTROL_DEW_POINT", "Above dew point", ISS_OFF);
+
+    loop.ModeSP.fill(getDeviceName(),
+                     (prefix + "_CONTROL").c_str(),
+                     (label + " Control").c_str(),
+                     DEW_CONTROL_TAB,
+                     IP_RW,
+                     ISR_1OFMANY,
+                     60,
+                     IPS_IDLE);
+
+    // Configure the setpoint and gains; the output is the duty cycle in percent.
+    loop.SettingsNP[PID_SETPOINT].fill("PID_SETPOINT", "Target (C)", "%0.1f", -40, 60, 0.5, 5);
+    loop.SettingsNP[PID_OFFSET].fill("PID_OFFSET", "Above ambient (C)", "%0.1f", 0, 20, 0.5, 3);
+    loop.SettingsNP[PID_KP].fill("PID_KP", "Kp (%/C)", "%0.2f", 0, 1000, 1, 10);
+    loop.SettingsNP[PID_KI].fill("PID_KI", "Ki (%/C/s)", "%0.3f", 0, 100, 0.01, 0.05);
+    loop.SettingsNP[PID_KD].fill("PID_KD", "Kd (%s/C)", "%0.1f", 0, 10000, 1, 0);
+    loop.SettingsNP[PID_SLEW].fill("PID_SLEW", "Slew limit (%/s)", "%0.1f", 0, 100, 0.5, 2);
+    loop.SettingsNP[PID_DEW_MARGIN].fill("PID_DEW_MARGIN", "Above dew point (C)", "%0.1f", 0, 20, 0.5, 3);
+    loop.SettingsNP[PID_FEED_FORWARD].fill("PID_FEED_FORWARD", "Dew feed-forward (%/C)", "%0.1f", 0, 100, 1, 5);
+
+    loop.SettingsNP.fill(getDeviceName(),
+                         (prefix + "_PID").c_str(),
+                         (label + " PID").c_str(),
+                         DEW_CONTROL_TAB,
+                         IP_RW,
+                         60,
+                         IPS_IDLE);
+
+    // Configure the probe assignment by sensor ID.
+    loop.ProbesTP[PROBE_HEATER].fill("PROBE_HEATER", "Heater probe", "");
+    loop.ProbesTP[PROBE_AMBIENT].fill("PROBE_AMBIENT", "Ambient probe", "");
+
+    loop.ProbesTP.fill(getDeviceName(),
+                       (prefix + "_PROBES").c_str(),
+                       (label + " Probes").c_str(),
+                       DEW_CONTROL_TAB,
+                       IP_RW,
+                       60,
+                       IPS_IDLE);
+
+    // Configure the read-only loop state.
+    loop.LoopNP[LOOP_TEMPERATURE].fill("LOOP_TEMPERATURE", "Temperature (C)", "%0.2f", -50, 100, 0, 0);
+    loop.LoopNP[LOOP_TARGET].fill("LOOP_TARGET", "Target (C)", "%0.2f", -50, 100, 0, 0);
+    loop.LoopNP[LOOP_ERROR].fill("LOOP_ERROR", "Error (C)", "%0.2f", -100, 100, 0, 0);
+    loop.LoopNP[LOOP_P].fill("LOOP_P", "P (%)", "%0.2f", -10000, 10000, 0, 0);
+    loop.LoopNP[LOOP_I].fill("LOOP_I", "I (%)", "%0.2f", 0, 100, 0, 0);
+    loop.LoopNP[LOOP_D].fill("LOOP_D", "D (%)", "%0.2f", -10000, 10000, 0, 0);
+    loop.LoopNP[LOOP_FEED_FORWARD].fill("LOOP_FEED_FORWARD", "Feed-forward (%)", "%0.2f", 0, 100, 0, 0);
+    loop.LoopNP[LOOP_OUTPUT].fill("LOOP_OUTPUT", "Output (%)", "%0.2f", 0, 100, 0, 0);
+
+    loop.LoopNP.fill(getDeviceName(),
+                     (prefix + "_LOOP").c_str(),
+                     (label + " Loop").c_str(),
+                     DEW_CONTROL_TAB,
+                     IP_RO,
+                     60,
+                     IPS_IDLE);
+
+    handleHeaterControlSettingsUpdate(loop);
+
+    // Register the update callbacks.
+    loop.ModeSP.onUpdate([this, &loop]
+                         { handleHeaterControlModeUpdate(loop); });
+    loop.SettingsNP.onUpdate([this, &loop]
+                             {
+                                 handleHeaterControlSettingsUpdate(loop);
+                                 loop.SettingsNP.setState(IPS_OK);
+                                 loop.SettingsNP.apply(); });
+    loop.ProbesTP.onUpdate([this, &loop]
+                           { handleHeaterControlProbesUpdate(loop); });
+}
+
+void RPiPowerBox::handleHeaterControlModeUpdate(HeaterLoop &loop)
+{
+    int mode = loop.ModeSP.findOnSwitchIndex();
+    if (mode == CONTROL_MANUAL)
+    {
+        LOGF_INFO("%s: manual control", loop.name.c_str());
+        loop.ModeSP.setState(IPS_IDLE);
+        loop.ModeSP.apply();
+        loop.LoopNP.setState(IPS_IDLE);
+        loop.LoopNP.apply();
+        return;
+    }
+
+    // Continue from the duty cycle currently applied (bumpless transfer).
+    loop.pid.reset((*loop.heaterProp)[0].getValue());
+    loop.lastUpdate = std::chrono::steady_clock::now();
+    LOGF_INFO("%s: closed-loop control, %s", loop.name.c_str(),
+              loop.ModeSP[mode].getLabel());
+
+    loop.ModeSP.setState(IPS_OK);
+    loop.ModeSP.apply();
+}
+
+void RPiPowerBox::handleHeaterControlSettingsUpdate(HeaterLoop &loop)
+{
+    // Gains take effect on the next step; the integral is kept.
+    loop.pid.setGains(loop.SettingsNP[PID_KP].getValue(),
+                      loop.SettingsNP[PID_KI].getValue(),
+                      loop.SettingsNP[PID_KD].getValue());
+    loop.pid.setSlewRate(loop.SettingsNP[PID_SLEW].getValue());
+}
+
+void RPiPowerBox::handleHeaterControlProbesUpdate(HeaterLoop &loop)
+{
+    // Unknown IDs are accepted, as the probe may simply not be plugged in yet.
+    bool found = true;
+    for (int i = 0; i < PROBE_N; ++i)
+    {
+        std::string id = loop.ProbesTP[i].getText();
+        if (!id.empty() && std::none_of(sensors.begin(), sensors.end(), [&id](const Sensor &sensor)
+                                        { return sensor.id == id; }))
+        {
+            LOGF_WARN("%s: sensor %s not found.", loop.name.c_str(), id.c_str());
+            found = false;
+        }
+    }
+
+    // A new heater probe gets a full timeout before the watchdog calls it quiet.
+    configureWatchdog();
+
+    loop.ProbesTP.setState(found ? IPS_OK : IPS_ALERT);
+    loop.ProbesTP.apply();
+}
+
+void RPiPowerBox::defineControlPeriod()
+{
+    // Configure the control period.
+    ControlPeriodNP[0].fill("CONTROL_PERIOD",
+                            "Period (s)",
+                            "%0.1f",
+                            0.5,
+                            60,
+                            0.5,
+                            RP_PB_CONTROL_PERIOD);
+
+    ControlPeriodNP.fill(getDeviceName(),
+                         "DEW_CONTROL_PERIOD",
+                         "Control Loop",
+                         DEW_CONTROL_TAB,
+                         IP_RW,
+                         60,
+                         IPS_IDLE);
+
+    // Register the update callback.
+    ControlPeriodNP.onUpdate([this]
+                             { handleControlPeriodUpdate(); });
+}
+
+void RPiPowerBox::handleControlPeriodUpdate()
+{
+    // The controller scales by the measured interval, so no reset is needed.
+    applyTaskPeriods();
+
+    ControlPeriodNP.setState(IPS_OK);
+    ControlPeriodNP.apply();
+}
+
+void RPiPowerBox::runControlLoop()
+{
+    if (!isConnected())
+    {
+        return;
+    }
+
+    // Pick up the newest readings without waiting for the sample task.
+    updateTemperatureReadings();
+    updateWeatherAge();
+
+    auto now = std::chrono::steady_clock::now();
+    for (HeaterLoop &loop : heaterLoops)
+    {
+        updateHeaterLoop(loop, now);
+    }
+}
+
+void RPiPowerBox::updateHeaterLoop(HeaterLoop &loop, std::chrono::steady_clock::time_point now)
+{
+    int mode = loop.ModeSP.findOnSwitchIndex();
+    if (mode <= CONTROL_MANUAL)
+    {
+        return;
+    }
+
+    // A step after a stall or a reconnection neither winds up the integral
+    // term nor escapes the slew limit.
+    double period = std::chrono::duration<double>(scheduler.period(TASK_CONTROL)).count();
+    double dt = std::min(std::chrono::duration<double>(now - loop.lastUpdate).count(), 3 * period);
+    loop.lastUpdate = now;
+
+    // Anticipate condensation from the weather station's dew point.
+    double ambient = 0;
+    bool hasAmbient = ambientTemperature(loop, ambient);
+    double feedForward = hasAmbient ? dewFeedForward(loop, ambient) : 0;
+
+    double target = 0;
+    bool valid = true;
+    switch (mode)
+    {
+    case CONTROL_TARGET:
+        target = loop.SettingsNP[PID_SETPOINT].getValue();
+        break;
+    case CONTROL_OFFSET:
+        valid = hasAmbient;
+        target = ambient + loop.SettingsNP[PID_OFFSET].getValue();
+        break;
+    case CONTROL_DEW_POINT:
+        valid = hasWeather;
+        target = WeatherNP[WX_DEW_POINT].getValue() + loop.SettingsNP[PID_DEW_MARGIN].getValue();
+        break;
+    }
+
+    // Above the dew point, a heater without its own probe runs on feed-forward alone.
+    double temperature = 0;
+    bool measured = findSensorReading(loop.ProbesTP[PROBE_HEATER].getText(), temperature);
+    valid = valid && (measured || mode == CONTROL_DEW_POINT);
+
+    // Without feedback, hold the current output.
+    if (!valid)
+    {
+        if (loop.LoopNP.getState() != IPS_ALERT)
+        {
+            LOGF_WARN("%s: no valid probe reading, holding %.2f%%.", loop.name.c_str(),
+                      (*loop.heaterProp)[0].getValue());
+        }
+        loop.LoopNP.setState(IPS_ALERT);
+        publish(loop.LoopNP, loop.publisher);
+        return;
+    }
+
+    double output = measured ? loop.pid.update(target, temperature, dt, feedForward)
+                             : loop.pid.track(feedForward, dt);
+
+    const PIDController::Terms &terms = loop.pid.terms();
+    if (measured)
+    {
+        loop.LoopNP[LOOP_TEMPERATURE].setValue(temperature);
+    }
+    loop.LoopNP[LOOP_TARGET].setValue(target);
+    telemetry.record(TelemetryKind::HEATER_TARGET, loop.name, target);
+    loop.LoopNP[LOOP_ERROR].setValue(terms.error);
+    loop.LoopNP[LOOP_P].setValue(terms.proportional);
+    loop.LoopNP[LOOP_I].setValue(terms.integral);
+    loop.LoopNP[LOOP_D].setValue(terms.derivative);
+    loop.LoopNP[LOOP_FEED_FORWARD].setValue(terms.feedForward);
+    loop.LoopNP[LOOP_OUTPUT].setValue(output);
+    loop.LoopNP.setState(IPS_OK);
+    publish(loop.LoopNP, loop.publisher);
+
+    // Skip writes below the display resolution of the duty cycle, and leave
+    // a heater being ramped by the power sequencer to it.
+    if (std::fabs(output - (*loop.heaterProp)[0].getValue()) >= 0.01 && !sequenceTargets.count(loop.gpioPin))
+    {
+        submitHeaterDutyCycle(*loop.heaterProp, loop.gpioPin, loop.name, output);
+    }
+}
+
+bool RPiPowerBox::ambientTemperature(const HeaterLoop &loop, double &value) const
+{
+    // The weather station's last good value stands in for a missing probe.
+    std::string id = loop.ProbesTP[PROBE_AMBIENT].getText();
+    if (!id.empty() && findSensorReading(id, value))
+    {
+        return true;
+    }
+    value = WeatherNP[WX_TEMPERATURE].getValue();
+    return hasWeather;
+}
+
+double RPiPowerBox::dewFeedForward(const HeaterLoop &loop, double ambient) const
+{
+    if (!hasWeather)
+    {
+        return 0;
+    }
+
+    // The optics sit near ambient; lift them the rest of the way above the dew point.
+    double lift = WeatherNP[WX_DEW_POINT].getValue() + loop.SettingsNP[PID_DEW_MARGIN].getValue() - ambient;
+    return std::min(std::max(lift, 0.0) * loop.SettingsNP[PID_FEED_FORWARD].getValue(), 100.0);
+}
+
+bool RPiPowerBox::findSensorReading(const std::string &id, double &value) const
+{
+    // Readings of an older sensor list are in a different order.
+    if (samples.generation != sensorGeneration)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < sensors.size() && i < samples.readings.size(); ++i)
+    {
+        if (sensors[i].id == id)
+        {
+            // A stale value is the last good reading and still fit for control.
+            value = samples.readings[i].value;
+            return samples.readings[i].health != SensorHealth::FAILED;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// Weather Snooping
+// ============================================================================
+
+void RPiPowerBox::defineWeather()
+{
+    // Configure the snooped weather device.
+    ActiveDeviceTP[ACTIVE_WEATHER].fill("ACTIVE_WEATHER", "Weather", RP_PB_WEATHER_DEVICE);
+
+    ActiveDeviceTP.fill(getDeviceName(),
+                        "ACTIVE_DEVICES",
+                        "Snoop devices",
+                        OPTIONS_TAB,
+                        IP_RW,
+                        60,
+                        IPS_IDLE);
+
+    // Configure the last good weather data.
+    WeatherNP[WX_TEMPERATURE].fill("WX_TEMPERATURE", "Temperature (C)", "%0.1f", -50, 60, 0, 0);
+    WeatherNP[WX_HUMIDITY].fill("WX_HUMIDITY", "Humidity (%)", "%0.1f", 0, 100, 0, 0);
+    WeatherNP[WX_DEW_POINT].fill("WX_DEW_POINT", "Dew point (C)", "%0.1f", -50, 60, 0, 0);
+    WeatherNP[WX_AGE].fill("WX_AGE", "Age (s)", "%0.f", 0, 1e9, 0, 0);
+
+    WeatherNP.fill(getDeviceName(),
+                   "WEATHER_SNOOP",
+                   "Weather",
+                   DEW_CONTROL_TAB,
+                   IP_RO,
+                   60,
+                   IPS_IDLE);
+
+    // Configure how long weather data stays fresh.
+    WeatherTimeoutNP[0].fill("WEATHER_TIMEOUT",
+                             "Timeout (s)",
+                             "%0.f",
+                             10,
+                             86400,
+                             10,
+                             RP_PB_WEATHER_TIMEOUT);
+
+    WeatherTimeoutNP.fill(getDeviceName(),
+                          "WEATHER_TIMEOUT",
+                          "Weather",
+                          DEW_CONTROL_TAB,
+                          IP_RW,
+                          60,
+                          IPS_IDLE);
+
+    IDSnoopDevice(ActiveDeviceTP[ACTIVE_WEATHER].getText(), "WEATHER_PARAMETERS");
+
+    // Register the update callbacks.
+    ActiveDeviceTP.onUpdate([this]
+                            { handleActiveDevicesUpdate(); });
+    WeatherTimeoutNP.onUpdate([this]
+                              {
+                                  WeatherTimeoutNP.setState(IPS_OK);
+                                  WeatherTimeoutNP.apply(); });
+}
+
+void RPiPowerBox::handleActiveDevicesUpdate()
+{
+    // Data from the previous device no longer applies.
+    hasWeather = false;
+    weatherStale = false;
+    WeatherNP.setState(IPS_IDLE);
+    IDSnoopDevice(ActiveDeviceTP[ACTIVE_WEATHER].getText(), "WEATHER_PARAMETERS");
+    LOGF_INFO("Snooping weather device %s", ActiveDeviceTP[ACTIVE_WEATHER].getText());
+
+    ActiveDeviceTP.setState(IPS_OK);
+    ActiveDeviceTP.apply();
+}
+
+bool RPiPowerBox::ISSnoopDevice(XMLEle *root)
+{
+    const char *device = findXMLAttValu(root, "device");
+    const char *name = findXMLAttValu(root, "name");
+    if (strcmp(device, ActiveDeviceTP[ACTIVE_WEATHER].getText()) == 0 && strcmp(name, "WEATHER_PARAMETERS") == 0)
+    {
+        handleWeatherSnoop(root);
+    }
+
+    return INDI::DefaultDevice::ISSnoopDevice(root);
+}
+
+void RPiPowerBox::handleWeatherSnoop(XMLEle *root)
+{
+    // Elements missing from a partial update keep their last value.
+    double temperature = WeatherNP[WX_TEMPERATURE].getValue();
+    double humidity = WeatherNP[WX_HUMIDITY].getValue();
+    bool hasTemperature = hasWeather;
+    bool hasHumidity = hasWeather;
+
+    for (XMLEle *ep = nextXMLEle(root, 1); ep != nullptr; ep = nextXMLEle(root, 0))
+    {
+        const char *element = findXMLAttValu(ep, "name");
+        char *end = nullptr;
+        double value = std::strtod(pcdataXMLEle(ep), &end);
+        if (end == pcdataXMLEle(ep))
+        {
+            continue;
+        }
+
+        if (strcmp(element, "WEATHER_TEMPERATURE") == 0)
+        {
+            temperature = value;
+            hasTemperature = true;
+        }
+        else if (strcmp(element, "WEATHER_HUMIDITY") == 0 && value > 0 && value <= 100)
+        {
+            humidity = value;
+            hasHumidity = true;
+        }
+    }
+
+    if (!hasTemperature || !hasHumidity)
+    {
+        return;
+    }
+
+    // Only recompute the dew point when its inputs change.
+    if (!hasWeather || temperature != WeatherNP[WX_TEMPERATURE].getValue() ||
+        humidity != WeatherNP[WX_HUMIDITY].getValue())
+    {
+        WeatherNP[WX_TEMPERATURE].setValue(temperature);
+        WeatherNP[WX_HUMIDITY].setValue(humidity);
+        WeatherNP[WX_DEW_POINT].setValue(dewPoint(temperature, humidity));
+        telemetry.record(TelemetryKind::AIR_TEMPERATURE, "WEATHER", temperature);
+        telemetry.record(TelemetryKind::HUMIDITY, "WEATHER", humidity);
+        telemetry.record(TelemetryKind::DEW_POINT, "WEATHER", WeatherNP[WX_DEW_POINT].getValue());
+    }
+
+    if (weatherStale)
+    {
+        LOG_INFO("Weather data is updating again.");
+    }
+    hasWeather = true;
+    weatherStale = false;
+    weatherTime = std::chrono::steady_clock::now();
+    updateWeatherAge();
+}
+
+void RPiPowerBox::updateWeatherAge()
+{
+    if (!hasWeather)
+    {
+        return;
+    }
+
+    // Stale data is still used; the state only tells the operator.
+    double age = std::chrono::duration<double>(std::chrono::steady_clock::now() - weatherTime).count();
+    if (!weatherStale && age > WeatherTimeoutNP[0].getValue())
+    {
+        LOGF_WARN("No weather update from %s for %.0f s, using the last good values.",
+                  ActiveDeviceTP[ACTIVE_WEATHER].getText(), age);
+        weatherStale = true;
+    }
+
+    WeatherNP[WX_AGE].setValue(age);
+    WeatherNP.setState(weatherStale ? IPS_ALERT : IPS_OK);
+    if (isConnected())
+    {
+        // The age alone changes on every update; it goes out with the other values.
+        publish(WeatherNP, weatherPublisher, WX_AGE);
+    }
+}
+
+double RPiPowerBox::dewPoint(double temperature, double humidity)
+{
+    // Magnus formula with the Sonntag (1990) coefficients, valid from -45 to 60 C.
+    const double b = 17.62;
+    const double c = 243.12;
+    double gamma = std::log(humidity / 100) + b * temperature / (c + temperature);
+    return c * gamma / (b - gamma);
+}
+
+// ============================================================================
+// Heater Watchdog
+// ============================================================================
+
+void RPiPowerBox::defineWatchdog()
+{
+    // Configure the limits; the check period bounds the reaction time.
+    WatchdogNP[WD_LIMIT].fill("WD_LIMIT", "Max heater temp (C)", "%0.1f", 0, 100, 1, RP_PB_WATCHDOG_LIMIT);
+    WatchdogNP[WD_STALE].fill("WD_STALE", "Probe timeout (s, 0 off)", "%0.f", 0, 600, 5, RP_PB_WATCHDOG_STALE);
+    WatchdogNP[WD_PERIOD].fill("WD_PERIOD", "Check period (ms)", "%0.f", 10, 1000, 10, RP_PB_WATCHDOG_PERIOD);
+    WatchdogNP.fill(getDeviceName(),
+                    "HEATER_WATCHDOG",
+                    "Heater Watchdog",
+                    SAFETY_TAB,
+                    IP_RW,
+                    60,
+                    IPS_IDLE);
+
+    // Configure the mode; real-time needs CAP_SYS_NICE and CAP_IPC_LOCK.
+    WatchdogModeSP[WD_MODE_DISABLED].fill("WD_MODE_DISABLED", "Disabled", ISS_OFF);
+    WatchdogModeSP[WD_MODE_ENABLED].fill("WD_MODE_ENABLED", "Enabled", ISS_ON);
+    WatchdogModeSP[WD_MODE_REALTIME].fill("WD_MODE_REALTIME", "Real-time", ISS_OFF);
+    WatchdogModeSP.fill(getDeviceName(),
+                        "HEATER_WATCHDOG_MODE",
+                        "Watchdog Mode",
+                        SAFETY_TAB,
+                        IP_RW,
+                        ISR_1OFMANY,
+                        60,
+                        IPS_IDLE);
+
+    // Configure the read-only counters.
+    WatchdogStatusNP[WD_STATUS_TRIPS].fill("WD_STATUS_TRIPS", "Trips", "%0.f", 0, 1e9, 0, 0);
+    WatchdogStatusNP[WD_STATUS_REACTION].fill("WD_STATUS_REACTION", "Worst reaction (ms)", "%0.3f", 0, 1e7, 0, 0);
+    WatchdogStatusNP[WD_STATUS_WAKEUP].fill("WD_STATUS_WAKEUP", "Worst wake-up (ms)", "%0.3f", 0, 1e7, 0, 0);
+    WatchdogStatusNP.fill(getDeviceName(),
+                          "HEATER_WATCHDOG_STATUS",
+                          "Watchdog Status",
+                          SAFETY_TAB,
+                          IP_RO,
+                          60,
+                          IPS_IDLE);
+
+    WatchdogRearmSP[0].fill("WD_REARM", "Rearm", ISS_OFF);
+    WatchdogRearmSP.fill(getDeviceName(),
+                         "HEATER_WATCHDOG_REARM",
+                         "Tripped Heaters",
+                         SAFETY_TAB,
+                         IP_RW,
+                         ISR_ATMOST1,
+                         60,
+                         IPS_IDLE);
+
+    // Register the update callbacks.
+    WatchdogNP.onUpdate([this]
+                        { handleWatchdogUpdate(); });
+    WatchdogModeSP.onUpdate([this]
+                            { handleWatchdogModeUpdate(); });
+    WatchdogRearmSP.onUpdate([this]
+                             { handleWatchdogRearmUpdate(); });
+}
+
+void RPiPowerBox::handleWatchdogUpdate()
+{
+    // Limits apply to the next pass; only a new period needs a new thread.
+    configureWatchdog();
+    auto period = std::chrono::milliseconds(static_cast<int>(WatchdogNP[WD_PERIOD].getValue()));
+    if (watchdog.running() && watchdog.period() != period)
+    {
+        startWatchdog();
+    }
+
+    WatchdogNP.setState(IPS_OK);
+    WatchdogNP.apply();
+}
+
+void RPiPowerBox::handleWatchdogModeUpdate()
+{
+    startWatchdog();
+    WatchdogModeSP.apply();
+}
+
+void RPiPowerBox::handleWatchdogRearmUpdate()
+{
+    // Tripped heaters were left at 0% in manual mode, so they stay off until set again.
+    watchdog.rearm();
+    tripsHandled.fill(false);
+    LOG_INFO("Heater watchdog rearmed.");
+
+    WatchdogRearmSP.reset();
+    WatchdogRearmSP.setState(IPS_OK);
+    WatchdogRearmSP.apply();
+    WatchdogStatusNP.setState(IPS_OK);
+    WatchdogStatusNP.apply();
+}
+
+void RPiPowerBox::startWatchdog()
+{
+    if (!interlock)
+    {
+        WatchdogModeSP.setState(IPS_IDLE);
+        return;
+    }
+
+    // Trips and their latches carry over; only Rearm releases them.
+    watchdog.stop();
+
+    int mode = WatchdogModeSP.findOnSwitchIndex();
+    if (mode == WD_MODE_DISABLED)
+    {
+        LOG_WARN("Heater watchdog disabled.");
+        WatchdogModeSP.setState(IPS_IDLE);
+        return;
+    }
+
+    std::string error;
+    auto period = std::chrono::milliseconds(static_cast<int>(WatchdogNP[WD_PERIOD].getValue()));
+    if (!watchdog.start(*interlock, period, mode == WD_MODE_REALTIME, error))
+    {
+        LOGF_WARN("Heater watchdog running without real-time scheduling: %s", error.c_str());
+        WatchdogModeSP.setState(IPS_ALERT);
+        return;
+    }
+    WatchdogModeSP.setState(IPS_OK);
+}
+
+void RPiPowerBox::configureWatchdog()
+{
+    watchdog.setStaleTimeout(std::chrono::seconds(static_cast<int>(WatchdogNP[WD_STALE].getValue())));
+
+    // A heater without a heater probe is not guarded.
+    double limit = WatchdogNP[WD_LIMIT].getValue();
+    for (size_t i = 0; i < ThermalWatchdog::maxGuards; ++i)
+    {
+        if (i < heaterLoops.size())
+        {
+            const HeaterLoop &loop = heaterLoops[i];
+            watchdog.setGuard(i, loop.gpioPin, loop.ProbesTP[PROBE_HEATER].getText(), limit);
+        }
+        else
+        {
+            watchdog.setGuard(i, -1, "", limit);
+        }
+    }
+}
+
+void RPiPowerBox::updateWatchdog()
+{
+    for (size_t i = 0; i < heaterLoops.size() && i < ThermalWatchdog::maxGuards; ++i)
+    {
+        TripCause cause = watchdog.cause(i);
+        if (cause != TripCause::NONE && !tripsHandled[i])
+        {
+            tripsHandled[i] = true;
+            handleWatchdogTrip(heaterLoops[i], cause, watchdog.temperature(i));
+        }
+    }
+
+    ThermalWatchdog::Status status = watchdog.status();
+    WatchdogStatusNP[WD_STATUS_TRIPS].setValue(status.trips);
+    WatchdogStatusNP[WD_STATUS_REACTION].setValue(status.worstReaction.count() / 1000.0);
+    WatchdogStatusNP[WD_STATUS_WAKEUP].setValue(status.worstWakeup.count() / 1000.0);
+    WatchdogStatusNP.setState(std::any_of(tripsHandled.begin(), tripsHandled.end(), [](bool handled)
+                                          { return handled; })
+                                  ? IPS_ALERT
+                                  : IPS_OK);
+    WatchdogStatusNP.apply();
+}
+
+void RPiPowerBox::handleWatchdogTrip(HeaterLoop &loop, TripCause cause, double temperature)
+{
+    telemetry.record(TelemetryKind::WATCHDOG_TRIP, loop.name, temperature, static_cast<uint32_t>(cause));
+    if (cause == TripCause::OVER_TEMP)
+    {
+        LOGF_ERROR("%s cut by the watchdog: probe at %.1f C, limit %.1f C.", loop.name.c_str(), temperature,
+                   WatchdogNP[WD_LIMIT].getValue());
+    }
+    else
+    {
+        LOGF_ERROR("%s cut by the watchdog: no reading from its probe for %.0f s.", loop.name.c_str(),
+                   WatchdogNP[WD_STALE].getValue());
+    }
+
+    // A sequence moving the heater would only be held at 0% by the interlock.
+    if (sequenceTargets.count(loop.gpioPin) != 0)
+    {
+        finishSequence(false);
+    }
+
+    // The interlock keeps the pin off; make 0% the state to return to after rearming.
+    INDI::PropertyNumber &heaterProp = *loop.heaterProp;
+    releaseHeaterControl(heaterProp);
+    int gpioPin = loop.gpioPin;
+    submitGPIO(gpioPin,
+               [gpioPin](GPIOBackend &backend)
+               { return writeHeaterDutyCycle(backend, gpioPin, 0); },
+               [](bool, const std::string &) {});
+    heaterProp[0].setValue(0);
+    heaterProp.setState(IPS_ALERT);
+    heaterProp.apply();
+    persistOutputs();
+}
+
+// ============================================================================
+// Task Scheduling
+// ============================================================================
+
+void RPiPowerBox::registerTasks()
+{
+    // Registered in TASK_* order; periods are set from the properties on Connect().
+    scheduler.add("sample", std::chrono::seconds(RP_PB_SAMPLE_PERIOD), 3, [this]
+                  {
+                      updateTemperatureReadings();
+                      updateSnapshot();
+                  });
+    scheduler.add("publish", std::chrono::seconds(RP_PB_PUBLISH_PERIOD), 2, [this]
+                  {
+                      publishTemperatureReadings();
+                      updatePublishStats();
+                      updateWatchdog();
+                  });
+    scheduler.add("hot-plug", std::chrono::seconds(RP_PB_HOTPLUG_PERIOD), 0, [this]
+                  { checkSensorChanges(); });
+    scheduler.add("health", std::chrono::seconds(RP_PB_HEALTH_PERIOD), 1, [this]
+                  { runHealthChecks(); });
+    scheduler.add("diagnostics", std::chrono::seconds(RP_PB_DIAGNOSTICS_PERIOD), 0, [this]
+                  {
+                      updateDiagnostics();
+                      updateTelemetry();
+                      updateSnapshotStatus();
+                  });
+    scheduler.add("link", std::chrono::seconds(RP_PB_LINK_PERIOD), 2, [this]
+                  { checkGPIOLink(); });
+    scheduler.add("control", std::chrono::seconds(RP_PB_CONTROL_PERIOD), 4, [this]
+                  { runControlLoop(); });
+}
+
+void RPiPowerBox::defineScheduler()
+{
+    // Configure the task periods.
+    static const struct
+    {
+        const char *name;
+        const char *label;
+        double min;
+        double max;
+        double value;
+    } periods[TASK_CONTROL] = {
+        {"TASK_SAMPLE", "Sampling (s)", 0.1, 60, RP_PB_SAMPLE_PERIOD},
+        {"TASK_PUBLISH", "Publishing (s)", 0.1, 60, RP_PB_PUBLISH_PERIOD},
+        {"TASK_HOTPLUG", "Sensor scan (s)", 1, 600, RP_PB_HOTPLUG_PERIOD},
+        {"TASK_HEALTH", "Health checks (s)", 1, 600, RP_PB_HEALTH_PERIOD},
+        {"TASK_DIAGNOSTICS", "Diagnostics (s)", 1, 3600, RP_PB_DIAGNOSTICS_PERIOD},
+        {"TASK_LINK", "GPIO heartbeat (s)", 0.2, 60, RP_PB_LINK_PERIOD},
+    };
+
+    for (int task = 0; task < TASK_CONTROL; ++task)
+    {
+        TaskPeriodsNP[task].fill(periods[task].name,
+                                 periods[task].label,
+                                 "%0.1f",
+                                 periods[task].min,
+                                 periods[task].max,
+                                 0.1,
+                                 periods[task].value);
+    }
+
+    TaskPeriodsNP.fill(getDeviceName(),
+                       "TASK_PERIODS",
+                       "Task Periods",
+                       SCHEDULER_TAB,
+                       IP_RW,
+                       60,
+                       IPS_IDLE);
+
+    // Configure the timing counters, one element per task.
+    static const char *const tasks[TASK_N][2] = {
+        {"TASK_SAMPLE", "Sampling"},
+        {"TASK_PUBLISH", "Publishing"},
+        {"TASK_HOTPLUG", "Sensor scan"},
+        {"TASK_HEALTH", "Health checks"},
+        {"TASK_DIAGNOSTICS", "Diagnostics"},
+        {"TASK_LINK", "GPIO heartbeat"},
+        {"TASK_CONTROL", "Control loop"},
+    };
+
+    for (int task = 0; task < TASK_N; ++task)
+    {
+        TaskOverrunsNP[task].fill(tasks[task][0], tasks[task][1], "%0.f", 0, 1e12, 0, 0);
+        TaskRuntimeNP[task].fill(tasks[task][0], tasks[task][1], "%0.1f", 0, 1e6, 0, 0);
+    }
+
+    TaskOverrunsNP.fill(getDeviceName(),
+                        "TASK_OVERRUNS",
+                        "Overruns",
+                        SCHEDULER_TAB,
+                        IP_RO,
+                        60,
+                        IPS_IDLE);
+
+    TaskRuntimeNP.fill(getDeviceName(),
+                       "TASK_RUNTIME",
+                       "Longest Run (ms)",
+                       SCHEDULER_TAB,
+                       IP_RO,
+                       60,
+                       IPS_IDLE);
+
+    // Configure the faster rate used while dew threatens.
+    DewRiskNP[RISK_SPREAD].fill("RISK_SPREAD",
+                                "Dew point spread (C)",
+                                "%0.1f",
+                                0,
+                                20,
+                                0.5,
+                                RP_PB_DEW_RISK_SPREAD);
+    DewRiskNP[RISK_PERIOD].fill("RISK_PERIOD",
+                                "Period at risk (s)",
+                                "%0.1f",
+                                0.1,
+                                60,
+                                0.1,
+                                RP_PB_DEW_RISK_PERIOD);
+
+    DewRiskNP.fill(getDeviceName(),
+                   "DEW_RISK_RATE",
+                   "Dew Risk Rate",
+                   DEW_CONTROL_TAB,
+                   IP_RW,
+                   60,
+                   IPS_IDLE);
+
+    // Register the update callbacks.
+    TaskPeriodsNP.onUpdate([this]
+                           { handleTaskPeriodsUpdate(); });
+    DewRiskNP.onUpdate([this]
+                       { handleDewRiskUpdate(); });
+}
+
+void RPiPowerBox::handleTaskPeriodsUpdate()
+{
+    applyTaskPeriods();
+
+    TaskPeriodsNP.setState(IPS_OK);
+    TaskPeriodsNP.apply();
+}
+
+void RPiPowerBox::handleDewRiskUpdate()
+{
+    // Re-evaluate at once rather than at the next health check.
+    dewRisk = detectDewRisk();
+    applyTaskPeriods();
+
+    DewRiskNP.setState(dewRisk ? IPS_BUSY : IPS_OK);
+    DewRiskNP.apply();
+}
+
+void RPiPowerBox::applyTaskPeriods()
+{
+    auto seconds = [](double value)
+    {
+        return std::chrono::milliseconds(std::lround(value * 1000));
+    };
+
+    // While dew threatens, sample, publish and control at the fast rate.
+    std::chrono::milliseconds fast = seconds(DewRiskNP[RISK_PERIOD].getValue());
+    for (int task = 0; task < TASK_CONTROL; ++task)
+    {
+        std::chrono::milliseconds period = seconds(TaskPeriodsNP[task].getValue());
+        if (dewRisk && (task == TASK_SAMPLE || task == TASK_PUBLISH))
+        {
+            period = std::min(period, fast);
+        }
+        scheduler.setPeriod(task, period);
+    }
+
+    std::chrono::milliseconds control = seconds(ControlPeriodNP[0].getValue());
+    scheduler.setPeriod(TASK_CONTROL, dewRisk ? std::min(control, fast) : control);
+
+    sampler.setPeriod(acquisitionPeriod());
+}
+
+void RPiPowerBox::runHealthChecks()
+{
+    updateWeatherAge();
+
+    // Poll fast only while condensation threatens, and back off afterwards.
+    bool risk = detectDewRisk();
+    if (risk != dewRisk)
+    {
+        dewRisk = risk;
+        if (risk)
+        {
+            LOGF_INFO("Within %.1f C of the dew point, switching to the %.1f s dew risk rate.",
+                      DewRiskNP[RISK_SPREAD].getValue(), DewRiskNP[RISK_PERIOD].getValue());
+        }
+        else
+        {
+            LOG_INFO("Dew risk over, back to the normal task periods.");
+        }
+        DewRiskNP.setState(risk ? IPS_BUSY : IPS_OK);
+        DewRiskNP.apply();
+    }
+
+    // Also follows sensor count and resolution changes.
+    applyTaskPeriods();
+    updateTaskStats();
+
+    saveOutputs();
+}
+
+bool RPiPowerBox::detectDewRisk() const
+{
+    if (!hasWeather)
+    {
+        return false;
+    }
+
+    // The coldest of the air and every working probe is the first to collect dew.
+    double coldest = WeatherNP[WX_TEMPERATURE].getValue();
+    if (samples.generation == sensorGeneration)
+    {
+        for (const TemperatureReading &reading : samples.readings)
+        {
+            if (reading.health != SensorHealth::FAILED)
+            {
+                coldest = std::min(coldest, reading.value);
+            }
+        }
+    }
+    return coldest - WeatherNP[WX_DEW_POINT].getValue() < DewRiskNP[RISK_SPREAD].getValue();
+}
+
+void RPiPowerBox::updateTaskStats()
+{
+    bool changed = false;
+    for (int task = 0; task < TASK_N; ++task)
+    {
+        const TaskScheduler::Stats &stats = scheduler.stats(task);
+        if (stats.overruns != reportedOverruns[task])
+        {
+            LOGF_WARN("Task %s overran %llu time(s) since the last check (longest run %.1f ms, up to %.1f ms late).",
+                      scheduler.name(task).c_str(),
+                      static_cast<unsigned long long>(stats.overruns - reportedOverruns[task]),
+                      stats.maxRuntime.count() / 1000.0, stats.maxLateness.count() / 1000.0);
+            reportedOverruns[task] = stats.overruns;
+            changed = true;
+        }
+
+        double runtime = stats.maxRuntime.count() / 1000.0;
+        changed |= TaskRuntimeNP[task].getValue() != runtime;
+        TaskOverrunsNP[task].setValue(stats.overruns);
+        TaskRuntimeNP[task].setValue(runtime);
+    }
+
+    if (changed)
+    {
+        bool overran = std::any_of(reportedOverruns.begin(), reportedOverruns.end(), [](uint64_t count)
+                                   { return count > 0; });
+        TaskOverrunsNP.setState(overran ? IPS_ALERT : IPS_OK);
+        TaskOverrunsNP.apply();
+        TaskRuntimeNP.setState(IPS_OK);
+        TaskRuntimeNP.apply();
+    }
+}
+
+// ============================================================================
+// Diagnostics
+// ============================================================================
+
+void RPiPowerBox::attachLatencyHistograms()
+{
+    scheduler.setLatencyHistogram(&latencies[LAT_TASK].histogram);
+    sampler.setLatencyHistograms(&latencies[LAT_SENSOR_READ].histogram, &latencies[LAT_SENSOR_PASS].histogram);
+    commands.setLatencyHistogram(&latencies[LAT_COMMAND].histogram);
+    dispatcher.setLatencyHistogram(&latencies[LAT_DISPATCH].histogram);
+}
+
+void RPiPowerBox::defineDiagnostics()
+{
+    // Configure one summary per instrumented path.
+    static const char *const channels[LAT_N][2] = {
+        {"LATENCY_TASK", "Scheduled Tasks"},
+        {"LATENCY_SENSOR_READ", "Sensor Reads"},
+        {"LATENCY_SENSOR_PASS", "Sensor Passes"},
+        {"LATENCY_GPIO_CALL", "GPIO Calls"},
+        {"LATENCY_COMMAND", "GPIO Commands"},
+        {"LATENCY_DISPATCH", "Event Loop Dispatch"},
+    };
+
+    for (int c = 0; c < LAT_N; ++c)
+    {
+        INDI::PropertyNumber &property = latencies[c].NP;
+        property[LATENCY_COUNT].fill("LATENCY_COUNT", "Count", "%0.f", 0, 1e12, 0, 0);
+        property[LATENCY_MEAN].fill("LATENCY_MEAN", "Mean (ms)", "%0.3f", 0, 1e7, 0, 0);
+        property[LATENCY_P50].fill("LATENCY_P50", "50% below (ms)", "%0.3f", 0, 1e7, 0, 0);
+        property[LATENCY_P90].fill("LATENCY_P90", "90% below (ms)", "%0.3f", 0, 1e7, 0, 0);
+        property[LATENCY_P99].fill("LATENCY_P99", "99% below (ms)", "%0.3f", 0, 1e7, 0, 0);
+        property[LATENCY_MAX].fill("LATENCY_MAX", "Max (ms)", "%0.3f", 0, 1e7, 0, 0);
+        property.fill(getDeviceName(),
+                      channels[c][0],
+                      channels[c][1],
+                      DIAGNOSTICS_TAB,
+                      IP_RO,
+                      60,
+                      IPS_IDLE);
+    }
+
+    // Configure the periodic dump.
+    DiagnosticsDumpSP[DUMP_ON].fill("DUMP_ON", "On", ISS_OFF);
+    DiagnosticsDumpSP[DUMP_OFF].fill("DUMP_OFF", "Off", ISS_ON);
+    DiagnosticsDumpSP.fill(getDeviceName(),
+                           "DIAGNOSTICS_DUMP",
+                           "Dump to File",
+                           DIAGNOSTICS_TAB,
+                           IP_RW,
+                           ISR_1OFMANY,
+                           60,
+                           IPS_IDLE);
+
+    DiagnosticsFileTP[0].fill("DIAGNOSTICS_PATH", "Path", RP_PB_DIAGNOSTICS_FILE);
+    DiagnosticsFileTP.fill(getDeviceName(),
+                           "DIAGNOSTICS_FILE",
+                           "Dump File",
+                           DIAGNOSTICS_TAB,
+                           IP_RW,
+                           60,
+                           IPS_IDLE);
+
+    DiagnosticsResetSP[0].fill("DIAGNOSTICS_RESET", "Reset", ISS_OFF);
+    DiagnosticsResetSP.fill(getDeviceName(),
+                            "DIAGNOSTICS_RESET",
+                            "Histograms",
+                            DIAGNOSTICS_TAB,
+                            IP_RW,
+                            ISR_ATMOST1,
+                            60,
+                            IPS_IDLE);
+
+    // Register the update callbacks.
+    DiagnosticsDumpSP.onUpdate([this]
+                               { handleDiagnosticsDumpUpdate(); });
+    DiagnosticsFileTP.onUpdate([this]
+                               { handleDiagnosticsFileUpdate(); });
+    DiagnosticsResetSP.onUpdate([this]
+                                { handleDiagnosticsResetUpdate(); });
+}
+
+void RPiPowerBox::handleDiagnosticsDumpUpdate()
+{
+    // Write a first line at once so a bad path shows up immediately.
+    bool enabled = DiagnosticsDumpSP.findOnSwitchIndex() == DUMP_ON;
+    if (enabled && !dumpDiagnostics())
+    {
+        DiagnosticsDumpSP.setState(IPS_ALERT);
+    }
+    else
+    {
+        if (enabled)
+        {
+            LOGF_INFO("Dumping latency histograms to %s every %.0f s.", DiagnosticsFileTP[0].getText(),
+                      TaskPeriodsNP[TASK_DIAGNOSTICS].getValue());
+        }
+        DiagnosticsDumpSP.setState(IPS_OK);
+    }
+    DiagnosticsDumpSP.apply();
+}
+
+void RPiPowerBox::handleDiagnosticsFileUpdate()
+{
+    // Takes effect with the next dump; a new file starts with a header line.
+    DiagnosticsFileTP.setState(IPS_OK);
+    DiagnosticsFileTP.apply();
+}
+
+void RPiPowerBox::handleDiagnosticsResetUpdate()
+{
+    for (LatencyChannel &channel : latencies)
+    {
+        channel.histogram.reset();
+    }
+    LOG_INFO("Latency histograms cleared.");
+
+    DiagnosticsResetSP.reset();
+    DiagnosticsResetSP.setState(IPS_OK);
+    DiagnosticsResetSP.apply();
+    updateDiagnostics();
+}
+
+void RPiPowerBox::updateDiagnostics()
+{
+    for (LatencyChannel &channel : latencies)
+    {
+        LatencyHistogram::Summary summary = channel.histogram.summary();
+        if (summary.count == channel.NP[LATENCY_COUNT].getValue() && channel.NP.getState() != IPS_IDLE)
+        {
+            continue;
+        }
+
+        channel.NP[LATENCY_COUNT].setValue(summary.count);
+        channel.NP[LATENCY_MEAN].setValue(summary.mean / 1000);
+        channel.NP[LATENCY_P50].setValue(summary.p50 / 1000);
+        channel.NP[LATENCY_P90].setValue(summary.p90 / 1000);
+        channel.NP[LATENCY_P99].setValue(summary.p99 / 1000);
+        channel.NP[LATENCY_MAX].setValue(summary.max / 1000);
+        channel.NP.setState(IPS_OK);
+        channel.NP.apply();
+    }
+
+    if (DiagnosticsDumpSP.findOnSwitchIndex() == DUMP_ON && !dumpDiagnostics() &&
+        DiagnosticsDumpSP.getState() != IPS_ALERT)
+    {
+        DiagnosticsDumpSP.setState(IPS_ALERT);
+        DiagnosticsDumpSP.apply();
+    }
+}
+
+bool RPiPowerBox::dumpDiagnostics()
+{
+    const char *path = DiagnosticsFileTP[0].getText();
+    FILE *file = std::fopen(path, "a");
+    if (file == nullptr)
+    {
+        LOGF_ERROR("Failed to open %s: %s", path, std::strerror(errno));
+        return false;
+    }
+
+    // One line per histogram; the buckets are "lower bound in us:count" pairs.
+    if (std::ftell(file) == 0)
+    {
+        std::fprintf(file, "time,probe,count,mean_us,p50_us,p90_us,p99_us,max_us,buckets\n");
+    }
+
+    char timestamp[32];
+    std::time_t now = std::time(nullptr);
+    std::tm utc;
+    gmtime_r(&now, &utc);
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &utc);
+
+    for (const LatencyChannel &channel : latencies)
+    {
+        LatencyHistogram::Summary summary = channel.histogram.summary();
+        std::fprintf(file, "%s,%s,%llu,%.1f,%.0f,%.0f,%.0f,%.0f,", timestamp, channel.NP.getName(),
+                     static_cast<unsigned long long>(summary.count), summary.mean, summary.p50, summary.p90,
+                     summary.p99, summary.max);
+        const char *separator = "";
+        for (size_t i = 0; i < LatencyHistogram::bucketCount; ++i)
+        {
+            uint64_t count = channel.histogram.bucket(i);
+            if (count > 0)
+            {
+                std::fprintf(file, "%s%llu:%llu", separator,
+                             static_cast<unsigned long long>(LatencyHistogram::bucketLowerBound(i)),
+                             static_cast<unsigned long long>(count));
+                separator = " ";
+            }
+        }
+        std::fputc('\n', file);
+    }
+
+    bool ok = !std::ferror(file);
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok)
+    {
+        LOGF_ERROR("Failed to write %s", path);
+    }
+    return ok;
+}
+
+// ============================================================================
+// Telemetry
+// ============================================================================
+
+void RPiPowerBox::defineTelemetry()
+{
+    // Configure the recorder, available before connecting.
+    TelemetrySP[TELEMETRY_ON].fill("TELEMETRY_ON", "On", ISS_OFF);
+    TelemetrySP[TELEMETRY_OFF].fill("TELEMETRY_OFF", "Off", ISS_ON);
+    TelemetrySP.fill(getDeviceName(),
+                     "TELEMETRY",
+                     "Telemetry",
+                     DIAGNOSTICS_TAB,
+                     IP_RW,
+                     ISR_1OFMANY,
+                     60,
+                     IPS_IDLE);
+
+    TelemetryDirectoryTP[0].fill("TELEMETRY_PATH", "Path", RP_PB_TELEMETRY_DIR);
+    TelemetryDirectoryTP.fill(getDeviceName(),
+                              "TELEMETRY_DIRECTORY",
+                              "Telemetry Directory",
+                              DIAGNOSTICS_TAB,
+                              IP_RW,
+                              60,
+                              IPS_IDLE);
+
+    TelemetryNP[TLM_SIZE].fill("TLM_SIZE", "File size (MB)", "%0.f", 1, 1024, 1, RP_PB_TELEMETRY_SIZE);
+    TelemetryNP[TLM_FLUSH].fill("TLM_FLUSH", "Flush interval (s)", "%0.f", 5, 3600, 5, RP_PB_TELEMETRY_FLUSH);
+    TelemetryNP.fill(getDeviceName(),
+                     "TELEMETRY_SETTINGS",
+                     "Telemetry Settings",
+                     DIAGNOSTICS_TAB,
+                     IP_RW,
+                     60,
+                     IPS_IDLE);
+
+    // Configure the counters of the session.
+    TelemetryStatusNP[TLM_STATUS_RECORDS].fill("TLM_RECORDS", "Records", "%0.f", 0, 1e12, 0, 0);
+    TelemetryStatusNP[TLM_STATUS_DROPPED].fill("TLM_DROPPED", "Dropped", "%0.f", 0, 1e12, 0, 0);
+    TelemetryStatusNP[TLM_STATUS_FLUSHES].fill("TLM_FLUSHES", "Flushes", "%0.f", 0, 1e12, 0, 0);
+    TelemetryStatusNP[TLM_STATUS_WRITTEN].fill("TLM_WRITTEN", "Written (MB)", "%0.2f", 0, 1e6, 0, 0);
+    TelemetryStatusNP.fill(getDeviceName(),
+                           "TELEMETRY_STATUS",
+                           "Telemetry Status",
+                           DIAGNOSTICS_TAB,
+                           IP_RO,
+                           60,
+                           IPS_IDLE);
+
+    TelemetryFileTP[0].fill("TELEMETRY_FILE", "File", "");
+    TelemetryFileTP.fill(getDeviceName(),
+                         "TELEMETRY_FILE",
+                         "Telemetry File",
+                         DIAGNOSTICS_TAB,
+                         IP_RO,
+                         60,
+                         IPS_IDLE);
+
+    // Register the update callbacks.
+    TelemetrySP.onUpdate([this]
+                         { handleTelemetryUpdate(); });
+    TelemetryDirectoryTP.onUpdate([this]
+                                  { handleTelemetryDirectoryUpdate(); });
+    TelemetryNP.onUpdate([this]
+                         { handleTelemetrySettingsUpdate(); });
+}
+
+void RPiPowerBox::handleTelemetryUpdate()
+{
+    // Before connecting, the switch only takes effect with the next session.
+    bool enabled = TelemetrySP.findOnSwitchIndex() == TELEMETRY_ON;
+    if (!isConnected())
+    {
+        TelemetrySP.setState(IPS_OK);
+    }
+    else if (enabled && !telemetry.running())
+    {
+        TelemetrySP.setState(startTelemetry() ? IPS_OK : IPS_ALERT);
+        TelemetryFileTP.apply();
+    }
+    else if (!enabled && telemetry.running())
+    {
+        telemetry.stop();
+        LOGF_INFO("Telemetry stopped; written to %s", telemetry.path().c_str());
+        TelemetrySP.setState(IPS_OK);
+    }
+    TelemetrySP.apply();
+    if (isConnected())
+    {
+        updateTelemetry();
+    }
+}
+
+void RPiPowerBox::handleTelemetryDirectoryUpdate()
+{
+    // Takes effect with the next session.
+    TelemetryDirectoryTP.setState(IPS_OK);
+    TelemetryDirectoryTP.apply();
+}
+
+void RPiPowerBox::handleTelemetrySettingsUpdate()
+{
+    // The flush interval applies at once; the file size with the next session.
+    telemetry.setFlushInterval(std::chrono::seconds(static_cast<int>(TelemetryNP[TLM_FLUSH].getValue())));
+    TelemetryNP.setState(IPS_OK);
+    TelemetryNP.apply();
+}
+
+bool RPiPowerBox::startTelemetry()
+{
+    std::string error;
+    uint64_t size = static_cast<uint64_t>(TelemetryNP[TLM_SIZE].getValue()) << 20;
+    auto interval = std::chrono::seconds(static_cast<int>(TelemetryNP[TLM_FLUSH].getValue()));
+    if (!telemetry.start(TelemetryDirectoryTP[0].getText(), getDeviceName(), size, interval, error))
+    {
+        LOGF_ERROR("Failed to start telemetry: %s", error.c_str());
+        return false;
+    }
+
+    LOGF_INFO("Recording telemetry to %s", telemetry.path().c_str());
+    TelemetryFileTP[0].setText(telemetry.path());
+    TelemetryFileTP.setState(IPS_OK);
+    return true;
+}
+
+void RPiPowerBox::updateTelemetry()
+{
+    TelemetryRecorder::Stats stats = telemetry.stats();
+    TelemetryStatusNP[TLM_STATUS_RECORDS].setValue(stats.records);
+    TelemetryStatusNP[TLM_STATUS_DROPPED].setValue(stats.dropped);
+    TelemetryStatusNP[TLM_STATUS_FLUSHES].setValue(stats.flushes);
+    TelemetryStatusNP[TLM_STATUS_WRITTEN].setValue(stats.bytes / 1048576.0);
+    TelemetryStatusNP.setState(!telemetry.running() ? IPS_IDLE : stats.dropped > 0 ? IPS_ALERT : IPS_OK);
+    TelemetryStatusNP.apply();
+}
+
+// ============================================================================
+// Snapshot Endpoint
+// ============================================================================
+
+void RPiPowerBox::defineSnapshot()
+{
+    // Configure the endpoint, available before connecting.
+    SnapshotSP[SNAPSHOT_ON].fill("SNAPSHOT_ON", "On", ISS_OFF);
+    SnapshotSP[SNAPSHOT_OFF].fill("SNAPSHOT_OFF", "Off", ISS_ON);
+    SnapshotSP.fill(getDeviceName(),
+                    "SNAPSHOT_SERVER",
+                    "Snapshot Socket",
+                    DIAGNOSTICS_TAB,
+                    IP_RW,
+                    ISR_1OFMANY,
+                    60,
+                    IPS_IDLE);
+
+    SnapshotSocketTP[0].fill("SNAPSHOT_PATH", "Path", RP_PB_SNAPSHOT_SOCKET);
+    SnapshotSocketTP.fill(getDeviceName(),
+                          "SNAPSHOT_SOCKET",
+                          "Snapshot Socket Path",
+                          DIAGNOSTICS_TAB,
+                          IP_RW,
+                          60,
+                          IPS_IDLE);
+
+    SnapshotStatusNP[SNAPSHOT_REQUESTS].fill("SNAPSHOT_REQUESTS", "Requests", "%0.f", 0, 1e12, 0, 0);
+    SnapshotStatusNP[SNAPSHOT_SIZE].fill("SNAPSHOT_SIZE", "Size (bytes)", "%0.f", 0, SnapshotServer::capacity, 0, 0);
+    SnapshotStatusNP.fill(getDeviceName(),
+                          "SNAPSHOT_STATUS",
+                          "Snapshot Status",
+                          DIAGNOSTICS_TAB,
+                          IP_RO,
+                          60,
+                          IPS_IDLE);
+
+    // Register the update callbacks.
+    SnapshotSP.onUpdate([this]
+                        { handleSnapshotUpdate(); });
+    SnapshotSocketTP.onUpdate([this]
+                              { handleSnapshotSocketUpdate(); });
+}
+
+void RPiPowerBox::handleSnapshotUpdate()
+{
+    // Before connecting, the switch only takes effect on Connect().
+    bool enabled = SnapshotSP.findOnSwitchIndex() == SNAPSHOT_ON;
+    if (!isConnected())
+    {
+        SnapshotSP.setState(IPS_OK);
+    }
+    else if (enabled && !snapshots.running())
+    {
+        SnapshotSP.setState(startSnapshotServer() ? IPS_OK : IPS_ALERT);
+    }
+    else if (!enabled && snapshots.running())
+    {
+        snapshots.stop();
+        LOG_INFO("Snapshot socket closed.");
+        SnapshotSP.setState(IPS_OK);
+    }
+    SnapshotSP.apply();
+}
+
+void RPiPowerBox::handleSnapshotSocketUpdate()
+{
+    SnapshotSocketTP.setState(IPS_OK);
+    if (snapshots.running() && !startSnapshotServer())
+    {
+        SnapshotSocketTP.setState(IPS_ALERT);
+    }
+    SnapshotSocketTP.apply();
+}
+
+bool RPiPowerBox::startSnapshotServer()
+{
+    std::string error;
+    if (!snapshots.start(SnapshotSocketTP[0].getText(), error))
+    {
+        LOGF_ERROR("Failed to open the snapshot socket: %s", error.c_str());
+        return false;
+    }
+
+    LOGF_INFO("Serving snapshots on %s", SnapshotSocketTP[0].getText());
+    snapshotTooLarge = false;
+    updateSnapshot();
+    return true;
+}
+
+void RPiPowerBox::updateSnapshot()
+{
+    if (!snapshots.running())
+    {
+        return;
+    }
+
+    // Names come from the channel table and sensor IDs, but escape them anyway.
+    auto quote = [](const std::string &text)
+    {
+        std::string quoted = "\"";
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                quoted += '\\';
+            }
+            quoted += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+        }
+        return quoted + "\"";
+    };
+    auto number = [](double value, const char *format = "%.3f")
+    {
+        char text[32];
+        if (!std::isfinite(value))
+        {
+            return std::string("null");
+        }
+        std::snprintf(text, sizeof(text), format, value);
+        return std::string(text);
+    };
+    auto state = [](IPState value)
+    {
+        static const char *const names[] = {"idle", "ok", "busy", "alert"};
+        return std::string("\"") + names[value] + "\"";
+    };
+
+    char timestamp[32];
+    std::time_t now = std::time(nullptr);
+    std::tm utc;
+    gmtime_r(&now, &utc);
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &utc);
+
+    std::string json = "{\"device\":" + quote(getDeviceName()) + ",\"time\":\"" + timestamp + "\"";
+
+    // Readings, with the health and error counters of each probe.
+    json += ",\"temperatures\":[";
+    for (size_t i = 0; i < TempNP.size(); ++i)
+    {
+        double errors = 0;
+        for (int c = COUNTER_CRC; c < COUNTER_RETRIES; ++c)
+        {
+            errors += i < tempCounters[c].NP.size() ? tempCounters[c].NP[i].getValue() : 0;
+        }
+        json += std::string(i > 0 ? "," : "") + "{\"id\":" + quote(TempNP[i].getLabel()) +
+                ",\"value\":" + number(TempNP[i].getValue()) +
+                ",\"health\":" + state(i < TempHealthLP.size() ? TempHealthLP[i].getState() : IPS_IDLE) +
+                ",\"errors\":" + number(errors, "%.0f") + "}";
+    }
+    json += "]";
+
+    // Output state as last requested.
+    json += ",\"switches\":[";
+    for (size_t i = 0; i < switchOutputs.size(); ++i)
+    {
+        const SwitchOutput &output = switchOutputs[i];
+        json += std::string(i > 0 ? "," : "") + "{\"name\":" + quote(output.channel.name) +
+                ",\"on\":" + (output.SP.findOnSwitchIndex() == SWITCH_ON ? "true" : "false") +
+                ",\"state\":" + state(output.SP.getState()) + "}";
+    }
+    json += "],\"heaters\":[";
+    for (size_t i = 0; i < heaterLoops.size(); ++i)
+    {
+        const HeaterLoop &loop = heaterLoops[i];
+        int mode = loop.ModeSP.findOnSwitchIndex();
+        bool tripped = i < ThermalWatchdog::maxGuards && tripsHandled[i];
+        json += std::string(i > 0 ? "," : "") + "{\"name\":" + quote(loop.name) +
+                ",\"duty\":" + number((*loop.heaterProp)[0].getValue(), "%.2f") +
+                ",\"mode\":" + quote(mode >= 0 ? loop.ModeSP[mode].getName() : "") +
+                ",\"target\":" + (mode > CONTROL_MANUAL ? number(loop.LoopNP[LOOP_TARGET].getValue()) : "null") +
+                ",\"tripped\":" + (tripped ? "true" : "false") +
+                ",\"state\":" + state(loop.heaterProp->getState()) + "}";
+    }
+    json += "]";
+
+    if (hasWeather)
+    {
+        json += ",\"weather\":{\"temperature\":" + number(WeatherNP[WX_TEMPERATURE].getValue()) +
+                ",\"humidity\":" + number(WeatherNP[WX_HUMIDITY].getValue(), "%.1f") +
+                ",\"dew_point\":" + number(WeatherNP[WX_DEW_POINT].getValue()) +
+                ",\"stale\":" + (weatherStale ? "true" : "false") + "}";
+    }
+    else
+    {
+        json += ",\"weather\":null";
+    }
+
+    // Health counters.
+    uint64_t overruns = 0;
+    for (int task = 0; task < TASK_N; ++task)
+    {
+        overruns += scheduler.stats(task).overruns;
+    }
+    json += ",\"health\":{\"gpio_link\":" + std::string(linkUp ? "true" : "false") +
+            ",\"gpio_reconnects\":" + number(GPIOLinkNP[LINK_REPLAYS].getValue(), "%.0f") +
+            ",\"watchdog_trips\":" + number(WatchdogStatusNP[WD_STATUS_TRIPS].getValue(), "%.0f") +
+            ",\"dew_risk\":" + (dewRisk ? "true" : "false") +
+            ",\"task_overruns\":" + std::to_string(overruns) +
+            ",\"telemetry_dropped\":" + std::to_string(telemetry.stats().dropped) + "}}";
+
+    // Log only when the snapshot outgrows the capacity or fits again, not on every tick.
+    bool tooLarge = !snapshots.publish(json);
+    if (tooLarge != snapshotTooLarge)
+    {
+        snapshotTooLarge = tooLarge;
+        if (tooLarge)
+        {
+            LOGF_WARN("Snapshot of %zu bytes exceeds %zu bytes; serving the previous one.", json.size(),
+                      SnapshotServer::capacity);
+        }
+        else
+        {
+            LOG_INFO("Snapshot fits again; serving the current one.");
+        }
+    }
+    snapshotSize = json.size();
+}
+
+void RPiPowerBox::updateSnapshotStatus()
+{
+    SnapshotStatusNP[SNAPSHOT_REQUESTS].setValue(snapshots.requests());
+    SnapshotStatusNP[SNAPSHOT_SIZE].setValue(snapshotSize);
+    SnapshotStatusNP.setState(!snapshots.running() ? IPS_IDLE : snapshotTooLarge ? IPS_ALERT : IPS_OK);
+    SnapshotStatusNP.apply();
+}
+
+// ============================================================================
+// Hardware Initialization and Sensor Handling
+// ============================================================================
+
+bool RPiPowerBox::initGPIO()
+{
+    // Create the selected backend, or the in-memory one in simulation.
+    if (isSimulation())
+    {
+        gpio = std::make_unique<SimulatedBackend>(
+            std::chrono::microseconds(static_cast<int>(SimulationNP[SIM_GPIO_LATENCY].getValue())));
+    }
+    else if (GPIOBackendSP.findOnSwitchIndex() == BACKEND_GPIOD)
+    {
+#ifdef HAVE_LIBGPIOD
+        gpio = std::make_unique<GpiodBackend>(GPIOD_CHIP, PWM_CHIP_PATH);
+#else
+        LOG_ERROR("This driver was built without libgpiod support.");
+        return false;
+#endif
+    }
+    else
+    {
+        gpio = std::make_unique<PigpiodBackend>();
+    }
+
+    // Record every write that reaches the hardware, latch heaters the
+    // watchdog cut, reconnect a backend whose daemon went away, and time
+    // every call. Replays pass through the latch, so they cannot turn a cut
+    // heater back on.
+    std::map<int, std::string> channelNames;
+    for (const SwitchOutput &output : switchOutputs)
+    {
+        channelNames[output.channel.pin] = output.channel.name;
+    }
+    for (const HeaterOutput &output : heaterOutputs)
+    {
+        channelNames[output.channel.pin] = output.channel.name;
+    }
+    gpio = std::make_unique<TelemetryBackend>(std::move(gpio), telemetry, std::move(channelNames));
+    auto interlocked = std::make_unique<InterlockBackend>(std::move(gpio));
+    interlock = interlocked.get();
+    auto supervised = std::make_unique<SupervisedBackend>(std::move(interlocked));
+    supervisor = supervised.get();
+    gpio = std::make_unique<InstrumentedBackend>(std::move(supervised), latencies[LAT_GPIO_CALL].histogram);
+    linkUp = true;
+
+    if (!gpio->open())
+    {
+        LOGF_ERROR("Failed to open %s GPIO backend: %s", gpio->name(), gpio->lastError().c_str());
+        gpio.reset();
+        interlock = nullptr;
+        supervisor = nullptr;
+        return false;
+    }
+
+    // Drive every output straight to its restored state: one write per pin
+    // and no mode queries. Outputs that survived a driver restart already
+    // hold this state, so they do not glitch. With a sequenced startup, the
+    // outputs of the power-up order start off and Connect() brings them up.
+    restoreOutputs();
+    startupTargets = takeStartupOutputs();
+    bool rv = true;
+    for (SwitchOutput &output : switchOutputs)
+    {
+        bool level = output.SP.findOnSwitchIndex() == SWITCH_ON;
+        rv = rv && gpio->setupOutput(output.channel.pin, level);
+        output.restoredLevel = level ? 1 : 0;
+    }
+    for (HeaterOutput &output : heaterOutputs)
+    {
+        rv = rv && configureHeaterPWM(output.channel, output.NP[0].getValue());
+        output.restoredDutyCycle = output.NP[0].getValue();
+    }
+
+    if (!rv)
+    {
+        LOGF_ERROR("Failed to initialize GPIO: %s", gpio->lastError().c_str());
+        gpio->close();
+        gpio.reset();
+        interlock = nullptr;
+        supervisor = nullptr;
+        return false;
+    }
+
+    LOG_INFO("GPIO successfully initialized.");
+    return true;
+}
+
+void RPiPowerBox::detectSensors()
+{
+    sensors.clear();
+    if (!scanSensors(sensors))
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < sensors.size(); ++i)
+    {
+        if (i == 0 || sensors[i].master != sensors[i - 1].master)
+        {
+            LOGF_INFO("Bus master %s: bulk read %s.", sensors[i].master.c_str(),
+                      TemperatureSampler::supportsBulkRead(sensors[i].master) ? "supported" : "not supported");
+        }
+        LOGF_INFO("Found sensor: %s", sensors[i].id.c_str());
+    }
+}
+
+bool RPiPowerBox::scanSensors(std::vector<Sensor> &found) const
+{
+    std::error_code ec;
+    std::vector<std::filesystem::directory_entry> entries;
+
+    // Collect all entries from the W1 devices directory.
+    for (const auto &entry : fs::directory_iterator(w1DevicesPath, ec))
+    {
+        if (ec)
+        {
+            LOGF_ERROR("Error reading directory: %s", ec.message().c_str());
+            return false;
+        }
+        if (entry.is_directory())
+        {
+            entries.push_back(entry);
+        }
+    }
+    if (ec)
+    {
+        LOGF_ERROR("Error reading directory: %s", ec.message().c_str());
+        return false;
+    }
+
+    // Populate sensors that match the expected SENSOR_PREFIX.
+    found.clear();
+    for (const auto &entry : entries)
+    {
+        std::string entryName = entry.path().filename().string();
+        if (entryName.rfind(SENSOR_PREFIX, 0) == 0)
+        {
+            Sensor sensor;
+            sensor.id = entryName;
+            sensor.path = (entry.path() / "w1_slave").string();
+
+            // Device entries link into their bus master's directory.
+            fs::path devicePath = fs::canonical(entry.path(), ec);
+            sensor.master = ec ? std::string() : devicePath.parent_path().string();
+            found.push_back(sensor);
+        }
+    }
+
+    // Sort sensors by bus master, then by ID, to ensure a consistent order.
+    std::sort(found.begin(), found.end(),
+              [](const Sensor &a, const Sensor &b)
+              {
+                  return a.master != b.master ? a.master < b.master : a.id < b.id;
+              });
+    return true;
+}
+
+void RPiPowerBox::checkSensorChanges()
+{
+    // sysfs raises no inotify events for w1 devices, so the directory is
+    // diffed instead; a scan is a handful of readdir() calls.
+    std::vector<Sensor> found;
+    if (!scanSensors(found))
+    {
+        return;
+    }
+
+    auto sameSensor = [](const Sensor &a, const Sensor &b)
+    {
+        return a.id == b.id && a.master == b.master;
+    };
+    if (std::equal(found.begin(), found.end(), sensors.begin(), sensors.end(), sameSensor))
+    {
+        return;
+    }
+
+    for (const Sensor &sensor : found)
+    {
+        if (std::none_of(sensors.begin(), sensors.end(), [&](const Sensor &s) { return sameSensor(s, sensor); }))
+        {
+            LOGF_INFO("Sensor connected: %s", sensor.id.c_str());
+        }
+    }
+    for (const Sensor &sensor : sensors)
+    {
+        if (std::none_of(found.begin(), found.end(), [&](const Sensor &s) { return sameSensor(s, sensor); }))
+        {
+            LOGF_WARN("Sensor disconnected: %s", sensor.id.c_str());
+        }
+    }
+
+    // Readings are ignored until the sampler has switched to the new list.
+    sensors = std::move(found);
+    sensorGeneration = sampler.setSensors(sensors);
+    updatePassDuration();
+    sampler.setPeriod(acquisitionPeriod());
+
+    // Elements are keyed by sensor ID, so clients keep following the remaining probes.
+    withdrawTemperatureProperties();
+    defineTemperatureProbes();
+    publishTemperatureProperties();
+}
+
+IPState RPiPowerBox::updateSensorHealth(size_t index, const TemperatureReading &reading)
+{
+    IPState state = reading.health == SensorHealth::OK      ? IPS_OK
+                    : reading.health == SensorHealth::STALE ? IPS_BUSY
+                                                            : IPS_ALERT;
+    IPState previous = TempHealthLP[index].getState();
+    if (state == previous)
+    {
+        return state;
+    }
+    TempHealthLP[index].setState(state);
+
+    const char *cause = "";
+    switch (reading.status)
+    {
+    case SensorReadStatus::OK:
+        break;
+    case SensorReadStatus::OPEN_FAILED:
+        cause = "failed to open its attributes";
+        break;
+    case SensorReadStatus::CRC_FAILED:
+        cause = "CRC check failed";
+        break;
+    case SensorReadStatus::PARSE_FAILED:
+        cause = "unreadable temperature record";
+        break;
+    }
+
+    // Only transitions are logged, so a flaky probe does not flood the log.
+    const char *id = sensors[index].id.c_str();
+    switch (state)
+    {
+    case IPS_OK:
+        if (previous != IPS_IDLE)
+        {
+            LOGF_INFO("Sensor %s recovered.", id);
+        }
+        break;
+    case IPS_BUSY:
+        LOGF_WARN("Sensor %s: %s; keeping its last reading.", id, cause);
+        break;
+    default:
+        LOGF_ERROR("Sensor %s failed: %s (%llu CRC, %llu open, %llu parse errors).", id, cause,
+                   static_cast<unsigned long long>(reading.crcErrors),
+                   static_cast<unsigned long long>(reading.openErrors),
+                   static_cast<unsigned long long>(reading.parseErrors));
+        break;
+    }
+    return state;
+}
+
+void RPiPowerBox::updateTemperatureReadings()
+{
+    // Nothing to do until the sampler publishes a new pass over the current sensors.
+    if (!sampler.latest(samples) || samples.generation != sensorGeneration)
+    {
+        return;
+    }
+
+    // Once the sampler has written a new resolution, redefine the readings
+    // with the matching number format.
+    if (samples.resolution != 0 && samples.resolution != appliedResolution)
+    {
+        appliedResolution = samples.resolution;
+        if (samples.resolutionErrors > 0)
+        {
+            LOGF_ERROR("Failed to set %d bit resolution on %zu sensor(s).", appliedResolution,
+                       samples.resolutionErrors);
+            TempResolutionSP.setState(IPS_ALERT);
+        }
+        else
+        {
+            TempResolutionSP.setState(IPS_OK);
+        }
+        TempResolutionSP.apply();
+
+        withdrawTemperatureProperties();
+        defineTemperatureProbes();
+        publishTemperatureProperties();
+    }
+
+    // Copy the readings. A failing sensor only affects its own element: it
+    // keeps its last good value, flagged stale on its health light, until
+    // the sampler declares it failed.
+    IPState overall = IPS_OK;
+    bool healthChanged = false;
+    for (size_t i = 0; i < sensors.size() && i < samples.readings.size(); ++i)
+    {
+        const TemperatureReading &reading = samples.readings[i];
+        TempNP[i].setValue(reading.value);
+
+        IPState previous = TempHealthLP[i].getState();
+        IPState state = updateSensorHealth(i, reading);
+        healthChanged |= state != previous;
+        if (state == IPS_ALERT || (state == IPS_BUSY && overall == IPS_OK))
+        {
+            overall = state;
+        }
+
+        tempCounters[COUNTER_CRC].NP[i].setValue(reading.crcErrors);
+        tempCounters[COUNTER_OPEN].NP[i].setValue(reading.openErrors);
+        tempCounters[COUNTER_PARSE].NP[i].setValue(reading.parseErrors);
+        tempCounters[COUNTER_RETRIES].NP[i].setValue(reading.retries);
+    }
+
+    TempNP.setState(overall);
+
+    // Health changes go out at once; the values wait for the publish task.
+    if (healthChanged || TempHealthLP.getState() != overall)
+    {
+        TempHealthLP.setState(overall);
+        TempHealthLP.apply();
+    }
+
+    // Copy the statistics computed by the sampler over its history window.
+    for (size_t i = 0; i < sensors.size() && i < samples.stats.size(); ++i)
+    {
+        const TemperatureStats &stats = samples.stats[i];
+        tempStatistics[STAT_SLOPE].NP[i].setValue(stats.slope);
+        tempStatistics[STAT_MIN].NP[i].setValue(stats.minimum);
+        tempStatistics[STAT_MAX].NP[i].setValue(stats.maximum);
+        tempStatistics[STAT_MEAN].NP[i].setValue(stats.mean);
+        tempStatistics[STAT_COUNT].NP[i].setValue(stats.count);
+    }
+    for (TemperatureStatistic &statistic : tempStatistics)
+    {
+        statistic.NP.setState(IPS_OK);
+    }
+    for (TemperatureStatistic &counter : tempCounters)
+    {
+        counter.NP.setState(IPS_OK);
+    }
+}
+
+void RPiPowerBox::publishTemperatureReadings()
+{
+    publish(TempNP, tempPublisher);
+    for (TemperatureStatistic &statistic : tempStatistics)
+    {
+        publish(statistic.NP, statistic.publisher);
+    }
+    for (TemperatureStatistic &counter : tempCounters)
+    {
+        publish(counter.NP, counter.publisher);
     }
-    TempNP.apply();
 }
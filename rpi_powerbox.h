@@ -4,30 +4,88 @@
 // INCLUDES
 // ============================================================================
 #include "libindi/defaultdevice.h"
+#include "libindi/inditimer.h"
 #include "gpioconnection.h"
-#include <pigpiod_if2.h>
+#include "gpiobackend.h"
+#include "gpiocommandqueue.h"
+#include "interlockbackend.h"
+#include "channeltable.h"
+#include "latencyhistogram.h"
+#include "mainloopdispatcher.h"
+#include "pidcontroller.h"
+#include "powerprofile.h"
+#include "powersequencer.h"
+#include "publishpolicy.h"
+#include "simulatedw1bus.h"
+#include "snapshotserver.h"
+#include "supervisedbackend.h"
+#include "taskscheduler.h"
+#include "telemetryrecorder.h"
+#include "temperaturesampler.h"
+#include "thermalwatchdog.h"
+#include <array>
+#include <deque>
+#include <functional>
+#include <map>
 
 // ============================================================================
 // MACROS & CONSTANTS
 // ============================================================================
-#define RPI_PB_GPIO_POWER 8
-#define RPI_PB_GPIO_AUX 7
-#define RP_PB_GPIO_HEATER0 12
-#define RP_PB_GPIO_HEATER1 13
+// Outputs of the original board: two switched rails and two heaters on the PWM0/PWM1 pins.
+#define RP_PB_CHANNELS "MAIN_POWER,switch,8,on,Main Power; AUX_POWER,switch,7,on,Auxiliary Power; " \
+                       "HEATER_0,pwm,12,0,Heater 0; HEATER_1,pwm,13,0,Heater 1"
 #define RP_PB_PWM_FREQ 8000
 
+// Power-up and power-down orders; see parsePowerSequence() for the syntax.
+#define RP_PB_SEQUENCE_UP "MAIN_POWER AUX_POWER@2 HEATER_0@1/10 HEATER_1@1/10"
+#define RP_PB_SEQUENCE_DOWN "HEATER_0/5 HEATER_1/5 AUX_POWER@5 MAIN_POWER@2"
+
+// Command queue keys for commands not tied to one pin (pins use their GPIO number).
+#define RP_PB_KEY_HEATER_PWM -1
+#define RP_PB_KEY_POWER_PROFILE -2
+#define RP_PB_KEY_DESCRIBE -3
+#define RP_PB_KEY_SEQUENCE -4
+#define RP_PB_KEY_LINK -5
+
+#define GPIOD_CHIP "gpiochip0"
+#define PWM_CHIP_PATH "/sys/class/pwm/pwmchip0"
+
 #define W1_DEVICES_PATH "/sys/bus/w1/devices"
 #define SENSOR_PREFIX "28-"
 
-// ============================================================================
-// SENSOR STRUCTURE
-// ============================================================================
-// Structure representing a temperature sensor.
-struct Sensor
-{
-    std::string id;
-    std::string path;
-};
+#define SIMULATION_TAB "Simulation"
+#define DEW_CONTROL_TAB "Dew Control"
+#define TRENDS_TAB "Trends"
+#define SENSOR_HEALTH_TAB "Sensor Health"
+#define SCHEDULER_TAB "Scheduler"
+#define DIAGNOSTICS_TAB "Diagnostics"
+#define SAFETY_TAB "Safety"
+
+#define RP_PB_HISTORY_WINDOW 10 // Temperature statistics window in minutes.
+#define RP_PB_SAMPLE_PERIOD 1   // Interval between sensor snapshot copies in seconds.
+#define RP_PB_PUBLISH_PERIOD 1  // Interval between property publications in seconds.
+#define RP_PB_HOTPLUG_PERIOD 5  // Interval between sensor directory scans in seconds.
+#define RP_PB_HEALTH_PERIOD 10  // Interval between health checks in seconds.
+#define RP_PB_DIAGNOSTICS_PERIOD 10 // Interval between latency updates and dumps in seconds.
+#define RP_PB_LINK_PERIOD 1     // Interval between GPIO backend heartbeats in seconds.
+#define RP_PB_DIAGNOSTICS_FILE "/tmp/indi_rpi_pb_latency.csv"
+#define RP_PB_TELEMETRY_DIR "/var/tmp/indi_rpi_pb" // Directory of the per-session telemetry files.
+#define RP_PB_TELEMETRY_SIZE 64                    // Space preallocated per telemetry file in MB.
+#define RP_PB_TELEMETRY_FLUSH 60                   // Longest time telemetry waits in memory in seconds.
+#define RP_PB_SNAPSHOT_SOCKET "/tmp/indi_rpi_pb.sock"
+#define RP_PB_READ_RETRIES 2    // Repeated reads of a failing sensor per pass.
+#define RP_PB_FAILED_PASSES 3   // Failed passes in a row before a sensor is reported failed.
+
+#define RP_PB_CONTROL_PERIOD 2 // Dew heater control period in seconds.
+#define RP_PB_DEW_RISK_SPREAD 3    // Margin above the dew point, in degrees, that counts as dew risk.
+#define RP_PB_DEW_RISK_PERIOD 0.5  // Sampling, publishing and control period in seconds during dew risk.
+
+#define RP_PB_WATCHDOG_LIMIT 40   // Highest heater probe temperature in degrees before the heater is cut.
+#define RP_PB_WATCHDOG_STALE 60   // Seconds without a heater probe reading before the heater is cut.
+#define RP_PB_WATCHDOG_PERIOD 100 // Watchdog check period in milliseconds.
+
+#define RP_PB_WEATHER_DEVICE "Weather Simulator"
+#define RP_PB_WEATHER_TIMEOUT 300 // Seconds without weather updates before the data is flagged stale.
 
 // ============================================================================
 // RPiPowerBox DEVICE CLASS
@@ -54,8 +112,10 @@ public:
     bool Disconnect() override;
     virtual const char *getDefaultName() override;
     virtual bool initProperties() override;
+    virtual void ISGetProperties(const char *dev) override;
     virtual bool updateProperties() override;
-    virtual void TimerHit() override;
+    virtual bool saveConfigItems(FILE *fp) override;
+    virtual bool ISSnoopDevice(XMLEle *root) override;
 
 private:
     // ------------------------------------------------------------------------
@@ -68,7 +128,7 @@ private:
     // Hardware Initialization & Sensor Handling
     // ------------------------------------------------------------------------
     /**
-     * @brief Initializes the GPIO pins and sets their modes.
+     * @brief Creates the selected GPIO backend, initializes the GPIO pins and sets their modes.
      * @return true if successful, false otherwise.
      */
     bool initGPIO();
@@ -79,47 +139,262 @@ private:
     void detectSensors();
 
     /**
-     * @brief Updates the temperature readings from detected sensors.
+     * @brief Lists the sensors in the devices directory, sorted by bus master and ID.
+     *
+     * @param found Receives the sensors.
+     * @return false if the directory could not be read.
+     */
+    bool scanSensors(std::vector<Sensor> &found) const;
+
+    /**
+     * @brief Rescans the devices directory and follows sensors that appeared or disappeared.
+     *
+     * Run by the hot-plug task. Remaining sensors keep their element names and history.
+     */
+    void checkSensorChanges();
+
+    /**
+     * @brief Copies the latest sampler snapshot into the temperature property.
+     *
+     * Never blocks on sysfs; the sensors are read by the sampler thread.
      */
     void updateTemperatureReadings();
 
+    /**
+     * @brief Sends the temperature readings, statistics and counters through their publishing policies.
+     */
+    void publishTemperatureReadings();
+
     // ------------------------------------------------------------------------
     // INDI Property Definitions
     // ------------------------------------------------------------------------
+    /**
+     * @brief Defines the GPIO backend and connection properties and the backend's update handler.
+     */
+    void defineGPIOBackend();
+
+    /**
+     * @brief Handles updates for the GPIO backend property.
+     */
+    void handleGPIOBackendUpdate();
+
+    /**
+     * @brief Queues a heartbeat of the GPIO backend; run by the link task.
+     *
+     * A lost connection is reopened and the outputs replayed by the
+     * SupervisedBackend on the worker thread.
+     */
+    void checkGPIOLink();
+
+    /**
+     * @brief Reports a lost or restored GPIO connection and refreshes the link counters.
+     *
+     * @param status The supervisor's state after the heartbeat.
+     * @param error Why the heartbeat failed, if it did.
+     */
+    void updateGPIOLink(const SupervisedBackend::Status &status, const std::string &error);
+
+    /**
+     * @brief Defines the simulation script property.
+     */
+    void defineSimulation();
+
     /**
      * @brief Defines the temperature probe properties.
      */
     void defineTemperatureProbes();
 
     /**
-     * @brief Defines the power switch property and its update handler.
+     * @brief Sends the temperature reading and statistics definitions to clients.
+     */
+    void publishTemperatureProperties();
+
+    /**
+     * @brief Withdraws the temperature reading and statistics properties from clients.
+     */
+    void withdrawTemperatureProperties();
+
+    /**
+     * @brief Defines the sensor retry policy property and its update handler.
+     */
+    void defineTemperatureRetries();
+
+    /**
+     * @brief Handles updates for the sensor retry policy property.
+     */
+    void handleTemperatureRetriesUpdate();
+
+    /**
+     * @brief Updates a sensor's health light and logs the transition.
+     *
+     * @param index The sensor index.
+     * @param reading The sensor's latest reading.
+     * @return The light state matching the sensor's health.
+     */
+    IPState updateSensorHealth(size_t index, const TemperatureReading &reading);
+
+    /**
+     * @brief Defines the history window property and its update handler.
+     */
+    void defineTemperatureHistory();
+
+    /**
+     * @brief Handles updates for the history window property.
+     */
+    void handleTemperatureHistoryUpdate();
+
+    /**
+     * @brief Defines the temperature acquisition mode property and its update handler.
+     */
+    void defineTemperatureAcquisition();
+
+    /**
+     * @brief Handles updates for the temperature acquisition mode property.
+     */
+    void handleTemperatureAcquisitionUpdate();
+
+    /**
+     * @brief Defines the temperature resolution property and its update handler.
+     */
+    void defineTemperatureResolution();
+
+    /**
+     * @brief Handles updates for the temperature resolution property.
+     */
+    void handleTemperatureResolutionUpdate();
+
+    /**
+     * @brief Returns the selected sensor resolution in bits.
+     */
+    int temperatureResolution() const;
+
+    /**
+     * @brief Returns the interval the sampler should run at.
+     *
+     * This is the sample task period, stretched when one acquisition pass at
+     * the selected resolution cannot complete within it.
+     */
+    std::chrono::milliseconds acquisitionPeriod() const;
+
+    /**
+     * @brief Works out the conversion time of one acquisition pass for acquisitionPeriod().
+     *
+     * Checks each bus master for bulk reads, so it is only called when the
+     * sensors, the acquisition mode or the resolution change.
+     */
+    void updatePassDuration();
+
+    // ------------------------------------------------------------------------
+    // Output Channels
+    // ------------------------------------------------------------------------
+    struct SwitchOutput;
+    struct HeaterOutput;
+
+    /**
+     * @brief Defines the channel table property and its update handler.
+     */
+    void defineChannelTable();
+
+    /**
+     * @brief Handles updates for the channel table property.
+     *
+     * The outputs are rebuilt at once while disconnected, otherwise on the next connection.
+     */
+    void handleChannelTableUpdate();
+
+    /**
+     * @brief Rebuilds the outputs and their properties from the channel table property.
+     *
+     * Only called while disconnected, when no output property is defined.
+     *
+     * @return false if the table is invalid; the outputs are then left unchanged.
+     */
+    bool buildOutputs();
+
+    /**
+     * @brief Defines the property of a switched output and its update handler.
+     */
+    void defineSwitchOutput(SwitchOutput &output);
+
+    /**
+     * @brief Handles updates for a switched output property.
+     */
+    void handleSwitchOutputUpdate(SwitchOutput &output);
+
+    /**
+     * @brief Defines the duty cycle property of a PWM output and its update handler.
+     */
+    void defineHeaterOutput(HeaterOutput &output);
+
+    /**
+     * @brief Loads the last saved state of every output into its property.
+     *
+     * The output properties are only defined once connected, so the state is
+     * read from the configuration file directly. Outputs without a saved
+     * state take their channel default.
+     */
+    void restoreOutputs();
+
+    /**
+     * @brief Marks the output state as changed, to be saved by saveOutputs().
+     *
+     * Called for changes requested by a client; closed-loop duty cycles are
+     * not marked, to spare the SD card.
+     */
+    void persistOutputs();
+
+    /**
+     * @brief Saves the configuration once if the output state changed since the last save.
+     *
+     * Called from the health task and on disconnect, so that slider drags
+     * and profiles cost one write.
+     */
+    void saveOutputs();
+
+    /**
+     * @brief Returns the carrier frequency of a PWM output in Hz.
+     *
+     * This is the channel's own frequency, or the shared heater PWM frequency.
+     * Staggered heaters share one period, so they all use the shared frequency.
      */
-    void definePowerSwitch();
+    unsigned heaterFrequency(const ChannelConfig &channel) const;
 
     /**
-     * @brief Handles updates for the power switch property.
+     * @brief Queues a switched output change and reports it through its property.
+     *
+     * The property is set Busy until the backend has confirmed the write.
+     *
+     * @param switchProp The switch property for the output.
+     * @param gpioPin The GPIO pin associated with the output.
+     * @param level The level to drive.
      */
-    void handlePowerUpdate();
+    void submitSwitch(INDI::PropertySwitch &switchProp, int gpioPin, bool level);
 
     /**
-     * @brief Defines the auxiliary switch property and its update handler.
+     * @brief Queues a GPIO command whose completion is dropped once disconnected.
+     *
+     * @param key Identifies the output; see GPIOCommandQueue::submit().
+     * @param operation The command, run on the queue's worker thread.
+     * @param completion Called on the INDI thread with the outcome.
      */
-    void defineAuxSwitch();
+    void submitGPIO(int key, GPIOCommandQueue::Operation operation, GPIOCommandQueue::Completion completion);
 
     /**
-     * @brief Handles updates for the auxiliary switch property.
+     * @brief Defines the power profile selection and definition properties and their update handlers.
      */
-    void handleAuxUpdate();
+    void definePowerProfiles();
 
     /**
-     * @brief Defines the heater duty cycle property for Heater 0.
+     * @brief Handles updates for the power profile selection property.
+     *
+     * Drives the switched outputs in one bank write, then sets the heaters.
      */
-    void defineHeater0DutyCycle();
+    void handlePowerProfileUpdate();
 
     /**
-     * @brief Defines the heater duty cycle property for Heater 1.
+     * @brief Handles updates for the power profile definitions.
      */
-    void defineHeater1DutyCycle();
+    void handlePowerProfileDefinitionsUpdate();
 
     /**
      * @brief Common handler for updating heater properties.
@@ -127,44 +402,1039 @@ private:
      * This function updates the PWM duty cycle for the specified heater,
      * logs the change, updates the heater's state, and applies the property.
      *
-     * @param heaterProp The numeric property for the heater.
+     * @param output The heater output.
+     */
+    void handleHeaterUpdate(HeaterOutput &output);
+
+    /**
+     * @brief Queues a heater duty cycle write and reports it through the heater property.
+     *
+     * @param heaterProp The numeric property for the heater; its value is set to dutyCycle.
      * @param gpioPin The GPIO pin associated with the heater.
      * @param heaterName A string identifier for logging.
+     * @param dutyCycle The duty cycle in percent.
+     */
+    void submitHeaterDutyCycle(INDI::PropertyNumber &heaterProp, int gpioPin, const std::string &heaterName,
+                               double dutyCycle);
+
+    /**
+     * @brief Returns a heater to manual control after its duty cycle was set by hand.
+     *
+     * @param heaterProp The numeric property for the heater.
+     */
+    void releaseHeaterControl(INDI::PropertyNumber &heaterProp);
+
+    /**
+     * @brief Defines the heater PWM mode and frequency properties and their update handlers.
+     */
+    void defineHeaterPWM();
+
+    /**
+     * @brief Handles updates for the heater PWM mode and frequency properties.
+     *
+     * Reconfigures every heater pin and re-applies its current duty cycle.
+     */
+    void handleHeaterPWMUpdate();
+
+    /**
+     * @brief Configures a heater pin for the selected PWM mode and its frequency.
+     *
+     * Used while connecting, before the command queue runs. Falls back to the
+     * other PWM mode when the selected one is unavailable.
+     *
+     * @param channel The heater's channel.
+     * @param dutyCycle The duty cycle in percent to start at.
+     * @return true if successful, false otherwise.
+     */
+    bool configureHeaterPWM(const ChannelConfig &channel, double dutyCycle);
+
+    /**
+     * @brief Configures a heater pin for a PWM mode and frequency.
+     *
+     * Falls back to the first of hardware and software PWM the backend
+     * offers on the pin when the requested mode is unavailable.
+     * Only touches the backend, so it may run on the command queue's worker.
+     *
+     * @param backend The GPIO backend.
+     * @param gpioPin The GPIO pin associated with the heater.
+     * @param frequency The carrier frequency in Hz.
+     * @param mode The requested mode; receives the mode actually configured.
+     * @param dutyCycle The duty cycle in percent to start at.
+     * @return true if successful, false otherwise.
+     */
+    static bool setupHeaterPWM(GPIOBackend &backend, int gpioPin, unsigned frequency, PWMMode &mode,
+                               double dutyCycle);
+
+    /**
+     * @brief Returns the PWM mode selected in the heater PWM mode property.
+     */
+    PWMMode selectedHeaterPWMMode() const;
+
+    /**
+     * @brief Reflects a PWM mode fallback in the heater PWM mode property.
+     *
+     * @param requested The mode that was selected.
+     * @param used The mode actually configured.
+     */
+    void applyHeaterPWMMode(PWMMode requested, PWMMode used);
+
+    /**
+     * @brief Returns the heater PWM mode property's switch for a PWM mode.
+     */
+    static int heaterPWMModeIndex(PWMMode mode);
+
+    /**
+     * @brief Writes a heater duty cycle, clamped to 0 to 100 percent.
+     *
+     * @param backend The GPIO backend.
+     * @param gpioPin The GPIO pin associated with the heater.
+     * @param dutyCycle The duty cycle in percent.
+     * @return true if successful, false otherwise.
      */
-    void handleHeaterUpdate(INDI::PropertyNumber &heaterProp, int gpioPin, const std::string &heaterName);
+    static bool writeHeaterDutyCycle(GPIOBackend &backend, int gpioPin, double dutyCycle);
 
     // ------------------------------------------------------------------------
-    // Private Data Members
+    // Power Sequencing
+    // ------------------------------------------------------------------------
+    struct SequencedOutput;
+
+    /**
+     * @brief Defines the power sequence properties and their update handlers.
+     */
+    void defineSequencer();
+
+    /**
+     * @brief Handles updates for the power-up and power-down orders.
+     */
+    void handleSequenceOrderUpdate();
+
+    /**
+     * @brief Handles updates for the startup behaviour.
+     */
+    void handleSequenceStartupUpdate();
+
+    /**
+     * @brief Handles the abort button of the running power sequence.
+     */
+    void handleSequenceAbortUpdate();
+
+    /**
+     * @brief Returns whether a power-up or power-down order is configured.
+     */
+    bool sequenced() const;
+
+    /**
+     * @brief Returns the state of every output, as shown by its property.
+     */
+    PowerProfile currentOutputs() const;
+
+    /**
+     * @brief Turns off the restored outputs of the power-up order, so that the
+     *        sequencer can bring them up after connecting.
+     *
+     * Outputs the hardware reports on already keep their state. Only the
+     * properties change; initGPIO() then drives the off state.
+     *
+     * @return The restored state of the outputs turned off.
+     */
+    PowerProfile takeStartupOutputs();
+
+    /**
+     * @brief Moves the outputs from one state to another in sequence.
+     *
+     * Outputs that go down follow the power-down order, then those that go up
+     * the power-up order. Outputs missing from the order of their direction
+     * change at once, before the ordered ones. A running sequence is aborted.
+     *
+     * @param from The current state of the outputs.
+     * @param to The target state; outputs it does not mention are left alone.
+     * @param done Called on completion or abort with whether all steps ran.
+     */
+    void runSequence(const PowerProfile &from, const PowerProfile &to, std::function<void(bool ok)> done);
+
+    /**
+     * @brief Queues one write of the sequencer and reports it through the output property.
+     *
+     * Runs on the sequencer thread, so it only reads the immutable channel
+     * and leaves the property to the completion.
+     */
+    void writeSequenced(const SequencedOutput &output, double value);
+
+    /**
+     * @brief Stops the running sequence, if any, and reports its outcome.
+     *
+     * @param ok Whether the sequence ran to its end.
+     */
+    void finishSequence(bool ok);
+
+    /**
+     * @brief Decides whether a client change to an output concerns the running sequence.
+     *
+     * A change to the value the sequence is already heading for, as made when
+     * the configuration is loaded after connecting, is left to the sequence.
+     * Any other change to an output of the sequence aborts it.
+     *
+     * @param gpioPin The GPIO pin of the output.
+     * @param value The new value; 0 or 1 for a switch, percent for PWM.
+     * @return true if the change is left to the sequence.
+     */
+    bool heldBySequence(int gpioPin, double value);
+
     // ------------------------------------------------------------------------
-    int piId = -1;               ///< Raspberry Pi connection ID (invalid until initialized).
-    std::vector<Sensor> sensors; ///< List of detected temperature sensors.
+    // Publishing
+    // ------------------------------------------------------------------------
+    /**
+     * @brief Sends a numeric property to clients if its publishing policy allows.
+     *
+     * @param property The property to publish.
+     * @param policy The property's publishing policy.
+     * @param compared The number of leading values compared against the deadband.
+     * @return true if the property was sent.
+     */
+    bool publish(INDI::PropertyNumber &property, PublishPolicy &policy, size_t compared);
+
+    /**
+     * @brief Sends a numeric property to clients if its publishing policy allows, comparing all values.
+     */
+    bool publish(INDI::PropertyNumber &property, PublishPolicy &policy);
+
+    /**
+     * @brief Defines the publishing policy and statistics properties and their update handlers.
+     */
+    void definePublishing();
+
+    /**
+     * @brief Applies the publishing policy properties to the policies.
+     */
+    void applyPublishPolicies();
+
+    /**
+     * @brief Refreshes the published/suppressed counters.
+     */
+    void updatePublishStats();
 
     // ------------------------------------------------------------------------
-    // INDI Property Enumerations & Instances
+    // Dew Heater Control
     // ------------------------------------------------------------------------
+    struct HeaterLoop;
 
-    // Enumerations for power switch states.
-    enum
-    {
-        PWR_ON,
-        PWR_OFF,
-        PWR_N
-    };
-    INDI::PropertySwitch PowerSP{PWR_N}; ///< INDI property for the main power switch.
+    /**
+     * @brief Defines the closed-loop control properties of a heater and their update handlers.
+     *
+     * @param loop The heater's control loop.
+     * @param output The heater; its channel name prefixes the property names.
+     */
+    void defineHeaterControl(HeaterLoop &loop, HeaterOutput &output);
 
-    // Enumerations for auxiliary switch states.
-    enum
-    {
-        AUX_ON,
-        AUX_OFF,
-        AUX_N
-    };
-    INDI::PropertySwitch AuxSP{AUX_N}; ///< INDI property for the auxiliary switch.
+    /**
+     * @brief Handles updates for a heater's control mode property.
+     *
+     * Entering a closed-loop mode restarts the controller from the current duty cycle.
+     */
+    void handleHeaterControlModeUpdate(HeaterLoop &loop);
 
-    // INDI properties for heater duty cycle control.
-    INDI::PropertyNumber Heater0NP{1}; ///< INDI property for Heater 0 duty cycle.
-    INDI::PropertyNumber Heater1NP{1}; ///< INDI property for Heater 1 duty cycle.
+    /**
+     * @brief Handles updates for a heater's controller settings property.
+     */
+    void handleHeaterControlSettingsUpdate(HeaterLoop &loop);
 
-    // INDI property for temperature sensor readings.
-    INDI::PropertyNumber TempNP{0}; ///< INDI property for temperature probes.
+    /**
+     * @brief Handles updates for a heater's probe assignment property.
+     */
+    void handleHeaterControlProbesUpdate(HeaterLoop &loop);
+
+    /**
+     * @brief Defines the control period property.
+     */
+    void defineControlPeriod();
+
+    /**
+     * @brief Handles updates for the control period property.
+     */
+    void handleControlPeriodUpdate();
+
+    /**
+     * @brief Runs one step of every closed-loop heater; run by the control task.
+     */
+    void runControlLoop();
+
+    /**
+     * @brief Runs one controller step of a heater.
+     *
+     * Holds the current duty cycle when a probe has no valid reading.
+     */
+    void updateHeaterLoop(HeaterLoop &loop, std::chrono::steady_clock::time_point now);
+
+    /**
+     * @brief Returns the ambient temperature for a heater.
+     *
+     * Uses the heater's ambient probe, or the weather station without one.
+     *
+     * @param loop The heater's control loop.
+     * @param value Receives the temperature in degrees Celsius.
+     * @return true if a temperature is available.
+     */
+    bool ambientTemperature(const HeaterLoop &loop, double &value) const;
+
+    /**
+     * @brief Returns the duty cycle needed to lift the optics above the dew point.
+     *
+     * Proportional to how far the dew point plus margin lies above ambient;
+     * 0 when the air is dry enough or no weather data has been received.
+     *
+     * @param loop The heater's control loop.
+     * @param ambient The ambient temperature in degrees Celsius.
+     */
+    double dewFeedForward(const HeaterLoop &loop, double ambient) const;
+
+    /**
+     * @brief Defines the weather snooping properties and their update handlers.
+     */
+    void defineWeather();
+
+    /**
+     * @brief Handles updates for the snooped devices property.
+     */
+    void handleActiveDevicesUpdate();
+
+    /**
+     * @brief Takes temperature and humidity from a snooped WEATHER_PARAMETERS message.
+     */
+    void handleWeatherSnoop(XMLEle *root);
+
+    /**
+     * @brief Refreshes the age of the weather data and flags it once stale.
+     */
+    void updateWeatherAge();
+
+    /**
+     * @brief Computes the dew point with the Magnus formula.
+     *
+     * @param temperature The air temperature in degrees Celsius.
+     * @param humidity The relative humidity in percent.
+     * @return The dew point in degrees Celsius.
+     */
+    static double dewPoint(double temperature, double humidity);
+
+    /**
+     * @brief Looks up the latest valid reading of a sensor.
+     *
+     * @param id The sensor ID, e.g. 28-0000075a1b2c.
+     * @param value Receives the temperature in degrees Celsius.
+     * @return true if the sensor exists and its last read succeeded.
+     */
+    bool findSensorReading(const std::string &id, double &value) const;
+
+    // ------------------------------------------------------------------------
+    // Heater Watchdog
+    // ------------------------------------------------------------------------
+    /**
+     * @brief Defines the heater watchdog properties and their update handlers.
+     */
+    void defineWatchdog();
+
+    /**
+     * @brief Handles updates for the watchdog limits property.
+     */
+    void handleWatchdogUpdate();
+
+    /**
+     * @brief Handles updates for the watchdog mode property; restarts a running watchdog.
+     */
+    void handleWatchdogModeUpdate();
+
+    /**
+     * @brief Handles the rearm button: clears the trips and lets the heaters run again.
+     */
+    void handleWatchdogRearmUpdate();
+
+    /**
+     * @brief Starts or stops the watchdog thread as the mode property selects.
+     *
+     * Trips stay latched across the restart. Falls back to normal priority,
+     * with a warning, if real-time scheduling is refused.
+     */
+    void startWatchdog();
+
+    /**
+     * @brief Guards each heater with its heater probe and the configured limits.
+     */
+    void configureWatchdog();
+
+    /**
+     * @brief Reports new trips and refreshes the watchdog counters; run by the publish task.
+     */
+    void updateWatchdog();
+
+    /**
+     * @brief Takes a heater the watchdog cut out of every control path.
+     *
+     * Switches the heater to manual at 0%, stops a sequence that moves it
+     * and flags its property, so nothing restores the duty cycle on rearm.
+     *
+     * @param loop The heater's control loop.
+     * @param cause Why the watchdog cut it.
+     * @param temperature The last reading of its probe.
+     */
+    void handleWatchdogTrip(HeaterLoop &loop, TripCause cause, double temperature);
+
+    // ------------------------------------------------------------------------
+    // Task Scheduling
+    // ------------------------------------------------------------------------
+    /**
+     * @brief Registers the driver's periodic tasks with the scheduler.
+     */
+    void registerTasks();
+
+    /**
+     * @brief Defines the task period, timing and dew risk properties and their update handlers.
+     */
+    void defineScheduler();
+
+    /**
+     * @brief Handles updates for the task period property.
+     */
+    void handleTaskPeriodsUpdate();
+
+    /**
+     * @brief Handles updates for the dew risk property.
+     */
+    void handleDewRiskUpdate();
+
+    /**
+     * @brief Applies the configured task periods, shortened while dew threatens.
+     */
+    void applyTaskPeriods();
+
+    /**
+     * @brief Runs the periodic health checks; run by the health task.
+     */
+    void runHealthChecks();
+
+    /**
+     * @brief Checks whether the coldest known temperature is close to the dew point.
+     */
+    bool detectDewRisk() const;
+
+    /**
+     * @brief Copies the scheduler timing into the task properties and reports new overruns.
+     */
+    void updateTaskStats();
+
+    // ------------------------------------------------------------------------
+    // Diagnostics
+    // ------------------------------------------------------------------------
+    /**
+     * @brief Points the scheduler, sampler, command queue and dispatcher at their histograms.
+     */
+    void attachLatencyHistograms();
+
+    /**
+     * @brief Defines the latency, dump and reset properties and their update handlers.
+     */
+    void defineDiagnostics();
+
+    /**
+     * @brief Handles updates for the dump switch.
+     */
+    void handleDiagnosticsDumpUpdate();
+
+    /**
+     * @brief Handles updates for the dump file path.
+     */
+    void handleDiagnosticsFileUpdate();
+
+    /**
+     * @brief Handles updates for the reset switch.
+     */
+    void handleDiagnosticsResetUpdate();
+
+    /**
+     * @brief Publishes the latency summaries and appends them to the dump file if enabled.
+     *
+     * Run by the diagnostics task.
+     */
+    void updateDiagnostics();
+
+    /**
+     * @brief Appends one line per histogram to the dump file.
+     *
+     * @return true if the file was written.
+     */
+    bool dumpDiagnostics();
+
+    // ------------------------------------------------------------------------
+    // Telemetry
+    // ------------------------------------------------------------------------
+    /**
+     * @brief Defines the telemetry properties and their update handlers.
+     */
+    void defineTelemetry();
+
+    /**
+     * @brief Handles updates for the telemetry switch; starts or stops a session while connected.
+     */
+    void handleTelemetryUpdate();
+
+    /**
+     * @brief Handles updates for the telemetry directory.
+     */
+    void handleTelemetryDirectoryUpdate();
+
+    /**
+     * @brief Handles updates for the telemetry file size and flush interval.
+     */
+    void handleTelemetrySettingsUpdate();
+
+    /**
+     * @brief Starts a telemetry session in a new file and shows its path.
+     *
+     * @return true if a session started.
+     */
+    bool startTelemetry();
+
+    /**
+     * @brief Publishes the telemetry counters; run by the diagnostics task.
+     */
+    void updateTelemetry();
+
+    // ------------------------------------------------------------------------
+    // Snapshot Endpoint
+    // ------------------------------------------------------------------------
+    /**
+     * @brief Defines the snapshot endpoint properties and their update handlers.
+     */
+    void defineSnapshot();
+
+    /**
+     * @brief Handles updates for the snapshot switch; starts or stops the server while connected.
+     */
+    void handleSnapshotUpdate();
+
+    /**
+     * @brief Handles updates for the snapshot socket path; moves a running server to it.
+     */
+    void handleSnapshotSocketUpdate();
+
+    /**
+     * @brief Starts serving snapshots on the configured socket.
+     *
+     * @return true if the server started.
+     */
+    bool startSnapshotServer();
+
+    /**
+     * @brief Composes the JSON snapshot of readings, outputs and health counters and publishes it.
+     *
+     * Run by the sample task while the server is running.
+     */
+    void updateSnapshot();
+
+    /**
+     * @brief Publishes the snapshot server counters; run by the diagnostics task.
+     */
+    void updateSnapshotStatus();
+
+    // ------------------------------------------------------------------------
+    // Private Data Members
+    // ------------------------------------------------------------------------
+    std::unique_ptr<GPIOBackend> gpio;     ///< GPIO backend (null until initialized).
+    MainLoopDispatcher dispatcher;         ///< Runs worker completions on the INDI thread.
+    GPIOCommandQueue commands{dispatcher}; ///< Sole user of the backend while connected.
+    bool outputsChanged = false;           ///< Output state changed since the last save.
+    std::string w1DevicesPath;             ///< Directory scanned for sensors.
+    SimulatedW1Bus simulatedBus;           ///< Fake sensor tree used in simulation.
+    std::vector<Sensor> sensors;           ///< List of detected temperature sensors.
+    TemperatureSampler sampler;            ///< Background reader for the temperature sensors.
+    TemperatureSnapshot samples;           ///< Last snapshot copied from the sampler.
+    int appliedResolution = 0;             ///< Resolution last confirmed by the sampler, 0 if none.
+    std::chrono::milliseconds passDuration{0}; ///< Conversion time of one acquisition pass.
+    uint64_t sensorGeneration = 0;         ///< Sampler generation matching sensors.
+    TaskScheduler scheduler;               ///< Runs the periodic tasks while connected.
+    bool dewRisk = false;                  ///< Whether the fast dew risk rate is in effect.
+    bool hasWeather = false;               ///< Whether weather data has been received.
+    bool weatherStale = false;             ///< Whether the weather data has timed out.
+    std::chrono::steady_clock::time_point weatherTime; ///< Time of the last weather update.
+    PublishPolicy tempPublisher;           ///< Publishing policy of TempNP.
+    PublishPolicy weatherPublisher;        ///< Publishing policy of WeatherNP.
+    PublishPolicy statsPublisher;          ///< Publishing policy of PublishStatsNP.
+    std::vector<double> publishValues;     ///< Scratch buffer for publish().
+
+    // ------------------------------------------------------------------------
+    // INDI Property Enumerations & Instances
+    // ------------------------------------------------------------------------
+
+    // Enumerations for GPIO backends.
+    enum
+    {
+        BACKEND_PIGPIOD,
+        BACKEND_GPIOD,
+        BACKEND_N
+    };
+    INDI::PropertySwitch GPIOBackendSP{BACKEND_N}; ///< INDI property for the GPIO backend.
+
+    // Enumerations for the GPIO connection counters.
+    enum
+    {
+        LINK_REPLAYS,
+        LINK_RECONNECT,
+        LINK_FAILED_ATTEMPTS,
+        LINK_N
+    };
+    INDI::PropertyNumber GPIOLinkNP{LINK_N}; ///< INDI property for the GPIO connection counters.
+    SupervisedBackend *supervisor = nullptr;  ///< Reconnecting layer inside gpio, null while disconnected.
+    bool linkUp = true;                       ///< Whether the GPIO connection was up at the last heartbeat.
+
+    // Enumerations for the simulation script.
+    enum
+    {
+        SIM_PROBES,
+        SIM_BUSES,
+        SIM_TEMPERATURE,
+        SIM_SWING,
+        SIM_SWING_PERIOD,
+        SIM_CRC_FAILURES,
+        SIM_CONVERSION_DELAY,
+        SIM_GPIO_LATENCY,
+        SIM_N
+    };
+    INDI::PropertyNumber SimulationNP{SIM_N}; ///< INDI property for the simulation script.
+
+    // Enumerations for switched output states.
+    enum
+    {
+        SWITCH_ON,
+        SWITCH_OFF,
+        SWITCH_N
+    };
+
+    /**
+     * @brief A switched output from the channel table.
+     */
+    struct SwitchOutput
+    {
+        ChannelConfig channel;             ///< Pin, name, label and default level.
+        INDI::PropertySwitch SP{SWITCH_N}; ///< INDI property for the switch.
+        int restoredLevel = -1;            ///< Level written on connection, -1 once the configuration is loaded.
+    };
+
+    /**
+     * @brief A PWM output from the channel table.
+     */
+    struct HeaterOutput
+    {
+        ChannelConfig channel;         ///< Pin, name, label, default duty cycle and frequency.
+        INDI::PropertyNumber NP{1};    ///< INDI property for the duty cycle.
+        double restoredDutyCycle = -1; ///< Duty cycle written on connection, -1 once the configuration is loaded.
+    };
+
+    // Outputs live in deques, as their handlers keep references to them.
+    std::vector<ChannelConfig> channels;    ///< Channel table the outputs were built from.
+    std::string channelTable;               ///< Text of that table, to detect changes.
+    std::deque<SwitchOutput> switchOutputs; ///< Switched outputs, in table order.
+    std::deque<HeaterOutput> heaterOutputs; ///< PWM outputs, in table order.
+    INDI::PropertyText ChannelsTP{1};       ///< INDI property for the channel table.
+
+    // Enumerations for power profiles.
+    enum
+    {
+        PROFILE_IMAGING,
+        PROFILE_PARK,
+        PROFILE_ALL_OFF,
+        PROFILE_N
+    };
+    INDI::PropertySwitch PowerProfileSP{PROFILE_N}; ///< INDI property for applying a power profile.
+    INDI::PropertyText PowerProfileTP{PROFILE_N};   ///< INDI property for the power profile definitions.
+
+    // Enumerations for the power sequence orders.
+    enum
+    {
+        SEQ_ORDER_UP,
+        SEQ_ORDER_DOWN,
+        SEQ_ORDER_N
+    };
+    INDI::PropertyText SequenceOrderTP{SEQ_ORDER_N}; ///< INDI property for the power-up and power-down orders.
+
+    // Enumerations for the startup behaviour.
+    enum
+    {
+        SEQ_STARTUP_SEQUENCED,
+        SEQ_STARTUP_IMMEDIATE,
+        SEQ_STARTUP_N
+    };
+    INDI::PropertySwitch SequenceStartupSP{SEQ_STARTUP_N}; ///< INDI property for sequencing the outputs at connection.
+
+    // Enumerations for the sequence progress.
+    enum
+    {
+        SEQ_STEP,
+        SEQ_STEPS,
+        SEQ_PROGRESS,
+        SEQ_PROGRESS_N
+    };
+    INDI::PropertyNumber SequenceProgressNP{SEQ_PROGRESS_N}; ///< INDI property for the running power sequence.
+    INDI::PropertySwitch SequenceAbortSP{1};                 ///< INDI property for aborting the power sequence.
+
+    /**
+     * @brief An output moved by the power sequencer; exactly one pointer is set.
+     */
+    struct SequencedOutput
+    {
+        SwitchOutput *switchOutput = nullptr; ///< The switched output, or null.
+        HeaterOutput *heaterOutput = nullptr; ///< The PWM output, or null.
+    };
+
+    PowerSequencer sequencer{dispatcher};      ///< Runs the power sequences.
+    std::map<int, double> sequenceTargets;     ///< Target of each output of the running sequence, by pin.
+    std::function<void(bool ok)> sequenceDone; ///< Reports the outcome of the running sequence.
+    PowerProfile startupTargets;               ///< Outputs the sequencer brings up after connecting.
+
+    // Enumerations for heater PWM modes.
+    enum
+    {
+        PWM_HARDWARE,
+        PWM_SOFTWARE,
+        PWM_STAGGERED,
+        PWM_N
+    };
+    INDI::PropertySwitch HeaterPWMModeSP{PWM_N}; ///< INDI property for the heater PWM mode.
+    INDI::PropertyNumber HeaterPWMFreqNP{1};     ///< INDI property for the heater PWM frequency.
+
+    // Enumerations for heater control modes.
+    enum
+    {
+        CONTROL_MANUAL,
+        CONTROL_TARGET,
+        CONTROL_OFFSET,
+        CONTROL_DEW_POINT,
+        CONTROL_N
+    };
+
+    // Enumerations for heater controller settings.
+    enum
+    {
+        PID_SETPOINT,
+        PID_OFFSET,
+        PID_KP,
+        PID_KI,
+        PID_KD,
+        PID_SLEW,
+        PID_DEW_MARGIN,
+        PID_FEED_FORWARD,
+        PID_N
+    };
+
+    // Enumerations for heater probe assignments.
+    enum
+    {
+        PROBE_HEATER,
+        PROBE_AMBIENT,
+        PROBE_N
+    };
+
+    // Enumerations for heater loop state.
+    enum
+    {
+        LOOP_TEMPERATURE,
+        LOOP_TARGET,
+        LOOP_ERROR,
+        LOOP_P,
+        LOOP_I,
+        LOOP_D,
+        LOOP_FEED_FORWARD,
+        LOOP_OUTPUT,
+        LOOP_N
+    };
+
+    /**
+     * @brief Closed-loop control of one heater.
+     */
+    struct HeaterLoop
+    {
+        int gpioPin = -1;                                  ///< GPIO pin of the heater.
+        std::string name;                                  ///< Heater name for logging, e.g. HEATER_0.
+        INDI::PropertyNumber *heaterProp = nullptr;        ///< The heater's duty cycle property.
+        PIDController pid;                                 ///< Controller driving the duty cycle.
+        PublishPolicy publisher;                           ///< Publishing policy of LoopNP.
+        std::chrono::steady_clock::time_point lastUpdate;  ///< Time of the last controller step.
+        INDI::PropertySwitch ModeSP{CONTROL_N};            ///< INDI property for the control mode.
+        INDI::PropertyNumber SettingsNP{PID_N};            ///< INDI property for setpoint and gains.
+        INDI::PropertyText ProbesTP{PROBE_N};              ///< INDI property for the probe assignment.
+        INDI::PropertyNumber LoopNP{LOOP_N};               ///< INDI property for the loop state.
+    };
+    std::deque<HeaterLoop> heaterLoops;         ///< Control loops, one per heater output.
+    INDI::PropertyNumber ControlPeriodNP{1};    ///< INDI property for the control period.
+
+    // Enumerations for the watchdog limits.
+    enum
+    {
+        WD_LIMIT,
+        WD_STALE,
+        WD_PERIOD,
+        WD_N
+    };
+    INDI::PropertyNumber WatchdogNP{WD_N}; ///< INDI property for the watchdog limits.
+
+    // Enumerations for the watchdog mode.
+    enum
+    {
+        WD_MODE_DISABLED,
+        WD_MODE_ENABLED,
+        WD_MODE_REALTIME,
+        WD_MODE_N
+    };
+    INDI::PropertySwitch WatchdogModeSP{WD_MODE_N}; ///< INDI property for the watchdog mode.
+
+    // Enumerations for the watchdog counters.
+    enum
+    {
+        WD_STATUS_TRIPS,
+        WD_STATUS_REACTION,
+        WD_STATUS_WAKEUP,
+        WD_STATUS_N
+    };
+    INDI::PropertyNumber WatchdogStatusNP{WD_STATUS_N}; ///< INDI property for the watchdog counters.
+    INDI::PropertySwitch WatchdogRearmSP{1};            ///< INDI property for rearming the watchdog.
+
+    ThermalWatchdog watchdog;                                    ///< Cuts runaway heaters from its own thread.
+    InterlockBackend *interlock = nullptr;                       ///< Latch inside gpio, null while disconnected.
+    std::array<bool, ThermalWatchdog::maxGuards> tripsHandled{}; ///< Trips already reported, by heater.
+
+    // Enumerations for publishing policy settings.
+    enum
+    {
+        PUBLISH_ABSOLUTE,
+        PUBLISH_RELATIVE,
+        PUBLISH_MAX_SILENCE,
+        PUBLISH_MIN_INTERVAL,
+        PUBLISH_N
+    };
+    INDI::PropertyNumber TempPublishNP{PUBLISH_N};    ///< INDI property for the temperature publishing policy.
+    INDI::PropertyNumber ControlPublishNP{PUBLISH_N}; ///< INDI property for the dew control publishing policy.
+
+    // Enumerations for publishing statistics.
+    enum
+    {
+        STATS_TEMP_PUBLISHED,
+        STATS_TEMP_SUPPRESSED,
+        STATS_CONTROL_PUBLISHED,
+        STATS_CONTROL_SUPPRESSED,
+        STATS_N
+    };
+    INDI::PropertyNumber PublishStatsNP{STATS_N}; ///< INDI property for the publishing counters.
+
+    // Enumerations for scheduled tasks, in registration order. Tasks before
+    // TASK_CONTROL take their period from TaskPeriodsNP; the control loop
+    // keeps its own in ControlPeriodNP.
+    enum
+    {
+        TASK_SAMPLE,
+        TASK_PUBLISH,
+        TASK_HOTPLUG,
+        TASK_HEALTH,
+        TASK_DIAGNOSTICS,
+        TASK_LINK,
+        TASK_CONTROL,
+        TASK_N
+    };
+    INDI::PropertyNumber TaskPeriodsNP{TASK_CONTROL}; ///< INDI property for the task periods.
+    INDI::PropertyNumber TaskOverrunsNP{TASK_N};      ///< INDI property for the task overrun counts.
+    INDI::PropertyNumber TaskRuntimeNP{TASK_N};       ///< INDI property for the longest task run times.
+    std::array<uint64_t, TASK_N> reportedOverruns{};  ///< Overruns already logged, per task.
+
+    // Enumerations for the dew risk rate.
+    enum
+    {
+        RISK_SPREAD,
+        RISK_PERIOD,
+        RISK_N
+    };
+    INDI::PropertyNumber DewRiskNP{RISK_N}; ///< INDI property for the dew risk rate.
+
+    // Enumerations for the instrumented code paths.
+    enum
+    {
+        LAT_TASK,
+        LAT_SENSOR_READ,
+        LAT_SENSOR_PASS,
+        LAT_GPIO_CALL,
+        LAT_COMMAND,
+        LAT_DISPATCH,
+        LAT_N
+    };
+
+    // Enumerations for a latency summary.
+    enum
+    {
+        LATENCY_COUNT,
+        LATENCY_MEAN,
+        LATENCY_P50,
+        LATENCY_P90,
+        LATENCY_P99,
+        LATENCY_MAX,
+        LATENCY_N
+    };
+
+    /**
+     * @brief A latency histogram and the property summarizing it.
+     */
+    struct LatencyChannel
+    {
+        LatencyHistogram histogram;          ///< Fed by the timing probes.
+        INDI::PropertyNumber NP{LATENCY_N};  ///< Count, mean, percentiles and maximum in ms.
+    };
+    std::array<LatencyChannel, LAT_N> latencies; ///< One channel per instrumented path.
+
+    // Enumerations for the dump switch.
+    enum
+    {
+        DUMP_ON,
+        DUMP_OFF,
+        DUMP_N
+    };
+    INDI::PropertySwitch DiagnosticsDumpSP{DUMP_N}; ///< INDI property enabling the dump file.
+    INDI::PropertyText DiagnosticsFileTP{1};       ///< INDI property for the dump file path.
+    INDI::PropertySwitch DiagnosticsResetSP{1};    ///< INDI property clearing the histograms.
+
+    // Enumerations for the telemetry switch.
+    enum
+    {
+        TELEMETRY_ON,
+        TELEMETRY_OFF,
+        TELEMETRY_N
+    };
+    INDI::PropertySwitch TelemetrySP{TELEMETRY_N}; ///< INDI property enabling telemetry.
+    INDI::PropertyText TelemetryDirectoryTP{1};   ///< INDI property for the telemetry directory.
+
+    // Enumerations for the telemetry settings.
+    enum
+    {
+        TLM_SIZE,
+        TLM_FLUSH,
+        TLM_N
+    };
+    INDI::PropertyNumber TelemetryNP{TLM_N}; ///< INDI property for the file size and flush interval.
+
+    // Enumerations for the telemetry counters.
+    enum
+    {
+        TLM_STATUS_RECORDS,
+        TLM_STATUS_DROPPED,
+        TLM_STATUS_FLUSHES,
+        TLM_STATUS_WRITTEN,
+        TLM_STATUS_N
+    };
+    INDI::PropertyNumber TelemetryStatusNP{TLM_STATUS_N}; ///< INDI property for the telemetry counters.
+    INDI::PropertyText TelemetryFileTP{1};                ///< INDI property for the current telemetry file.
+
+    TelemetryRecorder telemetry; ///< Records readings and output writes of the session.
+
+    // Enumerations for the snapshot switch.
+    enum
+    {
+        SNAPSHOT_ON,
+        SNAPSHOT_OFF,
+        SNAPSHOT_N
+    };
+    INDI::PropertySwitch SnapshotSP{SNAPSHOT_N}; ///< INDI property enabling the snapshot endpoint.
+    INDI::PropertyText SnapshotSocketTP{1};     ///< INDI property for the snapshot socket path.
+
+    // Enumerations for the snapshot counters.
+    enum
+    {
+        SNAPSHOT_REQUESTS,
+        SNAPSHOT_SIZE,
+        SNAPSHOT_STATUS_N
+    };
+    INDI::PropertyNumber SnapshotStatusNP{SNAPSHOT_STATUS_N}; ///< INDI property for the snapshot counters.
+
+    SnapshotServer snapshots;      ///< Serves the snapshot on a Unix domain socket.
+    size_t snapshotSize = 0;       ///< Length of the last published snapshot in bytes.
+    bool snapshotTooLarge = false; ///< Whether the last snapshot exceeded the capacity.
+
+    // Enumerations for snooped devices.
+    enum
+    {
+        ACTIVE_WEATHER,
+        ACTIVE_N
+    };
+    INDI::PropertyText ActiveDeviceTP{ACTIVE_N}; ///< INDI property for the snooped devices.
+
+    // Enumerations for snooped weather data.
+    enum
+    {
+        WX_TEMPERATURE,
+        WX_HUMIDITY,
+        WX_DEW_POINT,
+        WX_AGE,
+        WX_N
+    };
+    INDI::PropertyNumber WeatherNP{WX_N};    ///< INDI property for the last good weather data.
+    INDI::PropertyNumber WeatherTimeoutNP{1}; ///< INDI property for the weather timeout.
+
+    // INDI property for temperature sensor readings.
+    INDI::PropertyNumber TempNP{0}; ///< INDI property for temperature probes.
+
+    // Enumerations for windowed temperature statistics.
+    enum
+    {
+        STAT_SLOPE,
+        STAT_MIN,
+        STAT_MAX,
+        STAT_MEAN,
+        STAT_COUNT,
+        STAT_N
+    };
+
+    /**
+     * @brief A per-sensor statistic or counter published as its own property.
+     */
+    struct TemperatureStatistic
+    {
+        INDI::PropertyNumber NP{0}; ///< One element per sensor.
+        PublishPolicy publisher;    ///< Publishing policy of NP.
+    };
+    std::array<TemperatureStatistic, STAT_N> tempStatistics; ///< Slope, min, max, mean and count.
+    INDI::PropertyNumber TempHistoryNP{1};                    ///< INDI property for the statistics window.
+
+    // Enumerations for per-sensor error counters.
+    enum
+    {
+        COUNTER_CRC,
+        COUNTER_OPEN,
+        COUNTER_PARSE,
+        COUNTER_RETRIES,
+        COUNTER_N
+    };
+    std::array<TemperatureStatistic, COUNTER_N> tempCounters; ///< Read errors and retries per sensor.
+    INDI::PropertyLight TempHealthLP{0};                      ///< INDI property for per-sensor health.
+
+    // Enumerations for the sensor retry policy.
+    enum
+    {
+        RETRY_BUDGET,
+        RETRY_FAILED_PASSES,
+        RETRY_N
+    };
+    INDI::PropertyNumber TempRetryNP{RETRY_N}; ///< INDI property for the sensor retry policy.
+
+    // Enumerations for temperature acquisition modes.
+    enum
+    {
+        TEMP_ACQ_BULK,
+        TEMP_ACQ_SEQUENTIAL,
+        TEMP_ACQ_N
+    };
+    INDI::PropertySwitch TempAcquisitionSP{TEMP_ACQ_N}; ///< INDI property for the acquisition mode.
+
+    // Enumerations for sensor resolutions, 9 to 12 bits.
+    enum
+    {
+        TEMP_RES_9,
+        TEMP_RES_10,
+        TEMP_RES_11,
+        TEMP_RES_12,
+        TEMP_RES_N
+    };
+    INDI::PropertySwitch TempResolutionSP{TEMP_RES_N}; ///< INDI property for the sensor resolution.
 };
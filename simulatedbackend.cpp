@@ -0,0 +1,176 @@
+#include "simulatedbackend.h"
+#include <algorithm>
+#include <thread>
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+SimulatedBackend::SimulatedBackend(std::chrono::microseconds latency)
+    : latency(latency)
+{
+}
+
+bool SimulatedBackend::open()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    opened = true;
+    return true;
+}
+
+void SimulatedBackend::close()
+{
+    // Like real hardware, pins keep their state after release.
+    std::lock_guard<std::mutex> lock(mutex);
+    opened = false;
+}
+
+std::string SimulatedBackend::describe()
+{
+    return "in-memory, " + std::to_string(latency.count()) + " us per call";
+}
+
+std::string SimulatedBackend::lastError() const
+{
+    return "backend not open";
+}
+
+void SimulatedBackend::delay() const
+{
+    if (latency.count() > 0)
+    {
+        std::this_thread::sleep_for(latency);
+    }
+}
+
+SimulatedBackend::Pin SimulatedBackend::pin(int gpioPin) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = pins.find(gpioPin);
+    return it == pins.end() ? Pin() : it->second;
+}
+
+// ============================================================================
+// Switched Outputs
+// ============================================================================
+
+bool SimulatedBackend::setupOutput(int gpioPin, bool level)
+{
+    delay();
+    std::lock_guard<std::mutex> lock(mutex);
+    Pin &state = pins[gpioPin];
+    state.level = level;
+    state.output = true;
+    state.pwm = false;
+    if (stagger.remove(gpioPin))
+    {
+        updatePhases();
+    }
+    return opened;
+}
+
+bool SimulatedBackend::write(int gpioPin, bool level)
+{
+    delay();
+    std::lock_guard<std::mutex> lock(mutex);
+    Pin &state = pins[gpioPin];
+    state.level = level;
+    state.writes++;
+    return opened && state.output;
+}
+
+bool SimulatedBackend::writeBank(uint32_t setMask, uint32_t clearMask)
+{
+    delay();
+    std::lock_guard<std::mutex> lock(mutex);
+    bool rv = opened;
+    for (int gpioPin = 0; gpioPin < 32; ++gpioPin)
+    {
+        uint32_t bit = uint32_t(1) << gpioPin;
+        if (((setMask | clearMask) & bit) != 0)
+        {
+            Pin &state = pins[gpioPin];
+            state.level = (setMask & bit) != 0;
+            state.writes++;
+            rv = rv && state.output;
+        }
+    }
+    return rv;
+}
+
+bool SimulatedBackend::readOutput(int gpioPin, bool &on)
+{
+    delay();
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = pins.find(gpioPin);
+    on = it != pins.end() && (it->second.output ? it->second.level : it->second.pwm && it->second.dutyCycle > 0);
+    return opened;
+}
+
+// ============================================================================
+// PWM Outputs
+// ============================================================================
+
+bool SimulatedBackend::supportsPWM(int, PWMMode) const
+{
+    return true;
+}
+
+bool SimulatedBackend::setupPWM(int gpioPin, unsigned frequency, PWMMode mode, double dutyCycle)
+{
+    delay();
+    std::lock_guard<std::mutex> lock(mutex);
+    Pin &state = pins[gpioPin];
+    state.dutyCycle = dutyCycle;
+    state.output = false;
+    state.pwm = true;
+    state.mode = mode;
+    state.frequency = frequency;
+
+    if (mode == PWMMode::STAGGERED)
+    {
+        stagger.setPeriod(static_cast<uint32_t>(1000000 / std::max(frequency, 1u)));
+        stagger.setDutyCycle(gpioPin, dutyCycle);
+    }
+    else
+    {
+        stagger.remove(gpioPin);
+    }
+    updatePhases();
+    return opened;
+}
+
+bool SimulatedBackend::writePWM(int gpioPin, double dutyCycle)
+{
+    delay();
+    std::lock_guard<std::mutex> lock(mutex);
+    Pin &state = pins[gpioPin];
+    state.dutyCycle = dutyCycle;
+    state.writes++;
+    if (state.pwm && state.mode == PWMMode::STAGGERED && stagger.setDutyCycle(gpioPin, dutyCycle))
+    {
+        updatePhases();
+    }
+    return opened && state.pwm;
+}
+
+bool SimulatedBackend::cutPWM(int gpioPin)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Pin &state = pins[gpioPin];
+    state.dutyCycle = 0;
+    state.writes++;
+    if (state.pwm && state.mode == PWMMode::STAGGERED && stagger.setDutyCycle(gpioPin, 0))
+    {
+        updatePhases();
+    }
+    return opened && state.pwm;
+}
+
+void SimulatedBackend::updatePhases()
+{
+    for (auto &entry : pins)
+    {
+        entry.second.phase = stagger.offset(entry.first);
+    }
+}
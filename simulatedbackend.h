@@ -0,0 +1,88 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include "gpiobackend.h"
+#include "pwmstagger.h"
+#include <chrono>
+#include <map>
+#include <mutex>
+
+// ============================================================================
+// SimulatedBackend Class
+// ============================================================================
+
+/**
+ * @brief In-memory GPIO backend used in simulation mode.
+ *
+ * Records the state of every output instead of touching hardware, and can
+ * add a fixed latency to each call to stand in for the pigpiod round-trip.
+ * Every PWM mode is available on every pin; staggered pins are planned
+ * like pigpiod would, so their phase offsets can be inspected.
+ */
+class SimulatedBackend : public GPIOBackend
+{
+public:
+    /**
+     * @brief State of a simulated pin.
+     */
+    struct Pin
+    {
+        bool output = false;              ///< Configured as switched output.
+        bool level = false;               ///< Level of a switched output.
+        bool pwm = false;                 ///< Configured as PWM output.
+        PWMMode mode = PWMMode::HARDWARE; ///< PWM mode.
+        unsigned frequency = 0;           ///< PWM frequency in Hz.
+        double dutyCycle = 0;             ///< PWM duty cycle in percent.
+        unsigned phase = 0;               ///< Start of the on-time in microseconds, staggered mode only.
+        unsigned long writes = 0;         ///< Number of writes to the pin.
+    };
+
+    /**
+     * @param latency Delay added to every call.
+     */
+    explicit SimulatedBackend(std::chrono::microseconds latency = std::chrono::microseconds(0));
+
+    const char *name() const override
+    {
+        return "simulated";
+    }
+
+    bool open() override;
+    void close() override;
+    std::string describe() override;
+    std::string lastError() const override;
+
+    bool setupOutput(int pin, bool level) override;
+    bool write(int pin, bool level) override;
+    bool writeBank(uint32_t setMask, uint32_t clearMask) override;
+    bool readOutput(int pin, bool &on) override;
+
+    bool supportsPWM(int pin, PWMMode mode) const override;
+    bool setupPWM(int pin, unsigned frequency, PWMMode mode, double dutyCycle) override;
+    bool writePWM(int pin, double dutyCycle) override;
+    bool cutPWM(int pin) override;
+
+    /**
+     * @brief Returns a copy of a pin's state.
+     */
+    Pin pin(int pin) const;
+
+private:
+    /**
+     * @brief Waits for the configured latency.
+     */
+    void delay() const;
+
+    /**
+     * @brief Copies the staggered phase offsets to the pins; mutex held.
+     */
+    void updatePhases();
+
+    std::chrono::microseconds latency; ///< Delay added to every call.
+    mutable std::mutex mutex;          ///< Guards pins.
+    std::map<int, Pin> pins;           ///< Pin state by GPIO number.
+    PWMStagger stagger;                ///< Plan of the staggered pins.
+    bool opened = false;               ///< Whether open() was called.
+};
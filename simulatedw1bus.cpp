@@ -0,0 +1,206 @@
+#include "simulatedw1bus.h"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+// Interval at which the probe attributes are rewritten.
+const std::chrono::milliseconds UPDATE_INTERVAL(100);
+
+/**
+ * @brief Computes the Dallas/Maxim CRC-8 used by the DS18B20 scratchpad.
+ */
+uint8_t crc8(const uint8_t *data, size_t size)
+{
+    uint8_t crc = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        uint8_t byte = data[i];
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            uint8_t mix = (crc ^ byte) & 0x01;
+            crc >>= 1;
+            if (mix)
+            {
+                crc ^= 0x8C;
+            }
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief Creates a file with the given contents and opens it for rewriting.
+ */
+int createAttribute(const fs::path &path, const char *contents)
+{
+    std::ofstream(path) << contents;
+    return ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+}
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+SimulatedW1Bus::~SimulatedW1Bus()
+{
+    stop();
+}
+
+bool SimulatedW1Bus::start(const Script &newScript)
+{
+    stop();
+    script = newScript;
+
+    char rootTemplate[] = "/tmp/indi_rpi_pb_sim.XXXXXX";
+    if (mkdtemp(rootTemplate) == nullptr)
+    {
+        return false;
+    }
+    root = rootTemplate;
+    devices = root + "/devices";
+
+    // Lay out the bus masters and their probes, then link the probes into
+    // the devices directory the way the w1 subsystem does.
+    std::error_code ec;
+    fs::create_directory(devices, ec);
+    int buses = std::max(script.buses, 1);
+    for (int bus = 0; bus < buses && !ec; ++bus)
+    {
+        fs::path master = fs::path(devices) / ("w1_bus_master" + std::to_string(bus + 1));
+        fs::create_directory(master, ec);
+        std::ofstream(master / "therm_bulk_read") << "0\n";
+    }
+
+    for (int i = 0; i < script.probes && !ec; ++i)
+    {
+        char id[32];
+        std::snprintf(id, sizeof(id), "28-00000000%04x", i + 1);
+        std::string masterName = "w1_bus_master" + std::to_string(i % buses + 1);
+        fs::path directory = fs::path(devices) / masterName / id;
+        fs::create_directory(directory, ec);
+        fs::create_directory_symlink(fs::path(masterName) / id, fs::path(devices) / id, ec);
+
+        Probe probe;
+        probe.slave = createAttribute(directory / "w1_slave", "");
+        probe.temperature = createAttribute(directory / "temperature", "");
+        std::ofstream(directory / "resolution") << "12\n";
+        probes.push_back(probe);
+
+        writeProbe(probe, temperatureAt(i, 0), true);
+    }
+
+    if (ec)
+    {
+        stop();
+        return false;
+    }
+
+    stopRequested = false;
+    thread = std::thread(&SimulatedW1Bus::run, this);
+    return true;
+}
+
+void SimulatedW1Bus::stop()
+{
+    if (thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopRequested = true;
+        }
+        wakeup.notify_all();
+        thread.join();
+    }
+
+    for (const Probe &probe : probes)
+    {
+        ::close(probe.slave);
+        ::close(probe.temperature);
+    }
+    probes.clear();
+
+    if (!root.empty())
+    {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+        root.clear();
+        devices.clear();
+    }
+}
+
+double SimulatedW1Bus::temperatureAt(int probe, double seconds) const
+{
+    // Each probe runs a little warmer than the previous one and lags it in phase.
+    double phase = 2 * M_PI * seconds / std::max(script.swingPeriod, 1.0) + 0.3 * probe;
+    return script.temperature + 0.5 * probe + script.swing * std::sin(phase);
+}
+
+// ============================================================================
+// Updater Thread
+// ============================================================================
+
+void SimulatedW1Bus::run()
+{
+    std::mt19937 random(std::random_device{}());
+    std::uniform_real_distribution<double> uniform(0, 1);
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wakeup.wait_for(lock, UPDATE_INTERVAL, [this]
+                            { return stopRequested; }))
+    {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+        for (size_t i = 0; i < probes.size(); ++i)
+        {
+            writeProbe(probes[i], temperatureAt(static_cast<int>(i), elapsed.count()),
+                       uniform(random) >= script.crcFailureRate);
+        }
+    }
+}
+
+void SimulatedW1Bus::writeProbe(const Probe &probe, double temperature, bool crcValid)
+{
+    // Build the 12-bit scratchpad the way a DS18B20 reports it.
+    int16_t raw = static_cast<int16_t>(std::lround(temperature * 16));
+    uint8_t scratchpad[9] = {static_cast<uint8_t>(raw & 0xff), static_cast<uint8_t>((raw >> 8) & 0xff),
+                             0x4b, 0x46, 0x7f, 0xff, 0x0c, 0x10, 0};
+    scratchpad[8] = crc8(scratchpad, 8);
+    if (!crcValid)
+    {
+        scratchpad[8] ^= 0xff;
+    }
+
+    // Records are fixed-length and rewritten in place, so a reader never
+    // sees a truncated file. The temperature is zero-padded to six places.
+    int millidegrees = static_cast<int>(std::lround(temperature * 1000));
+    char bytes[32];
+    std::snprintf(bytes, sizeof(bytes), "%02x %02x %02x %02x %02x %02x %02x %02x %02x",
+                  scratchpad[0], scratchpad[1], scratchpad[2], scratchpad[3], scratchpad[4],
+                  scratchpad[5], scratchpad[6], scratchpad[7], scratchpad[8]);
+
+    char slave[128];
+    int slaveLength = std::snprintf(slave, sizeof(slave), "%s : crc=%02x %s\n%s t=%06d\n",
+                                    bytes, scratchpad[8], crcValid ? "YES" : "NO ", bytes, millidegrees);
+    ssize_t rv = ::pwrite(probe.slave, slave, slaveLength, 0);
+
+    // The kernel fails temperature reads with EIO on a bad CRC, which a
+    // plain file cannot do; an unparsable record stands in for it.
+    char value[16];
+    int valueLength = crcValid ? std::snprintf(value, sizeof(value), "%06d\n", millidegrees)
+                               : std::snprintf(value, sizeof(value), "CRCERR\n");
+    rv = ::pwrite(probe.temperature, value, valueLength, 0);
+    (void)rv;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// SimulatedW1Bus Class
+// ============================================================================
+
+/**
+ * @brief Generates a fake /sys/bus/w1/devices tree for hardware-free runs.
+ *
+ * The tree mirrors the kernel's layout: every bus master is a directory
+ * with a therm_bulk_read attribute holding its 28-* probes, and the devices
+ * directory links to each probe. Probe attributes (w1_slave, temperature,
+ * resolution) are plain files that an updater thread rewrites in place
+ * with fixed-length records, so descriptors kept open by the sampler stay
+ * valid and always read a complete record.
+ *
+ * Each probe follows a scripted temperature curve and fails its CRC with a
+ * configurable probability.
+ */
+class SimulatedW1Bus
+{
+public:
+    /**
+     * @brief Script followed by the simulated probes.
+     */
+    struct Script
+    {
+        int probes = 2;            ///< Number of probes.
+        int buses = 1;             ///< Number of bus masters the probes are spread over.
+        double temperature = 10;   ///< Mean temperature in degrees Celsius.
+        double swing = 2;          ///< Amplitude of the sinusoidal swing in degrees.
+        double swingPeriod = 600;  ///< Period of the swing in seconds.
+        double crcFailureRate = 0; ///< Probability of a CRC failure per update, 0 to 1.
+    };
+
+    SimulatedW1Bus() = default;
+    ~SimulatedW1Bus();
+
+    SimulatedW1Bus(const SimulatedW1Bus &) = delete;
+    SimulatedW1Bus &operator=(const SimulatedW1Bus &) = delete;
+
+    /**
+     * @brief Creates the tree and starts updating it.
+     *
+     * @param script The probe script.
+     * @return true if the tree was created.
+     */
+    bool start(const Script &script);
+
+    /**
+     * @brief Stops updating and removes the tree.
+     */
+    void stop();
+
+    /**
+     * @brief Returns the directory standing in for /sys/bus/w1/devices.
+     */
+    const std::string &devicesPath() const
+    {
+        return devices;
+    }
+
+    /**
+     * @brief Returns the scripted temperature of a probe at a point in time.
+     *
+     * @param probe The probe index.
+     * @param seconds Seconds since start().
+     */
+    double temperatureAt(int probe, double seconds) const;
+
+private:
+    /**
+     * @brief A probe's attribute files.
+     */
+    struct Probe
+    {
+        int slave = -1;       ///< w1_slave descriptor.
+        int temperature = -1; ///< temperature descriptor.
+    };
+
+    /**
+     * @brief Updater thread main loop.
+     */
+    void run();
+
+    /**
+     * @brief Writes one probe's attributes.
+     *
+     * @param probe The probe to update.
+     * @param temperature The temperature in degrees Celsius.
+     * @param crcValid Whether the record passes its CRC check.
+     */
+    static void writeProbe(const Probe &probe, double temperature, bool crcValid);
+
+    Script script;             ///< The script being followed.
+    std::string root;          ///< Temporary root directory.
+    std::string devices;       ///< Fake devices directory inside root.
+    std::vector<Probe> probes; ///< Open attribute files.
+
+    std::thread thread;             ///< Updater thread.
+    std::mutex mutex;               ///< Guards stopRequested.
+    std::condition_variable wakeup; ///< Interrupts the update interval.
+    bool stopRequested = false;     ///< Set to ask the thread to exit.
+};
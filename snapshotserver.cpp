@@ -0,0 +1,189 @@
+#include "snapshotserver.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+constexpr size_t SnapshotServer::capacity;
+
+SnapshotServer::~SnapshotServer()
+{
+    stop();
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+bool SnapshotServer::start(const std::string &path, std::string &error)
+{
+    stop();
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+    {
+        error = path + ": socket path must be 1 to " + std::to_string(sizeof(address.sun_path) - 1) + " characters";
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+
+    // Replace the socket of an earlier run, but nothing else.
+    struct stat info;
+    if (lstat(path.c_str(), &info) == 0)
+    {
+        if (!S_ISSOCK(info.st_mode))
+        {
+            error = path + ": exists and is not a socket";
+            return false;
+        }
+        ::unlink(path.c_str());
+    }
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        ::chmod(path.c_str(), 0660) != 0 || ::listen(listenFd, 8) != 0 || ::pipe2(wakeFds, O_CLOEXEC) != 0)
+    {
+        error = path + ": " + std::strerror(errno);
+        if (listenFd >= 0)
+        {
+            ::close(listenFd);
+            ::unlink(path.c_str());
+        }
+        listenFd = -1;
+        return false;
+    }
+
+    socketPath = path;
+    served = 0;
+    thread = std::thread(&SnapshotServer::run, this);
+    return true;
+}
+
+void SnapshotServer::stop()
+{
+    if (!thread.joinable())
+    {
+        return;
+    }
+
+    char wake = 0;
+    ssize_t rv = ::write(wakeFds[1], &wake, 1);
+    (void)rv;
+    thread.join();
+
+    ::close(listenFd);
+    ::close(wakeFds[0]);
+    ::close(wakeFds[1]);
+    listenFd = -1;
+    wakeFds[0] = wakeFds[1] = -1;
+    ::unlink(socketPath.c_str());
+}
+
+// ============================================================================
+// Snapshot Slots
+// ============================================================================
+
+bool SnapshotServer::publish(const std::string &snapshot)
+{
+    if (snapshot.size() > capacity)
+    {
+        return false;
+    }
+
+    // Fill the slot readers are not pointed at, then point them at it.
+    unsigned next = 1 - current.load(std::memory_order_relaxed);
+    Slot &slot = slots[next];
+    uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(slot.data, snapshot.data(), snapshot.size());
+    slot.size.store(static_cast<uint32_t>(snapshot.size()), std::memory_order_relaxed);
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    current.store(next, std::memory_order_release);
+    return true;
+}
+
+void SnapshotServer::read(std::vector<char> &snapshot) const
+{
+    // Retry if the writer came back to the slot while it was being copied,
+    // which takes two publishes within one copy.
+    for (;;)
+    {
+        const Slot &slot = slots[current.load(std::memory_order_acquire)];
+        uint32_t before = slot.sequence.load(std::memory_order_acquire);
+        if ((before & 1) != 0)
+        {
+            continue;
+        }
+
+        size_t size = std::min<size_t>(slot.size.load(std::memory_order_relaxed), capacity);
+        snapshot.assign(slot.data, slot.data + size);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before)
+        {
+            return;
+        }
+    }
+}
+
+// ============================================================================
+// Server Thread
+// ============================================================================
+
+void SnapshotServer::run()
+{
+    std::vector<char> snapshot;
+    snapshot.reserve(capacity + 1);
+
+    for (;;)
+    {
+        pollfd fds[2] = {{listenFd, POLLIN, 0}, {wakeFds[0], POLLIN, 0}};
+        if (::poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return;
+        }
+        if (fds[1].revents != 0)
+        {
+            return;
+        }
+
+        int client = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0)
+        {
+            continue;
+        }
+
+        // A client that stops reading is dropped rather than holding up the others.
+        timeval timeout{1, 0};
+        ::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        read(snapshot);
+        snapshot.push_back('\n');
+        size_t sent = 0;
+        while (sent < snapshot.size())
+        {
+            ssize_t rv = ::send(client, snapshot.data() + sent, snapshot.size() - sent, MSG_NOSIGNAL);
+            if (rv < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (rv <= 0)
+            {
+                break;
+            }
+            sent += static_cast<size_t>(rv);
+        }
+        ::close(client);
+        served++;
+    }
+}
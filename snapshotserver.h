@@ -0,0 +1,112 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// SnapshotServer Class
+// ============================================================================
+
+/**
+ * @brief Serves the latest state snapshot to local clients over a Unix domain socket.
+ *
+ * Each client that connects receives the last published snapshot followed
+ * by a newline, and the connection is closed; there is nothing to send.
+ * Clients are served one at a time from a thread of the server's own.
+ *
+ * publish() and the server thread share two snapshot slots without a
+ * lock. The writer fills the slot readers are not pointed at and then
+ * flips them over to it; each slot carries a sequence number that is odd
+ * while it is being written, so a reader that copied a slot the writer
+ * came back to meanwhile notices and copies again. The writer therefore
+ * never waits for a client, however slow.
+ */
+class SnapshotServer
+{
+public:
+    /// Longest snapshot in bytes.
+    static constexpr size_t capacity = 32768;
+
+    SnapshotServer() = default;
+    ~SnapshotServer();
+
+    SnapshotServer(const SnapshotServer &) = delete;
+    SnapshotServer &operator=(const SnapshotServer &) = delete;
+
+    /**
+     * @brief Creates the socket and starts serving; a running server is stopped first.
+     *
+     * A stale socket left at path by an earlier run is replaced.
+     *
+     * @param path Path of the socket; created with mode 0660.
+     * @param error Receives why the socket could not be created.
+     * @return true if the server started.
+     */
+    bool start(const std::string &path, std::string &error);
+
+    /**
+     * @brief Stops serving and removes the socket.
+     */
+    void stop();
+
+    /**
+     * @brief Returns whether the server is running.
+     */
+    bool running() const
+    {
+        return thread.joinable();
+    }
+
+    /**
+     * @brief Replaces the snapshot served to clients. Never blocks.
+     *
+     * Only one thread may publish at a time.
+     *
+     * @return false if the snapshot is longer than capacity; the previous one is kept.
+     */
+    bool publish(const std::string &snapshot);
+
+    /**
+     * @brief Returns the number of clients served since start(). Thread-safe.
+     */
+    uint64_t requests() const
+    {
+        return served;
+    }
+
+private:
+    /**
+     * @brief One copy of the snapshot.
+     */
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence{0}; ///< Odd while the writer fills the slot.
+        std::atomic<uint32_t> size{0};     ///< Length of the snapshot in bytes.
+        char data[capacity];               ///< The snapshot.
+    };
+
+    /**
+     * @brief Server thread main loop.
+     */
+    void run();
+
+    /**
+     * @brief Copies the current snapshot without blocking the writer.
+     */
+    void read(std::vector<char> &snapshot) const;
+
+    std::array<Slot, 2> slots;        ///< The two copies of the snapshot.
+    std::atomic<unsigned> current{0}; ///< Slot readers copy from.
+    std::atomic<uint64_t> served{0};  ///< Clients served.
+    std::string socketPath;           ///< Path of the socket.
+    int listenFd = -1;                ///< Listening socket.
+    int wakeFds[2] = {-1, -1};        ///< Pipe waking the server thread to stop.
+    std::thread thread;               ///< Server thread.
+};
@@ -0,0 +1,211 @@
+#include "supervisedbackend.h"
+#include <algorithm>
+
+constexpr std::chrono::milliseconds SupervisedBackend::minBackoff;
+constexpr std::chrono::milliseconds SupervisedBackend::maxBackoff;
+
+SupervisedBackend::SupervisedBackend(std::unique_ptr<GPIOBackend> backend)
+    : backend(std::move(backend))
+{
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+bool SupervisedBackend::open()
+{
+    shadow.clear();
+    connected = true;
+    backoff = std::chrono::milliseconds(0);
+    nextAttempt = std::chrono::steady_clock::time_point();
+    return backend->open();
+}
+
+void SupervisedBackend::close()
+{
+    backend->close();
+    shadow.clear();
+}
+
+std::string SupervisedBackend::describe()
+{
+    return backend->describe();
+}
+
+std::string SupervisedBackend::lastError() const
+{
+    return connected ? backend->lastError() : error;
+}
+
+bool SupervisedBackend::ping()
+{
+    return settle(connected && backend->ping());
+}
+
+bool SupervisedBackend::connectionLost() const
+{
+    return !connected;
+}
+
+// ============================================================================
+// Switched Outputs
+// ============================================================================
+
+bool SupervisedBackend::setupOutput(int pin, bool level)
+{
+    shadow[pin] = Output{false, level};
+    return settle(connected && backend->setupOutput(pin, level));
+}
+
+bool SupervisedBackend::write(int pin, bool level)
+{
+    shadow[pin].level = level;
+    return settle(connected && backend->write(pin, level));
+}
+
+bool SupervisedBackend::writeBank(uint32_t setMask, uint32_t clearMask)
+{
+    for (int pin = 0; pin < 32; ++pin)
+    {
+        uint32_t bit = uint32_t(1) << pin;
+        if (((setMask | clearMask) & bit) != 0)
+        {
+            shadow[pin].level = (setMask & bit) != 0;
+        }
+    }
+    return settle(connected && backend->writeBank(setMask, clearMask));
+}
+
+bool SupervisedBackend::readOutput(int pin, bool &on)
+{
+    // Not shadowed; while the connection is down the state is unknown.
+    return connected && backend->readOutput(pin, on);
+}
+
+// ============================================================================
+// PWM Outputs
+// ============================================================================
+
+bool SupervisedBackend::supportsPWM(int pin, PWMMode mode) const
+{
+    return backend->supportsPWM(pin, mode);
+}
+
+bool SupervisedBackend::setupPWM(int pin, unsigned frequency, PWMMode mode, double dutyCycle)
+{
+    shadow[pin] = Output{true, false, frequency, mode, dutyCycle};
+    return settle(connected && backend->setupPWM(pin, frequency, mode, dutyCycle));
+}
+
+bool SupervisedBackend::writePWM(int pin, double dutyCycle)
+{
+    auto output = shadow.find(pin);
+    if (output != shadow.end())
+    {
+        output->second.dutyCycle = dutyCycle;
+    }
+    return settle(connected && backend->writePWM(pin, dutyCycle));
+}
+
+bool SupervisedBackend::cutPWM(int pin)
+{
+    return backend->cutPWM(pin);
+}
+
+// ============================================================================
+// Supervision
+// ============================================================================
+
+SupervisedBackend::Status SupervisedBackend::status() const
+{
+    Status result;
+    result.connected = connected;
+    result.replays = replays;
+    result.failedAttempts = failedAttempts;
+    result.lastReconnect = lastReconnect;
+    result.outputs = shadow.size();
+    return result;
+}
+
+bool SupervisedBackend::settle(bool ok)
+{
+    if (ok)
+    {
+        return true;
+    }
+    if (connected && !backend->connectionLost())
+    {
+        // An ordinary failure; the connection is fine.
+        return false;
+    }
+
+    markDown();
+    return reconnect();
+}
+
+bool SupervisedBackend::reconnect()
+{
+    auto now = std::chrono::steady_clock::now();
+    if (now < nextAttempt)
+    {
+        return false;
+    }
+
+    // A replay that lost the connection again counts as a failed attempt.
+    backend->close();
+    bool opened = backend->open();
+    bool restored = opened && replay();
+    if (opened && (restored || !backend->connectionLost()))
+    {
+        connected = true;
+        backoff = std::chrono::milliseconds(0);
+        nextAttempt = std::chrono::steady_clock::time_point();
+        lastReconnect = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - downSince);
+        replays++;
+        return restored;
+    }
+
+    error = "connection lost, reconnecting: " + backend->lastError();
+    failedAttempts++;
+    backoff = backoff.count() == 0 ? minBackoff : std::min(backoff * 2, maxBackoff);
+    nextAttempt = now + backoff;
+    return false;
+}
+
+bool SupervisedBackend::replay()
+{
+    // Latch every switched level in one bank write before any pin is touched
+    // on its own, so rails that dropped come back together.
+    uint32_t setMask = 0;
+    uint32_t clearMask = 0;
+    for (const auto &entry : shadow)
+    {
+        if (!entry.second.pwm && entry.first >= 0 && entry.first < 32)
+        {
+            (entry.second.level ? setMask : clearMask) |= uint32_t(1) << entry.first;
+        }
+    }
+    bool ok = (setMask | clearMask) == 0 || backend->writeBank(setMask, clearMask);
+
+    // Then make sure every pin has its mode back, which the levels no longer change.
+    for (const auto &entry : shadow)
+    {
+        const Output &output = entry.second;
+        ok = (output.pwm ? backend->setupPWM(entry.first, output.frequency, output.mode, output.dutyCycle)
+                         : backend->setupOutput(entry.first, output.level)) &&
+             ok;
+    }
+    return ok;
+}
+
+void SupervisedBackend::markDown()
+{
+    if (connected)
+    {
+        connected = false;
+        error = "connection lost, reconnecting: " + backend->lastError();
+        downSince = std::chrono::steady_clock::now();
+    }
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include "gpiobackend.h"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+
+// ============================================================================
+// SupervisedBackend Class
+// ============================================================================
+
+/**
+ * @brief Forwards to another GPIO backend and reconnects it when its connection drops.
+ *
+ * Every setup and write is first recorded in a shadow copy of the outputs:
+ * mode, level, frequency and duty cycle as last requested. A call failing
+ * with connectionLost(), including the ping() meant as a periodic
+ * heartbeat, marks the connection down and reopens the backend at once.
+ * Once it is open again, the whole shadow is replayed in one go: a single
+ * bank write latches every switched level, then each output is set up
+ * again. The call that noticed the loss is part of the shadow, so it
+ * succeeds if the first attempt does.
+ *
+ * While the connection is down, calls only update the shadow and fail;
+ * each one may retry reopening, at most once per backoff interval, which
+ * doubles with every failed attempt up to maxBackoff.
+ *
+ * cutPWM() is forwarded as is; its state is not shadowed.
+ */
+class SupervisedBackend : public GPIOBackend
+{
+public:
+    /// Wait before the second reconnect attempt; doubles after each failure.
+    static constexpr std::chrono::milliseconds minBackoff{250};
+    /// Longest wait between two reconnect attempts.
+    static constexpr std::chrono::milliseconds maxBackoff{8000};
+
+    /**
+     * @brief State of the connection.
+     */
+    struct Status
+    {
+        bool connected = true;                      ///< Whether the connection is up.
+        uint64_t replays = 0;                       ///< Reconnects that replayed the shadow.
+        uint64_t failedAttempts = 0;                ///< Reconnect attempts that failed.
+        std::chrono::microseconds lastReconnect{0}; ///< Time from noticing the loss to the end of the last replay.
+        size_t outputs = 0;                         ///< Outputs in the shadow.
+    };
+
+    /**
+     * @param backend The backend doing the work.
+     */
+    explicit SupervisedBackend(std::unique_ptr<GPIOBackend> backend);
+
+    const char *name() const override
+    {
+        return backend->name();
+    }
+
+    bool open() override;
+    void close() override;
+    std::string describe() override;
+    std::string lastError() const override;
+
+    /**
+     * @brief Checks the connection, and reconnects a lost one when the backoff allows.
+     */
+    bool ping() override;
+
+    /**
+     * @brief Returns whether the connection is down.
+     */
+    bool connectionLost() const override;
+
+    bool setupOutput(int pin, bool level) override;
+    bool write(int pin, bool level) override;
+    bool writeBank(uint32_t setMask, uint32_t clearMask) override;
+    bool readOutput(int pin, bool &on) override;
+
+    bool supportsPWM(int pin, PWMMode mode) const override;
+    bool setupPWM(int pin, unsigned frequency, PWMMode mode, double dutyCycle) override;
+    bool writePWM(int pin, double dutyCycle) override;
+    bool cutPWM(int pin) override;
+
+    /**
+     * @brief Returns the state of the connection.
+     */
+    Status status() const;
+
+private:
+    /**
+     * @brief Requested state of one output.
+     */
+    struct Output
+    {
+        bool pwm = false;                 ///< Set up with setupPWM() rather than setupOutput().
+        bool level = false;               ///< Level of a switched output.
+        unsigned frequency = 0;           ///< PWM frequency in Hz.
+        PWMMode mode = PWMMode::SOFTWARE; ///< PWM mode.
+        double dutyCycle = 0;             ///< PWM duty cycle in percent.
+    };
+
+    /**
+     * @brief Passes on the outcome of a forwarded call, reconnecting if it lost the connection.
+     *
+     * @param ok The result of the call, false if it was skipped while down;
+     *           the shadow already holds its request.
+     * @return true if the call succeeded, or a reconnect replayed it.
+     */
+    bool settle(bool ok);
+
+    /**
+     * @brief Reopens the backend and replays the shadow, unless still backing off.
+     *
+     * @return true if the connection is up again and every output was restored.
+     */
+    bool reconnect();
+
+    /**
+     * @brief Sets up every output of the shadow again.
+     *
+     * @return true if every output was restored.
+     */
+    bool replay();
+
+    /**
+     * @brief Marks the connection down, keeping the time it was first noticed.
+     */
+    void markDown();
+
+    std::unique_ptr<GPIOBackend> backend;              ///< The backend doing the work.
+    std::map<int, Output> shadow;                      ///< Requested state by pin.
+    bool connected = true;                             ///< Whether the connection is up.
+    std::string error;                                 ///< Why the connection is down.
+    std::chrono::steady_clock::time_point downSince;   ///< When the loss was noticed.
+    std::chrono::steady_clock::time_point nextAttempt; ///< Earliest time of the next reconnect attempt.
+    std::chrono::milliseconds backoff{0};              ///< Wait after the last failed attempt.
+    uint64_t replays = 0;                              ///< Reconnects that replayed the shadow.
+    uint64_t failedAttempts = 0;                       ///< Reconnect attempts that failed.
+    std::chrono::microseconds lastReconnect{0};        ///< Duration of the last reconnect.
+};
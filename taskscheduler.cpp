@@ -0,0 +1,149 @@
+#include "taskscheduler.h"
+#include <algorithm>
+
+TaskScheduler::TaskScheduler()
+{
+    timer.setSingleShot(true);
+    timer.callOnTimeout([this]
+                        { dispatch(); });
+}
+
+int TaskScheduler::add(const std::string &name, std::chrono::milliseconds period, int priority, Callback callback)
+{
+    Task task;
+    task.name = name;
+    task.period = std::max(period, std::chrono::milliseconds(1));
+    task.priority = priority;
+    task.callback = std::move(callback);
+    task.due = std::chrono::steady_clock::now();
+    tasks.push_back(std::move(task));
+    ready.reserve(tasks.size());
+
+    if (running)
+    {
+        arm();
+    }
+    return static_cast<int>(tasks.size()) - 1;
+}
+
+void TaskScheduler::setPeriod(int task, std::chrono::milliseconds period)
+{
+    Task &entry = tasks[task];
+    period = std::max(period, std::chrono::milliseconds(1));
+    if (period == entry.period)
+    {
+        return;
+    }
+    entry.period = period;
+
+    // Waiting out the remainder of a long period would delay a faster rate.
+    auto release = std::chrono::steady_clock::now() + period;
+    if (running && release < entry.due)
+    {
+        entry.due = release;
+        arm();
+    }
+}
+
+void TaskScheduler::start()
+{
+    auto now = std::chrono::steady_clock::now();
+    for (Task &task : tasks)
+    {
+        task.due = now;
+    }
+    resetStats();
+    running = true;
+    arm();
+}
+
+void TaskScheduler::stop()
+{
+    running = false;
+    timer.stop();
+}
+
+void TaskScheduler::resetStats()
+{
+    for (Task &task : tasks)
+    {
+        task.stats = Stats();
+    }
+}
+
+void TaskScheduler::dispatch()
+{
+    if (!running)
+    {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    ready.clear();
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        if (tasks[i].due <= now)
+        {
+            ready.push_back(static_cast<int>(i));
+        }
+    }
+    std::stable_sort(ready.begin(), ready.end(), [this](int a, int b)
+                     { return tasks[a].priority > tasks[b].priority; });
+
+    for (int index : ready)
+    {
+        Task &task = tasks[index];
+        auto begin = std::chrono::steady_clock::now();
+        task.callback();
+        auto end = std::chrono::steady_clock::now();
+
+        // A task may have stopped the scheduler, e.g. by disconnecting.
+        if (!running)
+        {
+            return;
+        }
+
+        Stats &stats = task.stats;
+        auto runtime = std::chrono::duration_cast<std::chrono::microseconds>(end - begin);
+        auto lateness = std::chrono::duration_cast<std::chrono::microseconds>(begin - task.due);
+        stats.runs++;
+        if (latency)
+        {
+            latency->record(end - begin);
+        }
+        stats.lastRuntime = runtime;
+        stats.maxRuntime = std::max(stats.maxRuntime, runtime);
+        stats.maxLateness = std::max(stats.maxLateness, lateness);
+
+        // Skip the releases that passed while the task was waiting or running.
+        auto next = task.due + task.period;
+        if (next <= end)
+        {
+            stats.overruns++;
+            auto missed = (end - next) / task.period + 1;
+            stats.skipped += missed;
+            next += task.period * missed;
+        }
+        task.due = next;
+    }
+
+    arm();
+}
+
+void TaskScheduler::arm()
+{
+    if (tasks.empty())
+    {
+        return;
+    }
+
+    auto due = tasks.front().due;
+    for (const Task &task : tasks)
+    {
+        due = std::min(due, task.due);
+    }
+
+    // Round up, so the timer never fires before the task is due.
+    auto wait = std::chrono::ceil<std::chrono::milliseconds>(due - std::chrono::steady_clock::now());
+    timer.start(static_cast<int>(std::max<long long>(wait.count(), 0)));
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "latencyhistogram.h"
+#include "libindi/inditimer.h"
+
+// ============================================================================
+// TaskScheduler Class
+// ============================================================================
+
+/**
+ * @brief Runs periodic tasks on the INDI event loop, each at its own rate.
+ *
+ * Every task is released once per period and is due at its release time.
+ * One single-shot timer is armed for the earliest due task. Tasks due
+ * together run in order of decreasing priority.
+ *
+ * A task overruns when it completes after its next release. The releases
+ * it missed are skipped rather than run back to back, so a slow task
+ * cannot starve the others. Each task counts its runs, overruns and
+ * skipped releases, and records its longest run time and start latency.
+ */
+class TaskScheduler
+{
+public:
+    using Callback = std::function<void()>;
+
+    /**
+     * @brief Timing of a task since start() or resetStats().
+     */
+    struct Stats
+    {
+        uint64_t runs = 0;                  ///< Completed runs.
+        uint64_t overruns = 0;              ///< Runs that completed after the next release.
+        uint64_t skipped = 0;               ///< Releases dropped because the task was late.
+        std::chrono::microseconds lastRuntime{0}; ///< Duration of the last run.
+        std::chrono::microseconds maxRuntime{0};  ///< Longest run.
+        std::chrono::microseconds maxLateness{0}; ///< Longest delay between release and start.
+    };
+
+    TaskScheduler();
+
+    TaskScheduler(const TaskScheduler &) = delete;
+    TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+    /**
+     * @brief Registers a task.
+     *
+     * @param name Name used in logs.
+     * @param period Interval between two releases.
+     * @param priority Tasks with a higher priority run first when due together.
+     * @param callback The task body.
+     * @return The task index, assigned in registration order.
+     */
+    int add(const std::string &name, std::chrono::milliseconds period, int priority, Callback callback);
+
+    /**
+     * @brief Changes the period of a task.
+     *
+     * A shorter period takes effect at once; a longer one from the next release.
+     */
+    void setPeriod(int task, std::chrono::milliseconds period);
+
+    /**
+     * @brief Returns the period of a task.
+     */
+    std::chrono::milliseconds period(int task) const
+    {
+        return tasks[task].period;
+    }
+
+    /**
+     * @brief Returns the name of a task.
+     */
+    const std::string &name(int task) const
+    {
+        return tasks[task].name;
+    }
+
+    /**
+     * @brief Returns the timing of a task.
+     */
+    const Stats &stats(int task) const
+    {
+        return tasks[task].stats;
+    }
+
+    /**
+     * @brief Returns the number of registered tasks.
+     */
+    size_t size() const
+    {
+        return tasks.size();
+    }
+
+    /**
+     * @brief Releases every task now and starts dispatching.
+     */
+    void start();
+
+    /**
+     * @brief Stops dispatching. Registered tasks are kept.
+     */
+    void stop();
+
+    /**
+     * @brief Clears the timing of every task.
+     */
+    void resetStats();
+
+    /**
+     * @brief Records the run time of every task into a histogram.
+     *
+     * @param histogram The histogram, or null to stop recording. Must outlive the scheduler.
+     */
+    void setLatencyHistogram(LatencyHistogram *histogram)
+    {
+        latency = histogram;
+    }
+
+private:
+    /**
+     * @brief A registered task.
+     */
+    struct Task
+    {
+        std::string name;                          ///< Name used in logs.
+        std::chrono::milliseconds period{0};       ///< Interval between releases.
+        int priority = 0;                          ///< Order among tasks due together.
+        Callback callback;                         ///< The task body.
+        std::chrono::steady_clock::time_point due; ///< Next release.
+        Stats stats;                               ///< Timing since the last reset.
+    };
+
+    /**
+     * @brief Runs every due task, then re-arms the timer.
+     */
+    void dispatch();
+
+    /**
+     * @brief Arms the timer for the earliest due task.
+     */
+    void arm();
+
+    std::vector<Task> tasks;  ///< Registered tasks, by index.
+    std::vector<int> ready;   ///< Scratch list of due tasks.
+    INDI::Timer timer;        ///< Fires at the earliest release.
+    bool running = false;     ///< Whether start() was called without stop().
+    LatencyHistogram *latency = nullptr; ///< Receives the run times, may be null.
+};
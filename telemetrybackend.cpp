@@ -0,0 +1,97 @@
+#include "telemetrybackend.h"
+
+TelemetryBackend::TelemetryBackend(std::unique_ptr<GPIOBackend> backend, TelemetryRecorder &recorder,
+                                   std::map<int, std::string> names)
+    : backend(std::move(backend)), recorder(recorder), names(std::move(names))
+{
+}
+
+bool TelemetryBackend::open()
+{
+    return backend->open();
+}
+
+void TelemetryBackend::close()
+{
+    backend->close();
+}
+
+std::string TelemetryBackend::describe()
+{
+    return backend->describe();
+}
+
+std::string TelemetryBackend::lastError() const
+{
+    return backend->lastError();
+}
+
+bool TelemetryBackend::ping()
+{
+    return backend->ping();
+}
+
+bool TelemetryBackend::connectionLost() const
+{
+    return backend->connectionLost();
+}
+
+bool TelemetryBackend::setupOutput(int pin, bool level)
+{
+    return record(TelemetryKind::SWITCH, pin, level, backend->setupOutput(pin, level));
+}
+
+bool TelemetryBackend::write(int pin, bool level)
+{
+    return record(TelemetryKind::SWITCH, pin, level, backend->write(pin, level));
+}
+
+bool TelemetryBackend::writeBank(uint32_t setMask, uint32_t clearMask)
+{
+    bool rv = backend->writeBank(setMask, clearMask);
+    for (int pin = 0; pin < 32; ++pin)
+    {
+        uint32_t bit = uint32_t(1) << pin;
+        if (((setMask | clearMask) & bit) != 0)
+        {
+            record(TelemetryKind::SWITCH, pin, (setMask & bit) != 0, rv);
+        }
+    }
+    return rv;
+}
+
+bool TelemetryBackend::readOutput(int pin, bool &on)
+{
+    return backend->readOutput(pin, on);
+}
+
+bool TelemetryBackend::supportsPWM(int pin, PWMMode mode) const
+{
+    return backend->supportsPWM(pin, mode);
+}
+
+bool TelemetryBackend::setupPWM(int pin, unsigned frequency, PWMMode mode, double dutyCycle)
+{
+    return record(TelemetryKind::HEATER_DUTY, pin, dutyCycle, backend->setupPWM(pin, frequency, mode, dutyCycle));
+}
+
+bool TelemetryBackend::writePWM(int pin, double dutyCycle)
+{
+    return record(TelemetryKind::HEATER_DUTY, pin, dutyCycle, backend->writePWM(pin, dutyCycle));
+}
+
+bool TelemetryBackend::cutPWM(int pin)
+{
+    // Called from the watchdog thread, which must not wait for the recorder's lock.
+    return backend->cutPWM(pin);
+}
+
+bool TelemetryBackend::record(TelemetryKind kind, int pin, double value, bool ok)
+{
+    if (recorder.running())
+    {
+        auto name = names.find(pin);
+        recorder.record(kind, name != names.end() ? name->second : "GPIO" + std::to_string(pin), value, ok ? 0 : 1);
+    }
+    return ok;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include "gpiobackend.h"
+#include "telemetryrecorder.h"
+#include <map>
+#include <memory>
+#include <string>
+
+// ============================================================================
+// TelemetryBackend Class
+// ============================================================================
+
+/**
+ * @brief Forwards to another GPIO backend and records every output write as telemetry.
+ *
+ * Switched writes are recorded as SWITCH and PWM writes as HEATER_DUTY,
+ * under the channel name of the pin, with detail 1 when the write failed.
+ * Sitting right above the hardware backend, it records what was actually
+ * written, whichever path wrote it. Cuts are not recorded: the watchdog
+ * thread makes them, and the driver records them as WATCHDOG_TRIP.
+ */
+class TelemetryBackend : public GPIOBackend
+{
+public:
+    /**
+     * @param backend The backend doing the work.
+     * @param recorder Receives the records; must outlive this backend.
+     * @param names Channel name by pin; other pins are recorded as GPIO<pin>.
+     */
+    TelemetryBackend(std::unique_ptr<GPIOBackend> backend, TelemetryRecorder &recorder,
+                     std::map<int, std::string> names);
+
+    const char *name() const override
+    {
+        return backend->name();
+    }
+
+    bool open() override;
+    void close() override;
+    std::string describe() override;
+    std::string lastError() const override;
+    bool ping() override;
+    bool connectionLost() const override;
+
+    bool setupOutput(int pin, bool level) override;
+    bool write(int pin, bool level) override;
+    bool writeBank(uint32_t setMask, uint32_t clearMask) override;
+    bool readOutput(int pin, bool &on) override;
+
+    bool supportsPWM(int pin, PWMMode mode) const override;
+    bool setupPWM(int pin, unsigned frequency, PWMMode mode, double dutyCycle) override;
+    bool writePWM(int pin, double dutyCycle) override;
+    bool cutPWM(int pin) override;
+
+private:
+    /**
+     * @brief Records a write and passes its result on.
+     */
+    bool record(TelemetryKind kind, int pin, double value, bool ok);
+
+    std::unique_ptr<GPIOBackend> backend; ///< The backend doing the work.
+    TelemetryRecorder &recorder;          ///< Receives the records.
+    std::map<int, std::string> names;     ///< Channel name by pin.
+};
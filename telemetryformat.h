@@ -0,0 +1,76 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include <cstdint>
+
+// ============================================================================
+// Telemetry File Format
+// ============================================================================
+// A telemetry file starts with one block holding a TelemetryFileHeader,
+// zero-padded. Fixed-size TelemetryRecords follow from the second block on,
+// in native byte order. Every batch is padded with empty records (kind NONE)
+// to a whole block, and a file that was not closed cleanly keeps its
+// preallocated, zeroed tail; readers skip both.
+
+/// Size of a header or batch block in bytes; every write covers whole blocks.
+constexpr uint32_t telemetryBlockSize = 4096;
+
+/// File format version written to the header.
+constexpr uint32_t telemetryVersion = 1;
+
+/**
+ * @brief What a telemetry record describes.
+ */
+enum class TelemetryKind : uint16_t
+{
+    NONE,            ///< Padding; carries nothing.
+    LABEL,           ///< Names a channel in label; sent before its first record.
+    TEMPERATURE,     ///< A good probe reading in degrees Celsius.
+    HEATER_DUTY,     ///< A heater duty cycle written, in percent.
+    HEATER_TARGET,   ///< A closed-loop heater's target in degrees Celsius.
+    SWITCH,          ///< A switched output written, 0 or 1.
+    AIR_TEMPERATURE, ///< The weather station's air temperature in degrees Celsius.
+    HUMIDITY,        ///< The weather station's relative humidity in percent.
+    DEW_POINT,       ///< The dew point in degrees Celsius.
+    WATCHDOG_TRIP,   ///< The watchdog cut a heater; value is its probe reading, detail the TripCause.
+};
+
+/**
+ * @brief First block of a telemetry file.
+ */
+struct TelemetryFileHeader
+{
+    char magic[8];        ///< "RPPBTLM" and a NUL.
+    uint32_t version;     ///< telemetryVersion.
+    uint32_t recordSize;  ///< sizeof(TelemetryRecord).
+    uint32_t blockSize;   ///< telemetryBlockSize; records start at this offset.
+    uint32_t reserved;    ///< Zero.
+    int64_t sessionStart; ///< Start of the session in microseconds since the Unix epoch.
+    char device[64];      ///< INDI device name, NUL-terminated.
+};
+
+/**
+ * @brief One fixed-size telemetry record.
+ */
+struct TelemetryRecord
+{
+    int64_t time;      ///< Microseconds since the Unix epoch.
+    uint32_t sequence; ///< Running number within the session; a gap marks dropped records.
+    uint16_t kind;     ///< A TelemetryKind.
+    uint16_t channel;  ///< Channel, named by an earlier LABEL record with the same number.
+    union
+    {
+        struct
+        {
+            double value;    ///< The measured or written value.
+            uint32_t detail; ///< Kind-specific; 1 for a write that failed, 0 otherwise.
+            uint32_t spare;  ///< Zero.
+        } sample;
+        char label[16]; ///< LABEL records: the channel name, NUL-padded, not always NUL-terminated.
+    };
+};
+
+static_assert(sizeof(TelemetryRecord) == 32, "telemetry records must stay 32 bytes");
+static_assert(telemetryBlockSize % sizeof(TelemetryRecord) == 0, "blocks must hold whole records");
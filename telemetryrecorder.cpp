@@ -0,0 +1,288 @@
+#include "telemetryrecorder.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <filesystem>
+#include <unistd.h>
+
+constexpr size_t TelemetryRecorder::bufferRecords;
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+TelemetryRecorder::TelemetryRecorder()
+    : filling(bufferRecords), flushing(bufferRecords)
+{
+}
+
+TelemetryRecorder::~TelemetryRecorder()
+{
+    stop();
+}
+
+bool TelemetryRecorder::start(const std::string &directory, const std::string &device, uint64_t fileSize,
+                              std::chrono::milliseconds flushInterval, std::string &error)
+{
+    stop();
+
+    // One file per session, named after its start in local time.
+    int64_t sessionStart = now();
+    time_t seconds = static_cast<time_t>(sessionStart / 1000000);
+    struct tm local;
+    localtime_r(&seconds, &local);
+    char name[64];
+    strftime(name, sizeof(name), "rpi_pb_%Y%m%d_%H%M%S.tlm", &local);
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    std::string path = (std::filesystem::path(directory) / name).string();
+
+    int file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (file < 0)
+    {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    // Reserve the whole file up front, rounded to blocks; posix_fallocate
+    // returns the error instead of setting errno.
+    fileSize = std::max<uint64_t>(fileSize / telemetryBlockSize, 2) * telemetryBlockSize;
+    int rv = posix_fallocate(file, 0, static_cast<off_t>(fileSize));
+    if (rv != 0)
+    {
+        error = path + ": " + std::strerror(rv);
+        ::close(file);
+        ::unlink(path.c_str());
+        return false;
+    }
+
+    std::vector<char> block(telemetryBlockSize, 0);
+    TelemetryFileHeader header{};
+    std::memcpy(header.magic, "RPPBTLM", 8);
+    header.version = telemetryVersion;
+    header.recordSize = sizeof(TelemetryRecord);
+    header.blockSize = telemetryBlockSize;
+    header.sessionStart = sessionStart;
+    std::strncpy(header.device, device.c_str(), sizeof(header.device) - 1);
+    std::memcpy(block.data(), &header, sizeof(header));
+    if (pwrite(file, block.data(), block.size(), 0) != static_cast<ssize_t>(block.size()))
+    {
+        error = path + ": " + std::strerror(errno);
+        ::close(file);
+        ::unlink(path.c_str());
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        fd = file;
+        capacity = fileSize;
+        offset = telemetryBlockSize;
+        filePath = path;
+        filled = 0;
+        channels.clear();
+        sequence = 0;
+        counters = Stats();
+        counters.bytes = telemetryBlockSize;
+        stopRequested = false;
+        flushRequested = false;
+    }
+    intervalMs = flushInterval.count();
+    active = true;
+    thread = std::thread(&TelemetryRecorder::run, this);
+    return true;
+}
+
+void TelemetryRecorder::stop()
+{
+    if (!thread.joinable())
+    {
+        return;
+    }
+
+    active = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    wakeup.notify_all();
+    thread.join();
+
+    // Give back the space the session did not use.
+    if (ftruncate(fd, static_cast<off_t>(offset)) == 0)
+    {
+        fdatasync(fd);
+    }
+    ::close(fd);
+    fd = -1;
+}
+
+void TelemetryRecorder::setFlushInterval(std::chrono::milliseconds interval)
+{
+    intervalMs = interval.count();
+    wakeup.notify_all();
+}
+
+std::string TelemetryRecorder::path() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return filePath;
+}
+
+TelemetryRecorder::Stats TelemetryRecorder::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+void TelemetryRecorder::record(TelemetryKind kind, const std::string &source, double value, uint32_t detail)
+{
+    if (!active)
+    {
+        return;
+    }
+
+    TelemetryRecord record{};
+    record.time = now();
+    record.kind = static_cast<uint16_t>(kind);
+    record.sample.value = value;
+    record.sample.detail = detail;
+
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Name a new channel first, so every reader knows it before its data.
+        auto channel = channels.find(source);
+        if (channel == channels.end())
+        {
+            TelemetryRecord label{};
+            label.time = record.time;
+            label.kind = static_cast<uint16_t>(TelemetryKind::LABEL);
+            label.channel = static_cast<uint16_t>(channels.size());
+            source.copy(label.label, sizeof(label.label));
+            if (!append(label))
+            {
+                return;
+            }
+            channel = channels.emplace(source, label.channel).first;
+        }
+
+        record.channel = channel->second;
+        append(record);
+
+        // Flush early rather than drop records in a burst.
+        if (filled >= bufferRecords / 2 && !flushRequested)
+        {
+            flushRequested = true;
+            notify = true;
+        }
+    }
+    if (notify)
+    {
+        wakeup.notify_all();
+    }
+}
+
+bool TelemetryRecorder::append(const TelemetryRecord &record)
+{
+    if (filled == filling.size())
+    {
+        counters.dropped++;
+        return false;
+    }
+
+    filling[filled] = record;
+    filling[filled].sequence = sequence++;
+    filled++;
+    counters.records++;
+    return true;
+}
+
+int64_t TelemetryRecorder::now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+// ============================================================================
+// Flusher Thread
+// ============================================================================
+
+void TelemetryRecorder::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    auto nextFlush = std::chrono::steady_clock::now() + std::chrono::milliseconds(intervalMs.load());
+    bool stopping = false;
+    while (!stopping)
+    {
+        // A shorter interval set meanwhile takes effect at once.
+        wakeup.wait_until(lock, nextFlush, [this, &nextFlush]
+                          {
+                              auto interval = std::chrono::milliseconds(intervalMs.load());
+                              return stopRequested || flushRequested ||
+                                     std::chrono::steady_clock::now() + interval < nextFlush; });
+        stopping = stopRequested;
+        nextFlush = std::chrono::steady_clock::now() + std::chrono::milliseconds(intervalMs.load());
+        flushRequested = false;
+        if (filled == 0)
+        {
+            continue;
+        }
+
+        // Swap the buffers, then write without holding up record().
+        std::swap(filling, flushing);
+        size_t count = filled;
+        filled = 0;
+        uint64_t before = offset;
+
+        lock.unlock();
+        uint64_t lost = writeBatch(flushing, count);
+        lock.lock();
+
+        counters.dropped += lost;
+        counters.flushes++;
+        counters.bytes += offset - before;
+    }
+}
+
+uint64_t TelemetryRecorder::writeBatch(std::vector<TelemetryRecord> &batch, size_t count)
+{
+    // Only whole blocks are written, and only as many as the file has room for.
+    constexpr size_t perBlock = telemetryBlockSize / sizeof(TelemetryRecord);
+    size_t blocks = (count + perBlock - 1) / perBlock;
+    size_t room = static_cast<size_t>((capacity - offset) / telemetryBlockSize);
+    blocks = std::min(blocks, room);
+    size_t written = std::min(count, blocks * perBlock);
+    std::fill(batch.begin() + written, batch.begin() + blocks * perBlock, TelemetryRecord{});
+
+    const char *data = reinterpret_cast<const char *>(batch.data());
+    size_t size = blocks * telemetryBlockSize;
+    size_t done = 0;
+    while (done < size)
+    {
+        ssize_t rv = pwrite(fd, data + done, size - done, static_cast<off_t>(offset + done));
+        if (rv < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (rv <= 0)
+        {
+            break;
+        }
+        done += static_cast<size_t>(rv);
+    }
+
+    // One sync per batch; the preallocated blocks need no metadata update.
+    fdatasync(fd);
+    offset += done;
+    return count - std::min(count, done / sizeof(TelemetryRecord));
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include "telemetryformat.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// TelemetryRecorder Class
+// ============================================================================
+
+/**
+ * @brief Records telemetry into a preallocated file in large block-aligned batches.
+ *
+ * record() copies a fixed-size record into one of two preallocated
+ * buffers under a short lock; it never allocates, except the first time a
+ * channel name appears, and never touches the file. A flusher thread swaps
+ * the buffers every flush interval, or early once the filling one is half
+ * full, and writes the full one in whole 4 KiB blocks followed by a single
+ * fdatasync(). An overnight session thus costs a few large writes per
+ * minute instead of one small write per reading, which spares the SD card.
+ *
+ * Each session gets its own file, preallocated at start() so it neither
+ * fragments nor runs out of space midway, and trimmed to the data at
+ * stop(). Records that find the buffer full, or arrive once the file is
+ * full, are counted as dropped. See telemetryformat.h for the layout.
+ */
+class TelemetryRecorder
+{
+public:
+    /// Records per buffer; 256 KiB each.
+    static constexpr size_t bufferRecords = 8192;
+
+    /**
+     * @brief Counters of the current or last session.
+     */
+    struct Stats
+    {
+        uint64_t records = 0; ///< Records accepted.
+        uint64_t dropped = 0; ///< Records lost to a full buffer or file.
+        uint64_t flushes = 0; ///< Batches written.
+        uint64_t bytes = 0;   ///< Bytes written, header and padding included.
+    };
+
+    TelemetryRecorder();
+    ~TelemetryRecorder();
+
+    TelemetryRecorder(const TelemetryRecorder &) = delete;
+    TelemetryRecorder &operator=(const TelemetryRecorder &) = delete;
+
+    /**
+     * @brief Starts a session in a new file; a running session is stopped first.
+     *
+     * @param directory Directory of the file; created if missing.
+     * @param device INDI device name, stored in the header.
+     * @param fileSize Space to preallocate in bytes; recording stops when it is full.
+     * @param flushInterval Longest time a record waits in memory.
+     * @param error Receives why the file could not be created.
+     * @return true if the session started.
+     */
+    bool start(const std::string &directory, const std::string &device, uint64_t fileSize,
+               std::chrono::milliseconds flushInterval, std::string &error);
+
+    /**
+     * @brief Writes the pending records, trims the file and ends the session.
+     */
+    void stop();
+
+    /**
+     * @brief Sets the flush interval of the running session.
+     */
+    void setFlushInterval(std::chrono::milliseconds interval);
+
+    /**
+     * @brief Returns whether a session is running.
+     */
+    bool running() const
+    {
+        return active;
+    }
+
+    /**
+     * @brief Records a value. Thread-safe; does nothing without a session.
+     *
+     * @param kind What the value describes.
+     * @param source Channel name, e.g. a sensor ID or HEATER_0; at most 16 characters are kept.
+     * @param value The value.
+     * @param detail Kind-specific detail.
+     */
+    void record(TelemetryKind kind, const std::string &source, double value, uint32_t detail = 0);
+
+    /**
+     * @brief Returns the path of the current or last session's file.
+     */
+    std::string path() const;
+
+    /**
+     * @brief Returns the counters of the current or last session.
+     */
+    Stats stats() const;
+
+private:
+    /**
+     * @brief Flusher thread main loop.
+     */
+    void run();
+
+    /**
+     * @brief Appends a record to the filling buffer; the mutex must be held.
+     *
+     * @return false if the buffer was full.
+     */
+    bool append(const TelemetryRecord &record);
+
+    /**
+     * @brief Writes a batch at the end of the file, padded to whole blocks.
+     *
+     * Runs on the flusher thread without the mutex.
+     *
+     * @param batch The buffer to write; its tail is zeroed as padding.
+     * @param count Records in the buffer.
+     * @return The number of records that did not fit in the file.
+     */
+    uint64_t writeBatch(std::vector<TelemetryRecord> &batch, size_t count);
+
+    /**
+     * @brief Returns the current time in microseconds since the Unix epoch.
+     */
+    static int64_t now();
+
+    mutable std::mutex mutex;                 ///< Guards the buffers, channels, counters and requests.
+    std::condition_variable wakeup;           ///< Signals a full buffer or stop request.
+    std::vector<TelemetryRecord> filling;     ///< Buffer record() appends to.
+    std::vector<TelemetryRecord> flushing;    ///< Buffer the flusher writes.
+    size_t filled = 0;                        ///< Records in filling.
+    std::map<std::string, uint16_t> channels; ///< Channel number by name.
+    uint32_t sequence = 0;                    ///< Number of the next record.
+    Stats counters;                           ///< Counters of the session.
+    std::atomic<bool> active{false};          ///< Whether a session is running.
+    bool stopRequested = false;               ///< Set to ask the flusher to exit.
+    bool flushRequested = false;              ///< Set once filling is half full.
+    std::atomic<int64_t> intervalMs{60000};   ///< Flush interval in ms.
+    std::thread thread;                       ///< Flusher thread.
+    int fd = -1;                              ///< Session file, owned by the flusher while running.
+    uint64_t capacity = 0;                    ///< Preallocated file size in bytes.
+    uint64_t offset = 0;                      ///< End of the written data.
+    std::string filePath;                     ///< Path of the session file.
+};
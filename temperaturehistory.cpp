@@ -0,0 +1,157 @@
+#include "temperaturehistory.h"
+
+namespace
+{
+bool keepsBelow(double back, double value)
+{
+    return back < value;
+}
+
+bool keepsAbove(double back, double value)
+{
+    return back > value;
+}
+}
+
+void TemperatureHistory::setCapacity(size_t capacity)
+{
+    samples.assign(capacity, Sample());
+    minima.entries.assign(capacity, 0);
+    maxima.entries.assign(capacity, 0);
+    minima.head = minima.size = 0;
+    maxima.head = maxima.size = 0;
+    first = next = 0;
+    sinceResum = 0;
+    sumT = sumV = sumTT = sumTV = 0;
+}
+
+void TemperatureHistory::setWindow(std::chrono::milliseconds newWindow)
+{
+    window = std::chrono::duration<double>(newWindow).count();
+    while (first != next && at(next - 1).time - at(first).time > window)
+    {
+        popFront();
+    }
+}
+
+void TemperatureHistory::push(std::chrono::steady_clock::time_point time, double value)
+{
+    if (samples.empty())
+    {
+        return;
+    }
+    if (first == next)
+    {
+        origin = time;
+    }
+
+    // Make room, then drop whatever is older than the window.
+    if (next - first == samples.size())
+    {
+        popFront();
+    }
+
+    Sample &sample = samples[next % samples.size()];
+    sample.time = std::chrono::duration<double>(time - origin).count();
+    sample.value = value;
+    pushMonotonic(minima, next, keepsBelow);
+    pushMonotonic(maxima, next, keepsAbove);
+    next++;
+
+    sumT += sample.time;
+    sumV += sample.value;
+    sumTT += sample.time * sample.time;
+    sumTV += sample.time * sample.value;
+
+    while (sample.time - at(first).time > window)
+    {
+        popFront();
+    }
+
+    if (++sinceResum >= samples.size())
+    {
+        resum();
+    }
+}
+
+TemperatureStats TemperatureHistory::stats() const
+{
+    TemperatureStats stats;
+    stats.count = next - first;
+    if (stats.count == 0)
+    {
+        return stats;
+    }
+
+    double n = static_cast<double>(stats.count);
+    stats.mean = sumV / n;
+    stats.minimum = at(minima.entries[minima.head]).value;
+    stats.maximum = at(maxima.entries[maxima.head]).value;
+
+    // Least-squares slope of value over time, scaled to minutes.
+    double denominator = n * sumTT - sumT * sumT;
+    if (stats.count > 1 && denominator > 0)
+    {
+        stats.slope = (n * sumTV - sumT * sumV) / denominator * 60;
+    }
+    return stats;
+}
+
+void TemperatureHistory::popFront()
+{
+    const Sample &sample = at(first);
+    sumT -= sample.time;
+    sumV -= sample.value;
+    sumTT -= sample.time * sample.time;
+    sumTV -= sample.time * sample.value;
+
+    for (MonotonicQueue *queue : {&minima, &maxima})
+    {
+        if (queue->size > 0 && queue->entries[queue->head] == first)
+        {
+            queue->head = (queue->head + 1) % queue->entries.size();
+            queue->size--;
+        }
+    }
+    first++;
+}
+
+void TemperatureHistory::pushMonotonic(MonotonicQueue &queue, size_t sequence, bool (*keepsBack)(double, double))
+{
+    // Entries the new sample dominates can never be the extreme again.
+    double value = at(sequence).value;
+    while (queue.size > 0)
+    {
+        size_t back = (queue.head + queue.size - 1) % queue.entries.size();
+        if (keepsBack(at(queue.entries[back]).value, value))
+        {
+            break;
+        }
+        queue.size--;
+    }
+    queue.entries[(queue.head + queue.size) % queue.entries.size()] = sequence;
+    queue.size++;
+}
+
+void TemperatureHistory::resum()
+{
+    sinceResum = 0;
+    sumT = sumV = sumTT = sumTV = 0;
+    if (first == next)
+    {
+        return;
+    }
+
+    // Keep the times small so the slope's sums do not lose precision.
+    double shift = at(first).time;
+    origin += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(shift));
+    for (size_t i = first; i != next; ++i)
+    {
+        Sample &sample = samples[i % samples.size()];
+        sample.time -= shift;
+        sumT += sample.time;
+        sumV += sample.value;
+        sumTT += sample.time * sample.time;
+        sumTV += sample.time * sample.value;
+    }
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+// ============================================================================
+// TemperatureStats Structure
+// ============================================================================
+
+/**
+ * @brief Statistics over the samples in a history window.
+ */
+struct TemperatureStats
+{
+    size_t count = 0;   ///< Number of samples in the window.
+    double mean = 0;    ///< Mean temperature in degrees Celsius.
+    double minimum = 0; ///< Lowest temperature in degrees Celsius.
+    double maximum = 0; ///< Highest temperature in degrees Celsius.
+    double slope = 0;   ///< Least-squares trend in degrees Celsius per minute.
+};
+
+// ============================================================================
+// TemperatureHistory Class
+// ============================================================================
+
+/**
+ * @brief Sliding window of one sensor's readings with incremental statistics.
+ *
+ * Samples live in a ring buffer allocated once by setCapacity(); the window
+ * drops samples older than its duration, or the oldest sample when the
+ * buffer is full, so memory use never grows.
+ *
+ * Every statistic is updated in O(1) amortized per sample: the mean and the
+ * least-squares slope from running sums, the minimum and maximum from
+ * monotonic queues. The running sums are recomputed from the buffer once per
+ * capacity samples to bound floating-point drift.
+ *
+ * Not thread-safe; owned by the sampler thread.
+ */
+class TemperatureHistory
+{
+public:
+    /**
+     * @brief Allocates the buffer and clears the history.
+     *
+     * @param capacity The largest number of samples kept.
+     */
+    void setCapacity(size_t capacity);
+
+    /**
+     * @brief Sets the window duration, dropping samples that fall out of it.
+     */
+    void setWindow(std::chrono::milliseconds window);
+
+    /**
+     * @brief Adds a sample and drops the ones that left the window.
+     *
+     * @param time The time of the reading.
+     * @param value The temperature in degrees Celsius.
+     */
+    void push(std::chrono::steady_clock::time_point time, double value);
+
+    /**
+     * @brief Returns the statistics of the current window.
+     */
+    TemperatureStats stats() const;
+
+private:
+    /**
+     * @brief A stored reading.
+     */
+    struct Sample
+    {
+        double time = 0;  ///< Seconds since origin.
+        double value = 0; ///< Temperature in degrees Celsius.
+    };
+
+    /**
+     * @brief Indices into samples, kept monotonic in value for min/max queries.
+     *
+     * A ring of at most capacity entries; sequence numbers are stored so
+     * entries stay valid while the sample ring wraps.
+     */
+    struct MonotonicQueue
+    {
+        std::vector<size_t> entries; ///< Sample sequence numbers.
+        size_t head = 0;             ///< Position of the front entry.
+        size_t size = 0;             ///< Number of entries.
+    };
+
+    /**
+     * @brief Drops the oldest sample.
+     */
+    void popFront();
+
+    /**
+     * @brief Returns the sample with a sequence number.
+     */
+    const Sample &at(size_t sequence) const
+    {
+        return samples[sequence % samples.size()];
+    }
+
+    /**
+     * @brief Appends a sample to a monotonic queue.
+     *
+     * @param queue The queue.
+     * @param sequence The sample's sequence number.
+     * @param keepsBack Returns true while the back entry should stay in front of the new sample.
+     */
+    void pushMonotonic(MonotonicQueue &queue, size_t sequence, bool (*keepsBack)(double back, double value));
+
+    /**
+     * @brief Moves the time origin to the oldest sample and recomputes the running sums.
+     */
+    void resum();
+
+    std::vector<Sample> samples; ///< Ring buffer of samples.
+    size_t first = 0;            ///< Sequence number of the oldest sample.
+    size_t next = 0;             ///< Sequence number of the next sample.
+    double window = 600;         ///< Window duration in seconds.
+    size_t sinceResum = 0;       ///< Samples pushed since the last resum().
+
+    std::chrono::steady_clock::time_point origin; ///< Time zero of the sample times; moved by resum().
+
+    double sumT = 0;  ///< Sum of the sample times.
+    double sumV = 0;  ///< Sum of the values.
+    double sumTT = 0; ///< Sum of the squared times.
+    double sumTV = 0; ///< Sum of time times value.
+
+    MonotonicQueue minima; ///< Increasing values; the front is the window minimum.
+    MonotonicQueue maxima; ///< Decreasing values; the front is the window maximum.
+};
@@ -0,0 +1,428 @@
+#include "temperaturesampler.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+
+namespace fs = std::filesystem;
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+TemperatureSampler::~TemperatureSampler()
+{
+    stop();
+}
+
+void TemperatureSampler::start(const std::vector<Sensor> &newSensors, std::chrono::milliseconds newPeriod)
+{
+    stop();
+
+    // A new session starts without history.
+    sensors.clear();
+    histories.clear();
+    build(newSensors);
+    period = newPeriod;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = false;
+        sensorsPending = false;
+        generation = 0;
+        snapshot = TemperatureSnapshot();
+        snapshot.readings.assign(sensors.size(), TemperatureReading());
+        snapshot.stats.assign(sensors.size(), TemperatureStats());
+    }
+
+    thread = std::thread(&TemperatureSampler::run, this);
+}
+
+uint64_t TemperatureSampler::setSensors(const std::vector<Sensor> &newSensors)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    pendingSensors = newSensors;
+    sensorsPending = true;
+    return ++generation;
+}
+
+void TemperatureSampler::build(const std::vector<Sensor> &newSensors)
+{
+    // Keep the histories of sensors that stay.
+    std::map<std::string, TemperatureHistory> kept;
+    for (size_t i = 0; i < sensors.size() && i < histories.size(); ++i)
+    {
+        kept.emplace(sensors[i].id, std::move(histories[i]));
+    }
+
+    sensors = newSensors;
+
+    // Group the sensors by bus master, keeping their relative order.
+    std::map<std::string, size_t> busIndex;
+    buses.clear();
+    probes.clear();
+    histories.clear();
+    histories.resize(sensors.size());
+    for (size_t i = 0; i < sensors.size(); ++i)
+    {
+        // Failures to open are retried on every read.
+        fs::path directory = fs::path(sensors[i].path).parent_path();
+        Probe probe;
+        probe.slave.open(sensors[i].path);
+        probe.temperature.open((directory / "temperature").string());
+        probe.resolutionPath = (directory / "resolution").string();
+        probes.push_back(std::move(probe));
+
+        auto history = kept.find(sensors[i].id);
+        if (history != kept.end())
+        {
+            histories[i] = std::move(history->second);
+        }
+        else
+        {
+            histories[i].setCapacity(historyCapacity);
+        }
+
+        auto it = busIndex.find(sensors[i].master);
+        if (it == busIndex.end())
+        {
+            Bus bus;
+            bus.bulk = supportsBulkRead(sensors[i].master) &&
+                       bus.bulkTrigger.open((fs::path(sensors[i].master) / "therm_bulk_read").string(), true);
+            it = busIndex.emplace(sensors[i].master, buses.size()).first;
+            buses.push_back(std::move(bus));
+        }
+        buses[it->second].members.push_back(i);
+    }
+}
+
+void TemperatureSampler::stop()
+{
+    if (!thread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    wakeup.notify_all();
+    thread.join();
+}
+
+void TemperatureSampler::setRetryPolicy(int retries, int failedPasses)
+{
+    retryBudget = std::max(retries, 0);
+    failedPassLimit = std::max(failedPasses, 1);
+}
+
+void TemperatureSampler::setLatencyHistograms(LatencyHistogram *read, LatencyHistogram *pass)
+{
+    readLatency = read;
+    passLatency = pass;
+}
+
+void TemperatureSampler::setReadingObserver(ReadingObserver observer)
+{
+    readingObserver = std::move(observer);
+}
+
+void TemperatureSampler::setPeriod(std::chrono::milliseconds newPeriod)
+{
+    period = newPeriod;
+}
+
+void TemperatureSampler::setResolution(int bits)
+{
+    requestedResolution = bits;
+}
+
+std::chrono::milliseconds TemperatureSampler::conversionTime(int bits)
+{
+    // Maximum conversion time from the DS18B20 datasheet; halves with every bit dropped.
+    switch (bits)
+    {
+    case 9:
+        return std::chrono::milliseconds(94);
+    case 10:
+        return std::chrono::milliseconds(188);
+    case 11:
+        return std::chrono::milliseconds(375);
+    default:
+        return std::chrono::milliseconds(750);
+    }
+}
+
+void TemperatureSampler::setConversionDelay(std::chrono::milliseconds delay)
+{
+    conversionDelay = delay;
+}
+
+void TemperatureSampler::setHistoryWindow(std::chrono::milliseconds window)
+{
+    historyWindow = window;
+}
+
+void TemperatureSampler::setBulkRead(bool enabled)
+{
+    bulkRead = enabled;
+}
+
+bool TemperatureSampler::supportsBulkRead(const std::string &master)
+{
+    std::error_code ec;
+    return !master.empty() && fs::exists(fs::path(master) / "therm_bulk_read", ec);
+}
+
+bool TemperatureSampler::latest(TemperatureSnapshot &out) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (snapshot.sequence == out.sequence)
+    {
+        return false;
+    }
+    out = snapshot;
+    return true;
+}
+
+// ============================================================================
+// Sampler Thread
+// ============================================================================
+
+void TemperatureSampler::run()
+{
+    std::vector<TemperatureReading> readings(sensors.size());
+    std::vector<TemperatureStats> stats(sensors.size());
+    std::chrono::milliseconds window{};
+    uint64_t sensorGeneration = 0;
+    int resolution = 0;
+    size_t resolutionErrors = 0;
+
+    for (;;)
+    {
+        auto passStart = std::chrono::steady_clock::now();
+
+        // Switch to a new sensor list; the first pass after start() already has it.
+        std::vector<Sensor> newSensors;
+        bool sensorsChanged = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (sensorsPending)
+            {
+                newSensors.swap(pendingSensors);
+                sensorsPending = false;
+                sensorsChanged = true;
+                sensorGeneration = generation;
+            }
+        }
+        if (sensorsChanged)
+        {
+            // Keep the readings and counters of sensors that stay.
+            std::map<std::string, TemperatureReading> kept;
+            for (size_t i = 0; i < sensors.size() && i < readings.size(); ++i)
+            {
+                kept.emplace(sensors[i].id, readings[i]);
+            }
+
+            build(newSensors);
+            readings.assign(sensors.size(), TemperatureReading());
+            for (size_t i = 0; i < sensors.size(); ++i)
+            {
+                auto reading = kept.find(sensors[i].id);
+                if (reading != kept.end())
+                {
+                    readings[i] = reading->second;
+                }
+            }
+            stats.assign(sensors.size(), TemperatureStats());
+            window = std::chrono::milliseconds(-1);
+        }
+
+        // Apply a pending resolution change before the next conversion.
+        int bits = requestedResolution.exchange(0);
+        if (sensorsChanged && bits == 0)
+        {
+            // New probes start at the last applied resolution.
+            bits = resolution;
+        }
+        if (bits != 0)
+        {
+            resolutionErrors = applyResolution(bits);
+            resolution = bits;
+        }
+
+        // Apply a window change to the histories.
+        if (historyWindow.load() != window)
+        {
+            window = historyWindow;
+            for (size_t i = 0; i < histories.size(); ++i)
+            {
+                histories[i].setWindow(window);
+                stats[i] = histories[i].stats();
+            }
+        }
+
+        // Read every bus without holding the lock; each conversion blocks
+        // for the sensors' conversion time. Retries only use what is left
+        // of the period, so one bad probe cannot stall the others for long.
+        auto deadline = passStart + period.load();
+        for (Bus &bus : buses)
+        {
+            bool bulk = bulkRead && bus.bulk;
+            if (bulk && !triggerBulkRead(bus.bulkTrigger))
+            {
+                // The kernel refused the trigger; stop trying on this bus.
+                bus.bulk = bulk = false;
+            }
+            if (bulk)
+            {
+                std::this_thread::sleep_for(conversionDelay.load());
+            }
+
+            for (size_t i : bus.members)
+            {
+                if (readSensor(i, bulk, deadline, readings[i]))
+                {
+                    if (readingObserver)
+                    {
+                        readingObserver(sensors[i].id, readings[i].value, readings[i].lastGood);
+                    }
+                    histories[i].push(readings[i].lastGood, readings[i].value);
+                    stats[i] = histories[i].stats();
+                }
+            }
+        }
+
+        if (passLatency)
+        {
+            passLatency->record(std::chrono::steady_clock::now() - passStart);
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        snapshot.readings = readings;
+        snapshot.stats = stats;
+        snapshot.generation = sensorGeneration;
+        snapshot.resolution = resolution;
+        snapshot.resolutionErrors = resolutionErrors;
+        snapshot.sequence++;
+
+        if (wakeup.wait_until(lock, passStart + period.load(), [this]
+                              { return stopRequested; }))
+        {
+            return;
+        }
+    }
+}
+
+bool TemperatureSampler::readSensor(size_t index, bool bulk, std::chrono::steady_clock::time_point deadline,
+                                    TemperatureReading &reading)
+{
+    int retries = retryBudget;
+    double value = 0;
+    for (int attempt = 0;; ++attempt)
+    {
+        // After a bulk conversion the temperature attribute holds the result;
+        // retries go through w1_slave, which converts again.
+        bool fromBulk = bulk && attempt == 0;
+        if (!fromBulk)
+        {
+            std::this_thread::sleep_for(conversionDelay.load());
+        }
+
+        {
+            LatencyProbe probe(readLatency);
+            reading.status = fromBulk ? readAttribute(probes[index].temperature, parseTemperature, value)
+                                      : readAttribute(probes[index].slave, parseW1Slave, value);
+        }
+        if (reading.status == SensorReadStatus::OK)
+        {
+            reading.value = value;
+            reading.lastGood = std::chrono::steady_clock::now();
+            reading.health = SensorHealth::OK;
+            reading.failedPasses = 0;
+            return true;
+        }
+
+        switch (reading.status)
+        {
+        case SensorReadStatus::OPEN_FAILED:
+            reading.openErrors++;
+            break;
+        case SensorReadStatus::CRC_FAILED:
+            reading.crcErrors++;
+            break;
+        default:
+            reading.parseErrors++;
+            break;
+        }
+
+        if (attempt >= retries || std::chrono::steady_clock::now() >= deadline)
+        {
+            break;
+        }
+        reading.retries++;
+    }
+
+    // Keep the last good value, flagged, until the sensor is declared failed.
+    reading.failedPasses++;
+    bool hasValue = reading.lastGood != std::chrono::steady_clock::time_point();
+    reading.health = hasValue && reading.failedPasses < static_cast<uint32_t>(failedPassLimit.load())
+                         ? SensorHealth::STALE
+                         : SensorHealth::FAILED;
+    return false;
+}
+
+SensorReadStatus TemperatureSampler::readAttribute(W1Attribute &attribute,
+                                                   SensorReadStatus (*parse)(const char *, size_t, double &),
+                                                   double &value)
+{
+    if (!attribute.isOpen() && !attribute.reopen())
+    {
+        return SensorReadStatus::OPEN_FAILED;
+    }
+
+    // w1_slave is about 75 bytes, temperature fewer than 10.
+    char buffer[128];
+    long count = attribute.read(buffer, sizeof(buffer));
+    if (count < 0)
+    {
+        // The kernel fails the read with EIO when the scratchpad CRC does
+        // not match; anything else means the device went away.
+        if (errno == EIO)
+        {
+            return SensorReadStatus::CRC_FAILED;
+        }
+        attribute.close();
+        return SensorReadStatus::OPEN_FAILED;
+    }
+
+    return parse(buffer, static_cast<size_t>(count), value);
+}
+
+bool TemperatureSampler::triggerBulkRead(W1Attribute &trigger)
+{
+    // Returns once the conversion has been started on every probe; reading
+    // a probe's temperature attribute then waits for it to complete.
+    static const char command[] = "trigger\n";
+    return trigger.write(command, sizeof(command) - 1);
+}
+
+size_t TemperatureSampler::applyResolution(int bits)
+{
+    // Resolution changes are rare, so the attributes are not kept open.
+    char text[8];
+    int length = std::snprintf(text, sizeof(text), "%d\n", bits);
+
+    size_t errors = 0;
+    for (const Probe &probe : probes)
+    {
+        W1Attribute resolution;
+        if (!resolution.open(probe.resolutionPath, true) || !resolution.write(text, length))
+        {
+            errors++;
+        }
+    }
+    return errors;
+}
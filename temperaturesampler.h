@@ -0,0 +1,343 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "latencyhistogram.h"
+#include "temperaturehistory.h"
+#include "w1reader.h"
+
+// ============================================================================
+// SENSOR STRUCTURE
+// ============================================================================
+// Structure representing a temperature sensor.
+struct Sensor
+{
+    std::string id;     ///< 1-wire device ID, e.g. 28-0000075a1b2c.
+    std::string path;   ///< Path of the sensor's w1_slave attribute.
+    std::string master; ///< Directory of the bus master the sensor hangs off.
+};
+
+// ============================================================================
+// SAMPLER DATA TYPES
+// ============================================================================
+
+/**
+ * @brief Health of a sensor, derived from its recent reads.
+ */
+enum class SensorHealth
+{
+    OK,     ///< The last pass read the sensor.
+    STALE,  ///< The last pass failed; value holds the previous good reading.
+    FAILED, ///< Too many passes failed in a row, or the sensor never answered.
+};
+
+/**
+ * @brief Latest reading of a single sensor.
+ *
+ * The counters cover the sampler session and are kept across sensor list
+ * changes, like the history.
+ */
+struct TemperatureReading
+{
+    double value = 0;                                   ///< Last good temperature in degrees Celsius.
+    SensorReadStatus status = SensorReadStatus::OK;     ///< Outcome of the last read.
+    SensorHealth health = SensorHealth::FAILED;         ///< Health after the last pass.
+    uint32_t failedPasses = 0;                          ///< Passes in a row without a good read.
+    uint64_t openErrors = 0;                            ///< Reads that could not open the attribute.
+    uint64_t crcErrors = 0;                             ///< Reads rejected by the CRC check.
+    uint64_t parseErrors = 0;                           ///< Reads with an unparseable record.
+    uint64_t retries = 0;                               ///< Reads repeated after a failure.
+    std::chrono::steady_clock::time_point lastGood{};   ///< Time of the last good read.
+};
+
+/**
+ * @brief A complete acquisition pass over all sensors.
+ *
+ * Readings are stored in the same order as the sensor list handed to
+ * TemperatureSampler::start().
+ */
+struct TemperatureSnapshot
+{
+    uint64_t sequence = 0;                    ///< Incremented on every published pass, 0 if none yet.
+    uint64_t generation = 0;                  ///< Sensor list the readings belong to; see setSensors().
+    std::vector<TemperatureReading> readings; ///< One entry per sensor.
+    std::vector<TemperatureStats> stats;      ///< One entry per sensor, over the history window.
+    int resolution = 0;                       ///< Last resolution written to the sensors, 0 if never set.
+    size_t resolutionErrors = 0;              ///< Sensors that refused the last resolution change.
+};
+
+// ============================================================================
+// TemperatureSampler Class
+// ============================================================================
+
+/**
+ * @brief Reads the 1-wire temperature sensors on a dedicated thread.
+ *
+ * Reading a DS18B20 through sysfs blocks for the whole conversion time, so
+ * the sampler owns every sensor read and publishes the result of each pass
+ * as a snapshot. The driver only copies the latest snapshot and never
+ * touches sysfs from the INDI event loop.
+ *
+ * Sensors are grouped by bus master. When bulk reading is enabled and the
+ * kernel supports it, one conversion is started on every probe of a bus at
+ * once through the master's therm_bulk_read attribute and the results are
+ * collected from each probe's temperature attribute, so a pass costs one
+ * conversion period per bus instead of one per sensor. Buses without bulk
+ * support fall back to reading w1_slave sensor by sensor.
+ *
+ * Every attribute is opened once in start() and re-read with pread() into a
+ * fixed buffer, so a pass performs no heap allocation.
+ *
+ * Each sensor is read on its own: a failed read is retried within what is
+ * left of the pass period and only marks that sensor stale or failed, so
+ * one bad cable does not hold back the other readings.
+ *
+ * Valid readings are also appended to a per-sensor TemperatureHistory owned
+ * by the sampler thread, whose statistics are published with the snapshot.
+ */
+class TemperatureSampler
+{
+public:
+    /// Samples kept per sensor; one hour at a one second period.
+    static constexpr size_t historyCapacity = 3600;
+
+    /// Receives each good reading on the sampler thread.
+    using ReadingObserver = std::function<void(const std::string &id, double value,
+                                               std::chrono::steady_clock::time_point time)>;
+
+    TemperatureSampler() = default;
+    ~TemperatureSampler();
+
+    TemperatureSampler(const TemperatureSampler &) = delete;
+    TemperatureSampler &operator=(const TemperatureSampler &) = delete;
+
+    /**
+     * @brief Starts sampling the given sensors.
+     *
+     * Any running sampler thread is stopped first.
+     *
+     * @param sensors The sensors to read, in publishing order.
+     * @param period Interval between the starts of two passes.
+     */
+    void start(const std::vector<Sensor> &sensors, std::chrono::milliseconds period);
+
+    /**
+     * @brief Replaces the sensor list of a running sampler.
+     *
+     * The sampler thread switches to the new list before its next pass.
+     * Sensors present in both lists keep their history; attributes of new
+     * sensors are opened by the sampler thread.
+     *
+     * @param sensors The sensors to read, in publishing order.
+     * @return The generation snapshots carry once they follow the new list.
+     */
+    uint64_t setSensors(const std::vector<Sensor> &sensors);
+
+    /**
+     * @brief Sets how failed reads are retried and when a sensor is declared failed.
+     *
+     * A failed read is repeated through w1_slave, which starts a fresh
+     * conversion, up to retries times per sensor, and only while the pass
+     * is still within its period. A sensor whose reads keep failing is
+     * reported STALE for failedPasses - 1 passes, then FAILED.
+     *
+     * @param retries Repeated reads per sensor and pass, 0 to disable.
+     * @param failedPasses Passes in a row without a good read before a sensor is FAILED.
+     */
+    void setRetryPolicy(int retries, int failedPasses);
+
+    /**
+     * @brief Changes the interval between the starts of two passes.
+     *
+     * A pass that takes longer than the period is followed immediately by the next one.
+     */
+    void setPeriod(std::chrono::milliseconds period);
+
+    /**
+     * @brief Requests a new conversion resolution for every sensor.
+     *
+     * The sysfs resolution attributes are written by the sampler thread
+     * before its next pass; the outcome is reported in the snapshot.
+     *
+     * @param bits Resolution in bits, 9 to 12.
+     */
+    void setResolution(int bits);
+
+    /**
+     * @brief Returns the DS18B20 conversion time for a resolution.
+     *
+     * @param bits Resolution in bits, 9 to 12.
+     */
+    static std::chrono::milliseconds conversionTime(int bits);
+
+    /**
+     * @brief Stops the sampler thread and waits for it to exit.
+     */
+    void stop();
+
+    /**
+     * @brief Copies the latest snapshot if it is newer than the one given.
+     *
+     * @param snapshot In: the last snapshot seen by the caller. Out: the latest snapshot.
+     * @return true if a newer snapshot was copied, false otherwise.
+     */
+    bool latest(TemperatureSnapshot &snapshot) const;
+
+    /**
+     * @brief Enables or disables simultaneous conversions through therm_bulk_read.
+     *
+     * Takes effect on the next pass.
+     */
+    void setBulkRead(bool enabled);
+
+    /**
+     * @brief Adds a delay before every conversion.
+     *
+     * Used in simulation, where the sysfs tree is made of plain files that
+     * answer immediately, to reproduce the timing of real sensors.
+     */
+    void setConversionDelay(std::chrono::milliseconds delay);
+
+    /**
+     * @brief Sets the duration of the history window the statistics cover.
+     *
+     * Takes effect on the next pass. The window is also bounded by
+     * historyCapacity samples.
+     */
+    void setHistoryWindow(std::chrono::milliseconds window);
+
+    /**
+     * @brief Records the duration of every sensor read and of every pass into histograms.
+     *
+     * Must be called before start(). A read includes the wait for a bulk
+     * conversion to complete but not the simulated conversion delay.
+     *
+     * @param read Receives each attribute read, or null.
+     * @param pass Receives each complete pass, or null.
+     */
+    void setLatencyHistograms(LatencyHistogram *read, LatencyHistogram *pass);
+
+    /**
+     * @brief Hands every good reading to a callback as soon as it is read.
+     *
+     * Must be called before start(). The callback runs on the sampler thread
+     * and must not block.
+     */
+    void setReadingObserver(ReadingObserver observer);
+
+    /**
+     * @brief Checks whether a bus master supports simultaneous conversions.
+     *
+     * @param master Directory of the bus master.
+     * @return true if the master exposes a therm_bulk_read attribute.
+     */
+    static bool supportsBulkRead(const std::string &master);
+
+private:
+    /**
+     * @brief sysfs attributes of one sensor.
+     */
+    struct Probe
+    {
+        W1Attribute slave;          ///< w1_slave attribute, read per sensor.
+        W1Attribute temperature;    ///< temperature attribute, read after a bulk conversion.
+        std::string resolutionPath; ///< Path of the resolution attribute.
+    };
+
+    /**
+     * @brief Sensors attached to one bus master.
+     */
+    struct Bus
+    {
+        W1Attribute bulkTrigger;     ///< The master's therm_bulk_read attribute.
+        bool bulk = false;           ///< Whether bulk conversions are used on this bus.
+        std::vector<size_t> members; ///< Indices into sensors.
+    };
+    /**
+     * @brief Opens the attributes of a sensor list and groups it by bus master.
+     *
+     * Histories of sensors that were already sampled are kept.
+     */
+    void build(const std::vector<Sensor> &newSensors);
+
+    /**
+     * @brief Sampler thread main loop.
+     */
+    void run();
+
+    /**
+     * @brief Reads one sensor within the pass deadline and updates its reading.
+     *
+     * @param index The sensor index.
+     * @param bulk Whether a bulk conversion has just been started on its bus.
+     * @param deadline End of the pass period; no retry starts after it.
+     * @param reading The reading to update.
+     * @return true if a good value was read.
+     */
+    bool readSensor(size_t index, bool bulk, std::chrono::steady_clock::time_point deadline,
+                    TemperatureReading &reading);
+
+    /**
+     * @brief Reads and parses one sensor attribute.
+     *
+     * A descriptor that fails is reopened on the next call, so a reseated
+     * probe recovers without restarting the sampler.
+     *
+     * @param attribute The w1_slave or temperature attribute.
+     * @param parse The parser matching the attribute.
+     * @param value Receives the temperature in degrees Celsius.
+     * @return The outcome of the read.
+     */
+    static SensorReadStatus readAttribute(W1Attribute &attribute,
+                                          SensorReadStatus (*parse)(const char *, size_t, double &),
+                                          double &value);
+
+    /**
+     * @brief Starts a simultaneous conversion on every probe of a bus.
+     *
+     * @param trigger The master's therm_bulk_read attribute.
+     * @return true if the kernel accepted the trigger.
+     */
+    static bool triggerBulkRead(W1Attribute &trigger);
+
+    /**
+     * @brief Writes the requested resolution to every sensor.
+     *
+     * @return The number of sensors that refused the change.
+     */
+    size_t applyResolution(int bits);
+
+    std::vector<Sensor> sensors;                              ///< Sensors owned by the sampler thread.
+    std::vector<Probe> probes;                                ///< Attributes of each sensor.
+    std::vector<Bus> buses;                                   ///< Sensors grouped by bus master.
+    std::vector<TemperatureHistory> histories;                ///< History of each sensor.
+    std::atomic<std::chrono::milliseconds> period{};          ///< Interval between pass starts.
+    std::atomic<bool> bulkRead{true};                         ///< Use bulk conversions where supported.
+    std::atomic<int> requestedResolution{0};                  ///< Pending resolution change, 0 if none.
+    std::atomic<std::chrono::milliseconds> conversionDelay{}; ///< Extra delay before each conversion.
+    std::atomic<std::chrono::milliseconds> historyWindow{std::chrono::minutes(10)}; ///< Duration of the history window.
+    LatencyHistogram *readLatency = nullptr;                  ///< Receives sensor read durations, may be null.
+    LatencyHistogram *passLatency = nullptr;                  ///< Receives pass durations, may be null.
+    ReadingObserver readingObserver;                          ///< Receives good readings, may be empty.
+    std::atomic<int> retryBudget{2};                          ///< Repeated reads per sensor and pass.
+    std::atomic<int> failedPassLimit{3};                      ///< Failed passes before a sensor is FAILED.
+
+    std::thread thread;             ///< Sampler thread.
+    mutable std::mutex mutex;       ///< Guards snapshot and stopRequested.
+    std::condition_variable wakeup; ///< Interrupts the pause between passes.
+    bool stopRequested = false;     ///< Set to ask the thread to exit.
+    std::vector<Sensor> pendingSensors; ///< Sensor list waiting for the next pass.
+    bool sensorsPending = false;    ///< Whether pendingSensors holds a new list.
+    uint64_t generation = 0;        ///< Generation of the last list handed to the sampler.
+    TemperatureSnapshot snapshot;   ///< Latest published snapshot.
+};
@@ -0,0 +1,262 @@
+#include "thermalwatchdog.h"
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+constexpr size_t ThermalWatchdog::maxGuards;
+constexpr int ThermalWatchdog::realtimePriority;
+
+ThermalWatchdog::~ThermalWatchdog()
+{
+    stop();
+    unlockMemory();
+}
+
+bool ThermalWatchdog::start(InterlockBackend &newInterlock, std::chrono::milliseconds period, bool useRealtime,
+                            std::string &error)
+{
+    stop();
+
+    interlock = &newInterlock;
+    checkPeriod = period;
+    realtime = false;
+
+    // Lock the memory before the thread starts, so its stack is locked too.
+    bool ok = true;
+    if (useRealtime && !memoryLocked)
+    {
+        memoryLocked = mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+        if (!memoryLocked)
+        {
+            error = std::string("mlockall: ") + std::strerror(errno);
+            ok = false;
+        }
+    }
+
+    stopRequested = false;
+    thread = std::thread(&ThermalWatchdog::run, this, std::chrono::nanoseconds(period));
+
+    if (useRealtime)
+    {
+        sched_param param{};
+        param.sched_priority = realtimePriority;
+        int rv = pthread_setschedparam(thread.native_handle(), SCHED_FIFO, &param);
+        realtime = rv == 0;
+        if (rv != 0)
+        {
+            error += std::string(error.empty() ? "" : ", ") + "SCHED_FIFO: " + std::strerror(rv);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+void ThermalWatchdog::stop()
+{
+    if (thread.joinable())
+    {
+        stopRequested = true;
+        thread.join();
+    }
+    realtime = false;
+}
+
+void ThermalWatchdog::reset()
+{
+    stop();
+    for (Guard &guard : guards)
+    {
+        guard.cause = TripCause::NONE;
+    }
+    interlock = nullptr;
+    checks = 0;
+    trips = 0;
+    worstReaction = 0;
+    worstWakeup = 0;
+}
+
+void ThermalWatchdog::unlockMemory()
+{
+    if (memoryLocked)
+    {
+        munlockall();
+        memoryLocked = false;
+    }
+}
+
+// ============================================================================
+// Configuration
+// ============================================================================
+
+void ThermalWatchdog::setGuard(size_t slot, int pin, const std::string &probe, double limit)
+{
+    if (slot >= maxGuards)
+    {
+        return;
+    }
+
+    Guard &guard = guards[slot];
+    {
+        std::lock_guard<std::mutex> lock(probesMutex);
+        if (probes[slot] != probe || guard.pin != pin)
+        {
+            // Disarm while the probe changes, so no pass mixes the old and new one.
+            guard.pin = -1;
+            probes[slot] = probe;
+            guard.updated = 0;
+            guard.armed = nanoseconds(std::chrono::steady_clock::now());
+        }
+        guard.limit = limit;
+        guard.pin = probe.empty() ? -1 : pin;
+    }
+}
+
+void ThermalWatchdog::setStaleTimeout(std::chrono::milliseconds timeout)
+{
+    staleTimeout = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+}
+
+void ThermalWatchdog::feed(const std::string &probe, double temperature, std::chrono::steady_clock::time_point time)
+{
+    std::lock_guard<std::mutex> lock(probesMutex);
+    for (size_t i = 0; i < maxGuards; ++i)
+    {
+        if (probes[i] == probe)
+        {
+            // The temperature is stored first, so a pass that sees the time sees the reading.
+            guards[i].temperature = temperature;
+            guards[i].updated = nanoseconds(time);
+        }
+    }
+}
+
+TripCause ThermalWatchdog::cause(size_t slot) const
+{
+    return slot < maxGuards ? guards[slot].cause.load() : TripCause::NONE;
+}
+
+double ThermalWatchdog::temperature(size_t slot) const
+{
+    return slot < maxGuards ? guards[slot].temperature.load() : 0;
+}
+
+void ThermalWatchdog::rearm()
+{
+    clearTrips();
+
+    // A quiet probe gets a full timeout again.
+    for (Guard &guard : guards)
+    {
+        guard.armed = nanoseconds(std::chrono::steady_clock::now());
+    }
+}
+
+void ThermalWatchdog::clearTrips()
+{
+    for (Guard &guard : guards)
+    {
+        if (guard.cause.exchange(TripCause::NONE) != TripCause::NONE && interlock)
+        {
+            interlock->release(guard.pin);
+        }
+    }
+}
+
+ThermalWatchdog::Status ThermalWatchdog::status() const
+{
+    Status result;
+    result.checks = checks;
+    result.trips = trips;
+    result.worstReaction = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::nanoseconds(worstReaction.load()));
+    result.worstWakeup = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::nanoseconds(worstWakeup.load()));
+    result.realtime = realtime;
+    return result;
+}
+
+// ============================================================================
+// Check Thread
+// ============================================================================
+
+void ThermalWatchdog::run(std::chrono::nanoseconds period)
+{
+    // steady_clock is CLOCK_MONOTONIC; sleep to absolute deadlines so the
+    // passes do not drift.
+    int64_t next = nanoseconds(std::chrono::steady_clock::now());
+    while (!stopRequested)
+    {
+        next += period.count();
+        timespec deadline{};
+        deadline.tv_sec = static_cast<time_t>(next / 1000000000);
+        deadline.tv_nsec = static_cast<long>(next % 1000000000);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR)
+        {
+        }
+
+        int64_t now = nanoseconds(std::chrono::steady_clock::now());
+        raise(worstWakeup, now - next);
+
+        for (Guard &guard : guards)
+        {
+            check(guard, now);
+        }
+        checks++;
+
+        // After a long stall, resume from now rather than catching up.
+        if (now - next > period.count())
+        {
+            next = now;
+        }
+    }
+}
+
+void ThermalWatchdog::check(Guard &guard, int64_t now)
+{
+    int pin = guard.pin;
+    if (pin < 0 || guard.cause != TripCause::NONE)
+    {
+        return;
+    }
+
+    // The trigger is the reading above the limit, or the end of the timeout.
+    int64_t updated = guard.updated;
+    int64_t timeout = staleTimeout;
+    int64_t since = updated != 0 ? updated : guard.armed.load();
+    TripCause cause = TripCause::NONE;
+    int64_t trigger = 0;
+    if (updated != 0 && guard.temperature > guard.limit)
+    {
+        cause = TripCause::OVER_TEMP;
+        trigger = updated;
+    }
+    else if (timeout > 0 && now - since > timeout)
+    {
+        cause = TripCause::STALE;
+        trigger = since + timeout;
+    }
+    if (cause == TripCause::NONE)
+    {
+        return;
+    }
+
+    interlock->trip(pin);
+    raise(worstReaction, nanoseconds(std::chrono::steady_clock::now()) - trigger);
+    guard.cause = cause;
+    trips++;
+}
+
+void ThermalWatchdog::raise(std::atomic<int64_t> &maximum, int64_t value)
+{
+    int64_t previous = maximum.load(std::memory_order_relaxed);
+    while (value > previous && !maximum.compare_exchange_weak(previous, value, std::memory_order_relaxed))
+    {
+    }
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include "interlockbackend.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// ============================================================================
+// ThermalWatchdog Class
+// ============================================================================
+
+/**
+ * @brief Why a guard cut its heater.
+ */
+enum class TripCause
+{
+    NONE,      ///< Not tripped.
+    OVER_TEMP, ///< The probe read above the limit.
+    STALE,     ///< The probe gave no reading within the timeout.
+};
+
+/**
+ * @brief Cuts heaters whose probe runs away, from a thread of its own.
+ *
+ * Each guard ties a heater pin to the probe taped to it. The sampler feeds
+ * every good reading through feed(); a dedicated thread wakes every period
+ * on the monotonic clock, compares the latest readings against the limits
+ * and trips the interlock of a heater that is too hot, or whose probe has
+ * gone quiet. It neither waits for the INDI event loop nor for the GPIO
+ * command queue, so the reaction time is bounded by the period, the thread's
+ * wake-up latency and one GPIO call.
+ *
+ * The check loop only reads atomics and performs no allocation. Optionally
+ * it runs under SCHED_FIFO with the process memory locked, so neither other
+ * processes nor page faults delay it.
+ *
+ * A tripped guard stays tripped, with its heater latched off, until
+ * rearm(), also while the thread is stopped and restarted.
+ */
+class ThermalWatchdog
+{
+public:
+    /// Number of guards, one per heater.
+    static constexpr size_t maxGuards = 8;
+
+    /// SCHED_FIFO priority of the check thread in real-time mode.
+    static constexpr int realtimePriority = 80;
+
+    /**
+     * @brief Counters of the running watchdog.
+     */
+    struct Status
+    {
+        uint64_t checks = 0;                        ///< Passes over the guards.
+        uint64_t trips = 0;                         ///< Guards tripped.
+        std::chrono::microseconds worstReaction{0}; ///< Longest time from the trigger to the completed cut.
+        std::chrono::microseconds worstWakeup{0};   ///< Longest delay of a pass behind its schedule.
+        bool realtime = false;                      ///< Whether the thread runs under SCHED_FIFO.
+    };
+
+    ThermalWatchdog() = default;
+    ~ThermalWatchdog();
+
+    ThermalWatchdog(const ThermalWatchdog &) = delete;
+    ThermalWatchdog &operator=(const ThermalWatchdog &) = delete;
+
+    /**
+     * @brief Starts the check thread; a running one is stopped first.
+     *
+     * Trips and counters carry over from an earlier run. In real-time mode
+     * the process memory is locked, if not already, and the thread moved to
+     * SCHED_FIFO; if either is refused, the watchdog still runs, at normal
+     * priority.
+     *
+     * @param interlock Cuts and latches the heaters; must outlive the thread.
+     * @param period Interval between two passes over the guards.
+     * @param realtime Whether to request real-time scheduling.
+     * @param error Receives why real-time scheduling was refused.
+     * @return false if real-time scheduling was requested but refused.
+     */
+    bool start(InterlockBackend &interlock, std::chrono::milliseconds period, bool realtime, std::string &error);
+
+    /**
+     * @brief Stops the check thread.
+     *
+     * Trips keep their heaters latched off until rearm(), and the memory
+     * stays locked until unlockMemory().
+     */
+    void stop();
+
+    /**
+     * @brief Returns whether the check thread is running.
+     */
+    bool running() const
+    {
+        return thread.joinable();
+    }
+
+    /**
+     * @brief Returns the period of the running check thread.
+     */
+    std::chrono::milliseconds period() const
+    {
+        return checkPeriod;
+    }
+
+    /**
+     * @brief Forgets the trips and counters of a stopped watchdog and its interlock.
+     *
+     * No heater is released; for use when the interlock goes away, e.g. on disconnect.
+     */
+    void reset();
+
+    /**
+     * @brief Unlocks the memory locked by a real-time start().
+     *
+     * munlockall() is process-wide: it also undoes memory locks taken by
+     * anything else in the driver process.
+     */
+    void unlockMemory();
+
+    /**
+     * @brief Ties a guard to a heater and its probe.
+     *
+     * A new probe starts without a reading, and its timeout counts from now.
+     *
+     * @param slot The guard, below maxGuards.
+     * @param pin The heater's GPIO pin, -1 to disarm the guard.
+     * @param probe The probe's sensor ID.
+     * @param limit The highest allowed probe temperature in degrees Celsius.
+     */
+    void setGuard(size_t slot, int pin, const std::string &probe, double limit);
+
+    /**
+     * @brief Sets how long a guarded probe may go without a reading.
+     *
+     * @param timeout The timeout, 0 to disable.
+     */
+    void setStaleTimeout(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Records a good reading of a probe. Thread-safe.
+     *
+     * @param probe The sensor ID.
+     * @param temperature The reading in degrees Celsius.
+     * @param time When the reading was taken.
+     */
+    void feed(const std::string &probe, double temperature, std::chrono::steady_clock::time_point time);
+
+    /**
+     * @brief Returns why a guard tripped, NONE if it did not.
+     */
+    TripCause cause(size_t slot) const;
+
+    /**
+     * @brief Returns the last reading of a guard's probe in degrees Celsius.
+     */
+    double temperature(size_t slot) const;
+
+    /**
+     * @brief Clears every trip and lets writes reach the heaters again.
+     */
+    void rearm();
+
+    /**
+     * @brief Returns the counters.
+     */
+    Status status() const;
+
+private:
+    /**
+     * @brief One guarded heater; every field is read by the check thread.
+     */
+    struct Guard
+    {
+        std::atomic<int> pin{-1};                      ///< Heater pin, -1 if disarmed.
+        std::atomic<double> limit{0};                  ///< Highest allowed temperature.
+        std::atomic<double> temperature{0};            ///< Last reading.
+        std::atomic<int64_t> updated{0};               ///< Time of the last reading in ns, 0 if none.
+        std::atomic<int64_t> armed{0};                 ///< Time the probe was assigned in ns.
+        std::atomic<TripCause> cause{TripCause::NONE}; ///< Why the guard tripped.
+    };
+
+    /**
+     * @brief Check thread main loop.
+     */
+    void run(std::chrono::nanoseconds period);
+
+    /**
+     * @brief Trips a guard if its probe is too hot or quiet.
+     *
+     * @param guard The guard.
+     * @param now The time of the pass in ns.
+     */
+    void check(Guard &guard, int64_t now);
+
+    /**
+     * @brief Returns a steady clock time in ns since its epoch.
+     */
+    static int64_t nanoseconds(std::chrono::steady_clock::time_point time)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    }
+
+    /**
+     * @brief Clears every trip and releases its heater.
+     */
+    void clearTrips();
+
+    /**
+     * @brief Raises an atomic maximum.
+     */
+    static void raise(std::atomic<int64_t> &maximum, int64_t value);
+
+    std::array<Guard, maxGuards> guards;       ///< Guards by heater index.
+    mutable std::mutex probesMutex;            ///< Guards probes; not taken by the check thread.
+    std::array<std::string, maxGuards> probes; ///< Sensor ID of each guard's probe.
+    std::atomic<int64_t> staleTimeout{0};      ///< Probe timeout in ns, 0 if disabled.
+    InterlockBackend *interlock = nullptr;     ///< Cuts the heaters while running.
+    std::thread thread;                        ///< Check thread.
+    std::atomic<bool> stopRequested{false};    ///< Set to ask the thread to exit.
+    std::chrono::milliseconds checkPeriod{0};  ///< Period of the check thread.
+    bool memoryLocked = false;                 ///< Whether start() locked the process memory.
+    std::atomic<uint64_t> checks{0};           ///< Passes over the guards.
+    std::atomic<uint64_t> trips{0};            ///< Guards tripped.
+    std::atomic<int64_t> worstReaction{0};     ///< Longest reaction in ns.
+    std::atomic<int64_t> worstWakeup{0};       ///< Longest wake-up delay in ns.
+    std::atomic<bool> realtime{false};         ///< Whether the thread runs under SCHED_FIFO.
+};
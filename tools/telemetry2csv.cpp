@@ -0,0 +1,120 @@
+// ============================================================================
+// Telemetry file to CSV converter
+// ============================================================================
+// Converts a telemetry file written by the driver into CSV on standard
+// output, one line per record, with channel numbers resolved to the names
+// of their LABEL records. Padding and the unused tail of a file that was
+// not closed cleanly are skipped.
+//
+// Usage: indi_rpi_pb_telemetry2csv file.tlm > file.csv
+
+#include "telemetryformat.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <string>
+
+namespace
+{
+/**
+ * @brief Returns the CSV name of a record kind.
+ */
+const char *kindName(uint16_t kind)
+{
+    switch (static_cast<TelemetryKind>(kind))
+    {
+    case TelemetryKind::NONE:
+        return "none";
+    case TelemetryKind::LABEL:
+        return "label";
+    case TelemetryKind::TEMPERATURE:
+        return "temperature";
+    case TelemetryKind::HEATER_DUTY:
+        return "heater_duty";
+    case TelemetryKind::HEATER_TARGET:
+        return "heater_target";
+    case TelemetryKind::SWITCH:
+        return "switch";
+    case TelemetryKind::AIR_TEMPERATURE:
+        return "air_temperature";
+    case TelemetryKind::HUMIDITY:
+        return "humidity";
+    case TelemetryKind::DEW_POINT:
+        return "dew_point";
+    case TelemetryKind::WATCHDOG_TRIP:
+        return "watchdog_trip";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Formats microseconds since the Unix epoch as ISO 8601 UTC.
+ */
+std::string formatTime(int64_t time)
+{
+    std::time_t seconds = static_cast<std::time_t>(time / 1000000);
+    std::tm utc;
+    gmtime_r(&seconds, &utc);
+    char text[48];
+    size_t length = std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S", &utc);
+    std::snprintf(text + length, sizeof(text) - length, ".%06lldZ", static_cast<long long>(time % 1000000));
+    return text;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        std::fprintf(stderr, "Usage: %s file.tlm > file.csv\n", argv[0]);
+        return 2;
+    }
+
+    FILE *file = std::fopen(argv[1], "rb");
+    if (file == nullptr)
+    {
+        std::perror(argv[1]);
+        return 1;
+    }
+
+    TelemetryFileHeader header;
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, "RPPBTLM", 8) != 0 ||
+        header.version != telemetryVersion || header.recordSize != sizeof(TelemetryRecord) ||
+        std::fseek(file, header.blockSize, SEEK_SET) != 0)
+    {
+        std::fprintf(stderr, "%s: not a version %u telemetry file\n", argv[1], telemetryVersion);
+        std::fclose(file);
+        return 1;
+    }
+    header.device[sizeof(header.device) - 1] = '\0';
+    std::fprintf(stderr, "%s: %s, session started %s\n", argv[1], header.device,
+                 formatTime(header.sessionStart).c_str());
+
+    std::printf("time,sequence,kind,channel,value,detail\n");
+    std::map<uint16_t, std::string> channels;
+    TelemetryRecord record;
+    while (std::fread(&record, sizeof(record), 1, file) == 1)
+    {
+        switch (static_cast<TelemetryKind>(record.kind))
+        {
+        case TelemetryKind::NONE:
+            break;
+        case TelemetryKind::LABEL:
+            channels[record.channel] = std::string(record.label, strnlen(record.label, sizeof(record.label)));
+            break;
+        default:
+        {
+            auto channel = channels.find(record.channel);
+            std::printf("%s,%u,%s,%s,%.6g,%u\n", formatTime(record.time).c_str(), record.sequence,
+                        kindName(record.kind),
+                        channel != channels.end() ? channel->second.c_str() : std::to_string(record.channel).c_str(),
+                        record.sample.value, record.sample.detail);
+            break;
+        }
+        }
+    }
+
+    std::fclose(file);
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include "w1reader.h"
+#include <cerrno>
+#include <charconv>
+#include <fcntl.h>
+#include <string_view>
+#include <unistd.h>
+
+// ============================================================================
+// W1Attribute
+// ============================================================================
+
+W1Attribute::~W1Attribute()
+{
+    close();
+}
+
+W1Attribute::W1Attribute(W1Attribute &&other) noexcept
+    : fd(other.fd), writeMode(other.writeMode), attributePath(std::move(other.attributePath))
+{
+    other.fd = -1;
+}
+
+W1Attribute &W1Attribute::operator=(W1Attribute &&other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        fd = other.fd;
+        writeMode = other.writeMode;
+        attributePath = std::move(other.attributePath);
+        other.fd = -1;
+    }
+    return *this;
+}
+
+bool W1Attribute::open(const std::string &path, bool writable)
+{
+    attributePath = path;
+    writeMode = writable;
+    return reopen();
+}
+
+bool W1Attribute::reopen()
+{
+    close();
+    fd = ::open(attributePath.c_str(), (writeMode ? O_WRONLY : O_RDONLY) | O_CLOEXEC);
+    return fd >= 0;
+}
+
+void W1Attribute::close()
+{
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+long W1Attribute::read(char *buffer, size_t size) const
+{
+    if (fd < 0)
+    {
+        errno = EBADF;
+        return -1;
+    }
+
+    ssize_t count;
+    do
+    {
+        count = ::pread(fd, buffer, size, 0);
+    } while (count < 0 && errno == EINTR);
+    return count;
+}
+
+bool W1Attribute::write(const char *data, size_t size) const
+{
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    ssize_t count;
+    do
+    {
+        count = ::pwrite(fd, data, size, 0);
+    } while (count < 0 && errno == EINTR);
+    return count == static_cast<ssize_t>(size);
+}
+
+// ============================================================================
+// Parsers
+// ============================================================================
+
+namespace
+{
+/**
+ * @brief Converts a millidegree integer at the start of text.
+ */
+SensorReadStatus parseMillidegrees(std::string_view text, double &value)
+{
+    int millidegrees = 0;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), millidegrees);
+    if (result.ec != std::errc())
+    {
+        return SensorReadStatus::PARSE_FAILED;
+    }
+
+    value = millidegrees / 1000.0;
+    return SensorReadStatus::OK;
+}
+}
+
+SensorReadStatus parseW1Slave(const char *data, size_t size, double &value)
+{
+    std::string_view text(data, size);
+
+    // Check for valid sensor data on the first line.
+    size_t eol = text.find('\n');
+    std::string_view crcLine = text.substr(0, eol);
+    if (crcLine.find("YES") == std::string_view::npos)
+    {
+        return SensorReadStatus::CRC_FAILED;
+    }
+    if (eol == std::string_view::npos)
+    {
+        return SensorReadStatus::PARSE_FAILED;
+    }
+
+    std::string_view dataLine = text.substr(eol + 1);
+    size_t pos = dataLine.find("t=");
+    if (pos == std::string_view::npos)
+    {
+        return SensorReadStatus::PARSE_FAILED;
+    }
+
+    return parseMillidegrees(dataLine.substr(pos + 2), value);
+}
+
+SensorReadStatus parseTemperature(const char *data, size_t size, double &value)
+{
+    return parseMillidegrees(std::string_view(data, size), value);
+}
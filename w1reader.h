@@ -0,0 +1,131 @@
+#pragma once
+
+// ============================================================================
+// INCLUDES
+// ============================================================================
+#include <cstddef>
+#include <string>
+
+// ============================================================================
+// READ STATUS
+// ============================================================================
+
+/**
+ * @brief Outcome of a single sensor read.
+ */
+enum class SensorReadStatus
+{
+    OK,           ///< Reading is valid.
+    OPEN_FAILED,  ///< The sensor file could not be opened or read.
+    CRC_FAILED,   ///< The kernel reported a CRC mismatch.
+    PARSE_FAILED, ///< The sensor file did not contain a temperature.
+};
+
+// ============================================================================
+// W1Attribute Class
+// ============================================================================
+
+/**
+ * @brief A sysfs attribute kept open for repeated access.
+ *
+ * sysfs regenerates an attribute's contents on every read at offset 0, so
+ * one descriptor per attribute is opened up front and re-read with pread()
+ * instead of reopening the file on each poll. No heap allocation happens
+ * after open().
+ */
+class W1Attribute
+{
+public:
+    W1Attribute() = default;
+    ~W1Attribute();
+
+    W1Attribute(const W1Attribute &) = delete;
+    W1Attribute &operator=(const W1Attribute &) = delete;
+    W1Attribute(W1Attribute &&other) noexcept;
+    W1Attribute &operator=(W1Attribute &&other) noexcept;
+
+    /**
+     * @brief Opens the attribute, closing any previously opened one.
+     *
+     * @param path Path of the attribute; kept for reopen().
+     * @param writable Open for writing instead of reading.
+     * @return true if the attribute was opened.
+     */
+    bool open(const std::string &path, bool writable = false);
+
+    /**
+     * @brief Reopens the attribute at its last path.
+     *
+     * @return true if the attribute was opened.
+     */
+    bool reopen();
+
+    /**
+     * @brief Closes the descriptor.
+     */
+    void close();
+
+    /**
+     * @brief Returns whether the descriptor is open.
+     */
+    bool isOpen() const
+    {
+        return fd >= 0;
+    }
+
+    /**
+     * @brief Returns the attribute path.
+     */
+    const std::string &path() const
+    {
+        return attributePath;
+    }
+
+    /**
+     * @brief Reads the attribute from offset 0.
+     *
+     * @param buffer Receives the contents.
+     * @param size Capacity of the buffer.
+     * @return The number of bytes read, or -1 with errno set.
+     */
+    long read(char *buffer, size_t size) const;
+
+    /**
+     * @brief Writes to the attribute at offset 0.
+     *
+     * @return true if every byte was accepted.
+     */
+    bool write(const char *data, size_t size) const;
+
+private:
+    int fd = -1;               ///< Open descriptor, -1 if closed.
+    bool writeMode = false;    ///< Whether the descriptor was opened for writing.
+    std::string attributePath; ///< Path the descriptor was opened from.
+};
+
+// ============================================================================
+// Parsers
+// ============================================================================
+
+/**
+ * @brief Parses the contents of a w1_slave attribute.
+ *
+ * The first line ends with the CRC verdict ("YES" or "NO"), the second
+ * line carries the temperature as "t=<millidegrees>".
+ *
+ * @param data Attribute contents; need not be NUL-terminated.
+ * @param size Number of bytes in data.
+ * @param value Receives the temperature in degrees Celsius.
+ * @return The outcome of the parse.
+ */
+SensorReadStatus parseW1Slave(const char *data, size_t size, double &value);
+
+/**
+ * @brief Parses the contents of a temperature attribute (millidegrees).
+ *
+ * @param data Attribute contents; need not be NUL-terminated.
+ * @param size Number of bytes in data.
+ * @param value Receives the temperature in degrees Celsius.
+ * @return The outcome of the parse.
+ */
+SensorReadStatus parseTemperature(const char *data, size_t size, double &value);